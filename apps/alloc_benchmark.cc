@@ -0,0 +1,122 @@
+#include "buffer.hh"
+#include "packet_builder.hh"
+#include "tcp_connection.hh"
+
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <string>
+
+using namespace std;
+
+//! calls to the global operator new, i.e. to the allocator
+static atomic<size_t> allocations{0};
+
+void *operator new(const size_t size) {
+    allocations.fetch_add(1, memory_order_relaxed);
+    if (void *const ret = malloc(size ? size : 1)) {
+        return ret;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { free(ptr); }
+
+void operator delete(void *ptr, size_t) noexcept { free(ptr); }
+
+constexpr unsigned warmup_rounds = 1000;
+constexpr unsigned measured_rounds = 3000;
+
+//! What a segment goes through on its way from one TCPConnection to the other
+enum class Path {
+    Legacy,  //!< headers and payload flattened into a std::string, parsed from a string, writes from strings
+    Pooled   //!< headers built on the stack and the packet "received" into a pooled slab, writes from slabs
+};
+
+//! the segment as the peer's adapter would read it off the wire
+static TCPSegment over_the_wire(const TCPSegment &seg, const Path path) {
+    TCPSegment ret;
+    if (path == Path::Legacy) {
+        ret.parse(seg.serialize().concatenate());
+        return ret;
+    }
+
+    PacketBuilder packet;
+    packet.tcp(seg.header(), seg.payload());
+    const size_t length = packet.headers().size() + packet.payload().size();
+    SlabRef slab = BufferPool::global().get(length);
+    copy(packet.headers().begin(), packet.headers().end(), slab.data());
+    copy(packet.payload().begin(), packet.payload().end(), slab.data() + packet.headers().size());
+    ret.parse(Buffer{move(slab), length});
+    return ret;
+}
+
+static void deliver(TCPConnection &from, TCPConnection &to, const Path path, size_t &count) {
+    while (not from.segments_out().empty()) {
+        to.segment_received(over_the_wire(from.segments_out().front(), path));
+        from.segments_out().pop();
+        count++;
+    }
+}
+
+//! one round trip: x writes what it can, the data segments and the acks are exchanged, y's reader drains the stream
+static void exchange(TCPConnection &x, TCPConnection &y, const Path path, size_t &segments, size_t &acks) {
+    deliver(x, y, path, segments);
+    deliver(y, x, path, acks);
+    y.inbound_stream().pop_output(y.inbound_stream().buffer_size());
+    x.tick(1000);
+    y.tick(1000);
+}
+
+static void run(const Path path) {
+    TCPConfig config;
+    TCPConnection x{config}, y{config};
+    x.connect();
+    y.end_input_stream();
+
+    const string data(TCPConfig::DEFAULT_CAPACITY, 'x');
+    size_t segments = 0, acks = 0;
+    size_t start_allocations = 0, start_segments = 0, start_slabs = 0;
+
+    for (unsigned round = 0; round < warmup_rounds + measured_rounds; round++) {
+        if (round == warmup_rounds) {
+            start_allocations = allocations.load();
+            start_segments = segments;
+            start_slabs = BufferPool::global().allocations();
+        }
+
+        const string_view chunk = string_view(data).substr(0, x.remaining_outbound_capacity());
+        if (path == Path::Legacy) {
+            x.write(string(chunk));
+        } else {
+            x.write(Buffer::copy_of(chunk));
+        }
+        exchange(x, y, path, segments, acks);
+    }
+
+    const size_t measured = segments - start_segments;
+    cout << fixed << setprecision(3);
+    cout << setw(7) << (path == Path::Legacy ? "legacy" : "pooled") << ": " << setw(7)
+         << double(allocations.load() - start_allocations) / double(measured)
+         << " allocations per data segment (" << measured << " segments, "
+         << BufferPool::global().allocations() - start_slabs << " new slabs)\n";
+
+    x.end_input_stream();
+    while (x.active() or y.active()) {
+        exchange(x, y, path, segments, acks);
+    }
+}
+
+int main() {
+    try {
+        run(Path::Legacy);
+        run(Path::Pooled);
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -43,7 +43,8 @@ void bidirectional_stream_copy(Socket &socket) {
                         Direction::Out,
                         [&] {
                             const size_t bytes_to_write = min(max_copy_length, _outbound.buffer_size());
-                            const size_t bytes_written = socket.write(_outbound.peek_output(bytes_to_write), false);
+                            const auto [first, second] = _outbound.peek_views(bytes_to_write);
+                            const size_t bytes_written = socket.write({first, second}, false);
                             _outbound.pop_output(bytes_written);
                             if (_outbound.eof()) {
                                 socket.shutdown(SHUT_WR);
@@ -71,7 +72,8 @@ void bidirectional_stream_copy(Socket &socket) {
                         Direction::Out,
                         [&] {
                             const size_t bytes_to_write = min(max_copy_length, _inbound.buffer_size());
-                            const size_t bytes_written = _output.write(_inbound.peek_output(bytes_to_write), false);
+                            const auto [first, second] = _inbound.peek_views(bytes_to_write);
+                            const size_t bytes_written = _output.write({first, second}, false);
                             _inbound.pop_output(bytes_written);
 
                             if (_inbound.eof()) {
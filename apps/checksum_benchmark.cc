@@ -0,0 +1,89 @@
+#include "util.hh"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+
+using namespace std;
+using namespace std::chrono;
+
+//! bytes checksummed per measurement, whatever the payload size
+constexpr size_t total_bytes = size_t{1} << 30;
+
+//! The previous InternetChecksum::add(): one byte at a time, tracking which half of the word it is
+class LegacyChecksum {
+    uint32_t _sum{0};
+    bool _parity{false};
+
+  public:
+    void add(const string_view data) {
+        for (size_t i = 0; i < data.size(); i++) {
+            uint16_t val = uint8_t(data[i]);
+            if (not _parity) {
+                val <<= 8;
+            }
+            _sum += val;
+            _parity = !_parity;
+        }
+    }
+
+    uint16_t value() const {
+        uint32_t ret = _sum;
+        while (ret > 0xffff) {
+            ret = (ret >> 16) + (ret & 0xffff);
+        }
+        return ~ret;
+    }
+};
+
+template <typename ChecksumT>
+void run(const string &name, const string &data, const size_t size) {
+    const size_t rounds = total_bytes / size;
+    uint32_t fold = 0;
+
+    const auto first_time = high_resolution_clock::now();
+    for (size_t i = 0; i < rounds; i++) {
+        ChecksumT check;
+        check.add(string_view(data).substr(i % 64, size));
+        fold += check.value();
+    }
+    const auto final_time = high_resolution_clock::now();
+    const auto duration = duration_cast<nanoseconds>(final_time - first_time).count();
+
+    cout << fixed << setprecision(2);
+    cout << setw(8) << name << setw(8) << size << " B: " << setw(7) << double(rounds * size) / double(duration)
+         << " GB/s (checksum " << fold % 1000 << ")\n";
+}
+
+int main() {
+    try {
+        mt19937 rd{0};
+        string data(65536 + 64, 0);
+        for (auto &c : data) {
+            c = static_cast<char>(rd());
+        }
+
+        for (size_t size = 64; size <= 65536; size *= 4) {
+            run<LegacyChecksum>("legacy", data, size);
+            for (const auto kernel : {InternetChecksum::Kernel::Scalar,
+                                      InternetChecksum::Kernel::SSE2,
+                                      InternetChecksum::Kernel::AVX2}) {
+                if (InternetChecksum::kernel_supported(kernel)) {
+                    InternetChecksum::use_kernel(kernel);
+                    run<InternetChecksum>(InternetChecksum::kernel_name(kernel), data, size);
+                }
+            }
+            cout << "\n";
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -12,11 +12,20 @@ using namespace std::chrono;
 constexpr size_t len = 100 * 1024 * 1024;
 //constexpr size_t len = 10 * 10 * 10;
 
-void move_segments(TCPConnection &x, TCPConnection &y, vector<TCPSegment> &segments, const bool reorder) {
+size_t move_segments(
+    TCPConnection &x, TCPConnection &y, vector<TCPSegment> &segments, const bool reorder, const bool offload = false) {
     while (not x.segments_out().empty()) {
-        segments.emplace_back(move(x.segments_out().front()));
+        if (offload) {
+            // what the adapter does with a large segment: split it into wire-sized ones
+            for (auto &piece : x.segments_out().front().split(TCPConfig::MAX_PAYLOAD_SIZE)) {
+                segments.emplace_back(move(piece));
+            }
+        } else {
+            segments.emplace_back(move(x.segments_out().front()));
+        }
         x.segments_out().pop();
     }
+    const size_t count = segments.size();
     if (reorder) {
         for (auto it = segments.rbegin(); it != segments.rend(); ++it) {
             y.segment_received(move(*it));
@@ -27,10 +36,17 @@ void move_segments(TCPConnection &x, TCPConnection &y, vector<TCPSegment> &segme
         }
     }
     segments.clear();
+    return count;
 }
 
-void main_loop(const bool reorder) {
+void main_loop(const bool reorder,
+               const StreamReassembler::Engine engine = StreamReassembler::Engine::IntervalMap,
+               const bool delayed_ack = false,
+               const bool offload = false) {
     TCPConfig config;
+    config.reassembler_engine = engine;
+    config.delayed_ack = delayed_ack;
+    config.segmentation_offload = offload;
     TCPConnection x{config}, y{config};
 
     string string_to_send(len, 'x');
@@ -44,6 +60,8 @@ void main_loop(const bool reorder) {
 
     bool x_closed = false;
 
+    size_t segments_sent = 0, acks_sent = 0;
+
     string string_received;
     string_received.reserve(len);
 
@@ -67,8 +85,8 @@ void main_loop(const bool reorder) {
 
         // exchange segments between x and y but in reverse order
         vector<TCPSegment> segments;
-        move_segments(x, y, segments, reorder);
-        move_segments(y, x, segments, false);
+        segments_sent += move_segments(x, y, segments, reorder, offload);
+        acks_sent += move_segments(y, x, segments, false);
 
         // read output from y
         const auto available_output = y.inbound_stream().buffer_size();
@@ -97,7 +115,9 @@ void main_loop(const bool reorder) {
 
     cout << fixed << setprecision(2);
     cout << "CPU-limited throughput" << (reorder ? " with reordering: " : "                : ") << gigabits_per_second
-         << " Gbit/s\n";
+         << " Gbit/s, " << setprecision(3) << double(acks_sent) / double(segments_sent) << " acks per segment"
+         << (engine == StreamReassembler::Engine::Bitmap ? " (bitmap reassembler)" : "")
+         << (delayed_ack ? " (delayed acks)" : "") << (offload ? " (segmentation offload)" : "") << "\n";
 
     while (x.active() or y.active()) {
         loop();
@@ -108,6 +128,9 @@ int main() {
     try {
         main_loop(false);
         main_loop(true);
+        main_loop(true, StreamReassembler::Engine::Bitmap);
+        main_loop(false, StreamReassembler::Engine::IntervalMap, true);
+        main_loop(false, StreamReassembler::Engine::IntervalMap, false, true);
     } catch (const exception &e) {
         cerr << e.what() << "\n";
         return EXIT_FAILURE;
@@ -28,6 +28,28 @@ static void show_usage(const char *argv0, const char *msg) {
 
          << "   -t <tmout>      Set rt_timeout to tmout                         " << TCPConfig::TIMEOUT_DFLT << "\n\n"
 
+         << "   -R <min>        Adaptive rt_timeout (RFC 6298), at least <min>  (fixed)\n\n"
+
+         << "   -F              Fast retransmit on 3 duplicate ACKs             (timeout only)\n\n"
+
+         << "   -S              Offer selective acknowledgments (SACK)          (no SACK)\n\n"
+
+         << "   -W              Offer window scaling, for windows over 64 KiB   (no scaling)\n\n"
+
+         << "   -T              Offer timestamps (RTT from every ACK, PAWS)     (no timestamps)\n\n"
+
+         << "   -D <delay>      Delayed ACKs, held back at most <delay> ms      (ACK every segment)\n\n"
+
+         << "   -N              Nagle: coalesce small writes (RFC 896)          (send at once)\n\n"
+
+         << "   -P <rate>       Pace at <rate> bytes/s (0: from cwnd and SRTT)  (no pacing)\n\n"
+
+         << "   -G              Segmentation offload (split at the adapter)     (off)\n"
+         << "   -M              Coalesce in-order segment bursts on receive     (off)\n"
+         << "   -K              Check payload checksums while copying them      (off)\n\n"
+
+         << "   -C <algo>       Congestion control: none, reno, cubic or bbr    none\n\n"
+
          << "   -Lu <loss>      Set uplink loss to <rate> (float in 0..1)       (no loss)\n"
          << "   -Ld <loss>      Set downlink loss to <rate> (float in 0..1)     (no loss)\n\n"
 
@@ -68,6 +90,66 @@ static tuple<TCPConfig, FdAdapterConfig, bool> get_config(int argc, char **argv)
             c_fsm.rt_timeout = strtol(argv[curr + 1], nullptr, 0);
             curr += 2;
 
+        } else if (strncmp("-R", argv[curr], 3) == 0) {
+            check_argc(argc, argv, curr, "ERROR: -R requires one argument.");
+            c_fsm.adaptive_rt_timeout = true;
+            c_fsm.min_rt_timeout = strtol(argv[curr + 1], nullptr, 0);
+            curr += 2;
+
+        } else if (strncmp("-F", argv[curr], 3) == 0) {
+            c_fsm.fast_retransmit = true;
+            curr += 1;
+
+        } else if (strncmp("-S", argv[curr], 3) == 0) {
+            c_fsm.sack = true;
+            curr += 1;
+
+        } else if (strncmp("-W", argv[curr], 3) == 0) {
+            c_fsm.window_scaling = true;
+            curr += 1;
+
+        } else if (strncmp("-T", argv[curr], 3) == 0) {
+            c_fsm.timestamps = true;
+            curr += 1;
+
+        } else if (strncmp("-D", argv[curr], 3) == 0) {
+            check_argc(argc, argv, curr, "ERROR: -D requires one argument.");
+            c_fsm.delayed_ack = true;
+            c_fsm.delayed_ack_timeout = strtol(argv[curr + 1], nullptr, 0);
+            curr += 2;
+
+        } else if (strncmp("-N", argv[curr], 3) == 0) {
+            c_fsm.nagle = true;
+            curr += 1;
+
+        } else if (strncmp("-P", argv[curr], 3) == 0) {
+            check_argc(argc, argv, curr, "ERROR: -P requires one argument.");
+            c_fsm.pacing = true;
+            c_fsm.pacing_rate = strtoull(argv[curr + 1], nullptr, 0);
+            curr += 2;
+
+        } else if (strncmp("-G", argv[curr], 3) == 0) {
+            c_fsm.segmentation_offload = true;
+            curr += 1;
+
+        } else if (strncmp("-M", argv[curr], 3) == 0) {
+            c_fsm.receive_coalescing = true;
+            curr += 1;
+
+        } else if (strncmp("-K", argv[curr], 3) == 0) {
+            c_filt.defer_checksum = true;
+            curr += 1;
+
+        } else if (strncmp("-C", argv[curr], 3) == 0) {
+            check_argc(argc, argv, curr, "ERROR: -C requires one argument.");
+            const auto algorithm = CongestionController::algorithm_from_name(argv[curr + 1]);
+            if (not algorithm.has_value()) {
+                show_usage(argv[0], "ERROR: unknown congestion control algorithm.");
+                exit(1);
+            }
+            c_fsm.congestion_control = algorithm.value();
+            curr += 2;
+
         } else if (strncmp("-Lu", argv[curr], 3) == 0) {
             check_argc(argc, argv, curr, "ERROR: -Lu requires one argument.");
             float lossrate = strtof(argv[curr + 1], nullptr);
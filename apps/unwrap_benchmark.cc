@@ -0,0 +1,99 @@
+#include "wrapping_integers.hh"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+using namespace std::chrono;
+
+constexpr size_t count = 1 << 16;
+constexpr unsigned rounds = 1000;
+
+//! The previous unwrap(): builds three candidates with divisions and picks the closest
+uint64_t legacy_unwrap(WrappingInt32 n, WrappingInt32 isn, uint64_t checkpoint) {
+    uint64_t init_absseqno = n.raw_value() >= isn.raw_value() ? n.raw_value() - isn.raw_value()
+                                                              : n.raw_value() + (1UL << 32) - isn.raw_value();
+    uint64_t n_power = checkpoint / (1UL << 32);
+    uint64_t absseqno0 = init_absseqno + (n_power <= 1 ? n_power : n_power - 1) * (1UL << 32);
+    uint64_t absseqno1 = init_absseqno + n_power * (1UL << 32);
+    uint64_t absseqno2 = init_absseqno + (n_power + 1) * (1UL << 32);
+    uint64_t distance0 = absseqno0 >= checkpoint ? absseqno0 - checkpoint : checkpoint - absseqno0;
+    uint64_t distance1 = absseqno1 >= checkpoint ? absseqno1 - checkpoint : checkpoint - absseqno1;
+    uint64_t distance2 = absseqno2 >= checkpoint ? absseqno2 - checkpoint : checkpoint - absseqno2;
+    return distance0 <= distance1 ? (distance0 <= distance2 ? absseqno0 : absseqno2)
+                                  : (distance1 <= distance2 ? absseqno1 : absseqno2);
+}
+
+template <typename F>
+void run(const char *name, F &&unwrap_all, vector<uint64_t> &out) {
+    const auto first_time = high_resolution_clock::now();
+    for (unsigned i = 0; i < rounds; i++) {
+        unwrap_all(i);
+    }
+    const auto final_time = high_resolution_clock::now();
+    const auto duration = duration_cast<nanoseconds>(final_time - first_time).count();
+
+    // fold the results so the work cannot be optimized away
+    uint64_t sum = 0;
+    for (const auto v : out) {
+        sum += v;
+    }
+    cout << fixed << setprecision(2);
+    cout << name << double(duration) / (double(count) * rounds) << " ns/seqno (checksum " << sum % 1000 << ")\n";
+}
+
+int main() {
+    try {
+        mt19937_64 rd{0};
+        const WrappingInt32 isn{static_cast<uint32_t>(rd())};
+        const uint64_t checkpoint = (uint64_t{7} << 32) + static_cast<uint32_t>(rd());
+
+        // seqnos within a window of the checkpoint, like acknos and segment seqnos
+        vector<WrappingInt32> seqnos;
+        for (size_t i = 0; i < count; i++) {
+            seqnos.push_back(wrap(checkpoint + rd() % (1 << 20) - (1 << 19), isn));
+        }
+
+        vector<uint64_t> expected(count), out(count);
+        for (size_t i = 0; i < count; i++) {
+            expected[i] = legacy_unwrap(seqnos[i], isn, checkpoint);
+        }
+
+        run(
+            "legacy unwrap : ",
+            [&](const unsigned round) {
+                for (size_t i = 0; i < count; i++) {
+                    out[i] = legacy_unwrap(seqnos[i], isn, checkpoint + round);
+                }
+            },
+            out);
+        run(
+            "unwrap        : ",
+            [&](const unsigned round) {
+                for (size_t i = 0; i < count; i++) {
+                    out[i] = unwrap(seqnos[i], isn, checkpoint + round);
+                }
+            },
+            out);
+        run(
+            "unwrap_n      : ",
+            [&](const unsigned round) { unwrap_n(seqnos.data(), count, isn, checkpoint + round, out.data()); },
+            out);
+
+        unwrap_n(seqnos.data(), count, isn, checkpoint, out.data());
+        if (out != expected) {
+            throw runtime_error("unwrap_n disagrees with the legacy unwrap");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
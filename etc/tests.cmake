@@ -6,6 +6,7 @@ add_test(NAME t_wrapping_ints_cmp         COMMAND wrapping_integers_cmp)
 add_test(NAME t_wrapping_ints_unwrap      COMMAND wrapping_integers_unwrap)
 add_test(NAME t_wrapping_ints_wrap        COMMAND wrapping_integers_wrap)
 add_test(NAME t_wrapping_ints_roundtrip   COMMAND wrapping_integers_roundtrip)
+add_test(NAME t_wrapping_ints_unwrap_n    COMMAND wrapping_integers_unwrap_n)
 
 add_test(NAME t_recv_connect         COMMAND recv_connect)
 add_test(NAME t_recv_transmit        COMMAND recv_transmit)
@@ -13,6 +14,7 @@ add_test(NAME t_recv_window          COMMAND recv_window)
 add_test(NAME t_recv_reorder         COMMAND recv_reorder)
 add_test(NAME t_recv_close           COMMAND recv_close)
 add_test(NAME t_recv_special         COMMAND recv_special)
+add_test(NAME t_recv_sack            COMMAND recv_sack)
 
 add_test(NAME t_send_connect         COMMAND send_connect)
 add_test(NAME t_send_transmit        COMMAND send_transmit)
@@ -21,6 +23,19 @@ add_test(NAME t_send_window          COMMAND send_window)
 add_test(NAME t_send_ack             COMMAND send_ack)
 add_test(NAME t_send_close           COMMAND send_close)
 add_test(NAME t_send_extra           COMMAND send_extra)
+add_test(NAME t_send_congestion      COMMAND send_congestion)
+add_test(NAME t_send_rtt             COMMAND send_rtt)
+add_test(NAME t_send_fast_retx       COMMAND send_fast_retx)
+add_test(NAME t_send_sack            COMMAND send_sack)
+add_test(NAME t_send_pacing          COMMAND send_pacing)
+add_test(NAME t_send_offload         COMMAND send_offload)
+add_test(NAME t_recv_coalesce        COMMAND recv_coalesce)
+add_test(NAME t_wire_zero_copy       COMMAND wire_zero_copy)
+add_test(NAME t_internet_checksum    COMMAND internet_checksum)
+add_test(NAME t_recv_checksum_copy   COMMAND recv_checksum_copy)
+add_test(NAME t_net_parser           COMMAND net_parser)
+add_test(NAME t_packet_builder       COMMAND packet_builder)
+add_test(NAME t_buffer_pool          COMMAND buffer_pool)
 
 add_test(NAME t_strm_reassem_single      COMMAND fsm_stream_reassembler_single)
 add_test(NAME t_strm_reassem_seq         COMMAND fsm_stream_reassembler_seq)
@@ -30,12 +45,16 @@ add_test(NAME t_strm_reassem_many        COMMAND fsm_stream_reassembler_many)
 add_test(NAME t_strm_reassem_overlapping COMMAND fsm_stream_reassembler_overlapping)
 add_test(NAME t_strm_reassem_win         COMMAND fsm_stream_reassembler_win)
 add_test(NAME t_strm_reassem_cap         COMMAND fsm_stream_reassembler_cap)
+add_test(NAME t_strm_reassem_bitmap      COMMAND fsm_stream_reassembler_bitmap)
+add_test(NAME t_strm_reassem_budget      COMMAND fsm_stream_reassembler_budget)
 
 add_test(NAME t_byte_stream_construction COMMAND byte_stream_construction)
 add_test(NAME t_byte_stream_one_write    COMMAND byte_stream_one_write)
 add_test(NAME t_byte_stream_two_writes   COMMAND byte_stream_two_writes)
 add_test(NAME t_byte_stream_capacity     COMMAND byte_stream_capacity)
 add_test(NAME t_byte_stream_many_writes  COMMAND byte_stream_many_writes)
+add_test(NAME t_byte_stream_wrap        COMMAND byte_stream_wrap)
+add_test(NAME t_byte_stream_chunked     COMMAND byte_stream_chunked)
 
 add_test(NAME t_webget               COMMAND "${PROJECT_SOURCE_DIR}/tests/webget_t.sh")
 
@@ -56,6 +75,10 @@ add_test(NAME t_connect              COMMAND fsm_connect_relaxed)
 add_test(NAME ec_listen              COMMAND fsm_listen)
 add_test(NAME t_listen               COMMAND fsm_listen_relaxed)
 add_test(NAME t_winsize              COMMAND fsm_winsize)
+add_test(NAME t_winscale             COMMAND fsm_winscale)
+add_test(NAME t_timestamps           COMMAND fsm_timestamps)
+add_test(NAME t_delayed_ack          COMMAND fsm_delayed_ack)
+add_test(NAME t_nagle                COMMAND fsm_nagle)
 add_test(NAME ec_retx                COMMAND fsm_retx)
 add_test(NAME t_retx                 COMMAND fsm_retx_relaxed)
 add_test(NAME t_retx_win             COMMAND fsm_retx_win)
@@ -1,5 +1,8 @@
 #include "byte_stream.hh"
 
+#include <algorithm>
+#include <stdexcept>
+
 // Dummy implementation of a flow-controlled in-memory byte stream.
 
 // For Lab 0, please replace with a real implementation that passes the
@@ -12,35 +15,142 @@ void DUMMY_CODE(Targs &&... /* unused */) {}
 
 using namespace std;
 
-ByteStream::ByteStream(const size_t capacity) : _capacity(capacity) {}
+ByteStream::ByteStream(const size_t capacity, const Mode mode)
+    : _capacity(capacity), _mode(mode), _buffer(mode == Mode::Ring ? capacity : 0, 0) {}
 
-size_t ByteStream::write(const string &data) {
+size_t ByteStream::write(string_view data) {
     //新增处理逻辑：如果error，则禁止写入
     if (input_ended() || error()) {
         return 0;
     }
-    if (remaining_capacity() == 0) {
+    const size_t write_bytes = min(remaining_capacity(), data.length());
+    if (write_bytes == 0) {
+        return 0;
+    }
+    //Chunked模式：不得不拷贝一次，把数据变为一个新的chunk（拷进缓冲池的slab，不再新建字符串）
+    if (_mode == Mode::Chunked) {
+        return write(Buffer::copy_of(data.substr(0, write_bytes)));
+    }
+    //环形缓冲区的写入：先写到_buffer末尾，放不下的部分绕回_buffer开头
+    size_t tail = _head + _size;
+    if (tail >= _capacity) {
+        tail -= _capacity;
+    }
+    const size_t first_part = min(write_bytes, _capacity - tail);
+    data.copy(&_buffer[tail], first_part);
+    data.copy(&_buffer[0], write_bytes - first_part, first_part);
+    _size += write_bytes;
+    _bytes_written += write_bytes;
+    return write_bytes;
+}
+
+size_t ByteStream::stage(string_view data, InternetChecksum &check) {
+    //Chunked模式本来就不拷贝，只需求和
+    if (_mode == Mode::Chunked || input_ended() || error()) {
+        check.add(data);
+        return 0;
+    }
+    //和write一样写到环形缓冲区的空闲空间，但先不计入_size：求和与拷贝在同一遍里完成，放不下的部分只求和
+    const size_t stage_bytes = min(remaining_capacity(), data.length());
+    size_t tail = _head + _size;
+    if (tail >= _capacity) {
+        tail -= _capacity;
+    }
+    const size_t first_part = min(stage_bytes, _capacity - tail);
+    check.add_and_copy(data.substr(0, first_part), &_buffer[tail]);
+    check.add_and_copy(data.substr(first_part, stage_bytes - first_part), &_buffer[0]);
+    check.add(data.substr(stage_bytes));
+    return stage_bytes;
+}
+
+void ByteStream::commit(const size_t len) {
+    if (len > remaining_capacity()) {
+        throw runtime_error("ByteStream::commit: more bytes than were staged");
+    }
+    _size += len;
+    _bytes_written += len;
+}
+
+size_t ByteStream::write(Buffer data) {
+    if (_mode == Mode::Ring) {
+        return write(data.str());
+    }
+    if (input_ended() || error()) {
+        return 0;
+    }
+    const size_t write_bytes = min(remaining_capacity(), data.size());
+    if (write_bytes == 0) {
         return 0;
     }
-    size_t write_bytes = remaining_capacity() < data.length() ? 
-                           remaining_capacity() : data.length();
-    _buffer += data.substr(0, write_bytes);
+    //超出容量的部分直接从尾部丢弃，仍然不需要拷贝
+    data.remove_suffix(data.size() - write_bytes);
+    _chunks.push_back(move(data));
+    _size += write_bytes;
     _bytes_written += write_bytes;
     return write_bytes;
 }
 
+size_t ByteStream::write(string &&data) {
+    if (_mode == Mode::Ring) {
+        return write(string_view(data));
+    }
+    return write(Buffer(move(data)));
+}
+
+//! \param[in] len bytes will be exposed from the output side of the buffer
+pair<string_view, string_view> ByteStream::peek_views(const size_t len) const {
+    if (_mode == Mode::Chunked) {
+        string_view first = _chunks.empty() ? string_view() : _chunks[0].str().substr(0, len);
+        string_view second = _chunks.size() < 2 ? string_view() : _chunks[1].str().substr(0, len - first.size());
+        return {first, second};
+    }
+    const size_t new_len = min(len, _size);
+    const size_t first_part = min(new_len, _capacity - _head);
+    return {string_view(_buffer.data() + _head, first_part), string_view(_buffer.data(), new_len - first_part)};
+}
+
 //! \param[in] len bytes will be copied from the output side of the buffer
 string ByteStream::peek_output(const size_t len) const {
-    size_t new_len = len > _buffer.size() ? _buffer.size() : len;
-    return string(_buffer.begin(), _buffer.begin() + new_len);
+    string ret;
+    if (_mode == Mode::Chunked) {
+        ret.reserve(min(len, _size));
+        for (auto it = _chunks.begin(); it != _chunks.end() && ret.size() < len; ++it) {
+            ret.append(it->str().substr(0, len - ret.size()));
+        }
+        return ret;
+    }
+    const auto [first, second] = peek_views(len);
+    ret.reserve(first.size() + second.size());
+    ret.append(first).append(second);
+    return ret;
 }
 
 //! \param[in] len bytes will be removed from the output side of the buffer
-void ByteStream::pop_output(const size_t len) { 
-    size_t new_len = len > _buffer.size() ? _buffer.size() : len;
+void ByteStream::pop_output(const size_t len) {
+    const size_t new_len = min(len, _size);
     _bytes_read += new_len;
-    _buffer.erase(0, new_len);
- }
+    _size -= new_len;
+    if (_mode == Mode::Chunked) {
+        size_t remaining = new_len;
+        while (remaining > 0) {
+            if (remaining < _chunks.front().size()) {
+                _chunks.front().remove_prefix(remaining);
+                break;
+            }
+            remaining -= _chunks.front().size();
+            _chunks.pop_front();
+        }
+        return;
+    }
+    _head += new_len;
+    if (_head >= _capacity) {
+        _head -= _capacity;
+    }
+    //缓存被读空时把读写位置拉回开头，尽量让后续的读写不发生绕回
+    if (_size == 0) {
+        _head = 0;
+    }
+}
 
 //! Read (i.e., copy and then pop) the next "len" bytes of the stream
 //! \param[in] len bytes will be popped and returned
@@ -54,18 +164,89 @@ std::string ByteStream::read(const size_t len) {
     return read_string;
 }
 
+//! \param[in] len bytes will be popped and returned
+//! \returns a BufferList holding the popped bytes
+BufferList ByteStream::read_buffers(const size_t len) {
+    if (error()) { return {}; }
+    if (_mode == Mode::Ring) {
+        return BufferList(read_contiguous(len));
+    }
+    //Chunked模式：整块的chunk直接转交，最后一块只截取需要的前缀，全程只增加引用计数
+    BufferList ret;
+    size_t remaining = min(len, _size);
+    _bytes_read += remaining;
+    _size -= remaining;
+    while (remaining > 0) {
+        Buffer &front = _chunks.front();
+        if (remaining < front.size()) {
+            Buffer piece = front;
+            piece.remove_suffix(front.size() - remaining);
+            front.remove_prefix(remaining);
+            ret.push_back(move(piece));
+            break;
+        }
+        remaining -= front.size();
+        ret.push_back(move(front));
+        _chunks.pop_front();
+    }
+    return ret;
+}
+
+//! \param[in] len bytes will be popped and returned
+//! \returns a Buffer holding the popped bytes
+Buffer ByteStream::read_contiguous(const size_t len) {
+    const size_t n = min(len, _size);
+    if (error() || n == 0) { return {}; }
+    //Chunked模式：第一个chunk就装得下时直接切片，只增加引用计数
+    if (_mode == Mode::Chunked && _chunks.front().size() >= n) {
+        Buffer ret = _chunks.front();
+        ret.remove_suffix(ret.size() - n);
+        pop_output(n);
+        return ret;
+    }
+    //否则（跨越多个chunk，或者Ring模式）拷贝一份：一般拷进缓冲池的slab，池子热起来之后不再调用分配器；
+    //很小的数据拷进恰好大小的string，免得几个字节的段占住一整个slab
+    string exact{};
+    SlabRef slab{};
+    char *out = nullptr;
+    if (n < BufferPool::MIN_POOLED_SIZE) {
+        exact.resize(n);
+        out = exact.data();
+    } else {
+        slab = BufferPool::global().get(n);
+        out = slab.data();
+    }
+    size_t copied = 0;
+    auto append = [&](const string_view piece) {
+        copy(piece.begin(), piece.end(), out + copied);
+        copied += piece.size();
+    };
+    if (_mode == Mode::Chunked) {
+        for (auto it = _chunks.begin(); copied < n; ++it) {
+            append(it->str().substr(0, n - copied));
+        }
+    } else {
+        const auto views = peek_views(n);
+        append(views.first);
+        append(views.second);
+    }
+    pop_output(n);
+    if (slab) { return {move(slab), n}; }
+    return Buffer(move(exact));
+}
+
 void ByteStream::end_input() { _input_end = true; }
 
 bool ByteStream::input_ended() const { return _input_end; }
 
-size_t ByteStream::buffer_size() const { return _buffer.size(); }
+size_t ByteStream::buffer_size() const { return _size; }
 
-bool ByteStream::buffer_empty() const { return _buffer.empty(); }
+bool ByteStream::buffer_empty() const { return _size == 0; }
 
-bool ByteStream::eof() const { return _input_end && _buffer.empty(); }
+bool ByteStream::eof() const { return _input_end && _size == 0; }
 
 size_t ByteStream::bytes_written() const { return _bytes_written; }
 
 size_t ByteStream::bytes_read() const { return _bytes_read; }
 
-size_t ByteStream::remaining_capacity() const { return _capacity - _buffer.size();}
\ No newline at end of file
+size_t ByteStream::remaining_capacity() const { return _capacity - _size; }
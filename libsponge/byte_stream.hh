@@ -1,9 +1,13 @@
 #ifndef SPONGE_LIBSPONGE_BYTE_STREAM_HH
 #define SPONGE_LIBSPONGE_BYTE_STREAM_HH
 
+#include "buffer.hh"
+#include "util.hh"
+
+#include <deque>
 #include <string>
-#include <queue>
-#include <list>
+#include <string_view>
+#include <utility>
 
 //! \brief An in-order byte stream.
 
@@ -11,6 +15,13 @@
 //! side.  The byte stream is finite: the writer can end the input,
 //! and then no more bytes can be written.
 class ByteStream {
+  public:
+    //! How the stream keeps the bytes that have been written but not yet read
+    enum class Mode {
+        Ring,    //!< copy every write into a fixed-capacity ring buffer
+        Chunked  //!< keep each write as a reference-counted Buffer chunk, without copying it
+    };
+
   private:
     // Your code here -- add private members as necessary.
 
@@ -19,10 +30,14 @@ class ByteStream {
     // that's a sign that you probably want to keep exploring
     // different approaches.
     size_t _capacity{};
-    //size_t _remaining_capacity{};
-    //std::deque<char> _buffer{};
+    Mode _mode;
+    //! \note 之前用std::string做缓存，pop_output中的erase(0, n)每次都要搬移剩余的全部字节
+    //! 现在改为定长环形缓冲区：_buffer长度恒为_capacity，读写代价只与读写的字节数有关
     std::string _buffer{};
-    //std::list<char> _buffer{};
+    size_t _head{0};  //!< 下一个待读出字节在_buffer中的位置
+    size_t _size{0};  //!< 当前缓存中的字节数(两种模式共用)
+    //! Chunked模式下的缓存：每次写入对应一个Buffer，读出时直接切分Buffer，不发生拷贝
+    std::deque<Buffer> _chunks{};
     bool _input_end{false};
     bool _error{false};  //!< Flag indicating that the stream suffered an error.
 
@@ -31,7 +46,7 @@ class ByteStream {
 
   public:
     //! Construct a stream with room for `capacity` bytes.
-    ByteStream(const size_t capacity);
+    ByteStream(const size_t capacity, const Mode mode = Mode::Ring);
 
     //! \name "Input" interface for the writer
     //!@{
@@ -39,7 +54,27 @@ class ByteStream {
     //! Write a string of bytes into the stream. Write as many
     //! as will fit, and return how many were written.
     //! \returns the number of bytes accepted into the stream
-    size_t write(const std::string &data);
+    size_t write(std::string_view data);
+
+    //! Write a Buffer into the stream. In Chunked mode the bytes are kept by reference.
+    //! \returns the number of bytes accepted into the stream
+    size_t write(Buffer data);
+
+    //! Write a string that the stream may take ownership of (avoids a copy in Chunked mode)
+    //! \returns the number of bytes accepted into the stream
+    size_t write(std::string &&data);
+
+    //! Write a C string into the stream
+    //! \returns the number of bytes accepted into the stream
+    size_t write(const char *data) { return write(std::string_view(data)); }
+
+    //! \brief Copy as much of `data` as fits into the free space while adding all of `data` to `check`,
+    //! in one pass; the copied bytes only become readable with commit()
+    //! \returns the number of bytes staged (always 0 in Chunked mode, which keeps writes without copying them)
+    size_t stage(std::string_view data, InternetChecksum &check);
+
+    //! Make the first `len` bytes staged by the last stage() readable, as write() would have
+    void commit(const size_t len);
 
     //! \returns the number of additional bytes that the stream has space for
     size_t remaining_capacity() const;
@@ -58,6 +93,12 @@ class ByteStream {
     //! \returns a string
     std::string peek_output(const size_t len) const;
 
+    //! Peek at next "len" bytes of the stream without copying them
+    //! \returns two views into the buffer; the second one is empty unless the bytes wrap around
+    //! the end of the ring buffer. The views are invalidated by the next write or pop.
+    //! \note In Chunked mode the views are the first two chunks, which may hold fewer than "len" bytes.
+    std::pair<std::string_view, std::string_view> peek_views(const size_t len) const;
+
     //! Remove bytes from the buffer
     void pop_output(const size_t len);
 
@@ -65,6 +106,15 @@ class ByteStream {
     //! \returns a string
     std::string read(const size_t len);
 
+    //! Read the next "len" bytes of the stream as a list of Buffers
+    //! \returns slices of the written chunks in Chunked mode (no copy), or a single copied Buffer in Ring mode
+    BufferList read_buffers(const size_t len);
+
+    //! Read the next "len" bytes of the stream as one Buffer
+    //! \returns a slice of the first chunk if it holds them all (no copy), or else a copy (in a BufferPool slab
+    //! unless it is tiny)
+    Buffer read_contiguous(const size_t len);
+
     //! \returns `true` if the stream input has ended
     bool input_ended() const;
 
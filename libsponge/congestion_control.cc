@@ -0,0 +1,243 @@
+#include "congestion_control.hh"
+
+#include <algorithm>
+#include <cmath>
+
+using namespace std;
+
+unique_ptr<CongestionController> CongestionController::make(const Algorithm algorithm, const size_t mss) {
+    switch (algorithm) {
+        case Algorithm::Reno:
+            return make_unique<RenoController>(mss);
+        case Algorithm::Cubic:
+            return make_unique<CubicController>(mss);
+        case Algorithm::BBR:
+            return make_unique<BBRController>(mss);
+        case Algorithm::None:
+            break;
+    }
+    return make_unique<NoCongestionControl>();
+}
+
+optional<CongestionController::Algorithm> CongestionController::algorithm_from_name(const string &name) {
+    for (const Algorithm algorithm : {Algorithm::None, Algorithm::Reno, Algorithm::Cubic, Algorithm::BBR}) {
+        if (name == algorithm_name(algorithm)) {
+            return algorithm;
+        }
+    }
+    return {};
+}
+
+string CongestionController::algorithm_name(const Algorithm algorithm) {
+    switch (algorithm) {
+        case Algorithm::Reno:
+            return "reno";
+        case Algorithm::Cubic:
+            return "cubic";
+        case Algorithm::BBR:
+            return "bbr";
+        case Algorithm::None:
+            break;
+    }
+    return "none";
+}
+
+uint64_t LossBasedController::initial_window(const size_t mss) {
+    return min<uint64_t>(4 * mss, max<uint64_t>(2 * mss, 4380));
+}
+
+void LossBasedController::on_ack(const uint64_t acked,
+                                 const uint64_t /* in_flight */,
+                                 const optional<uint64_t> /* rtt */,
+                                 const uint64_t now_ms) {
+    //快速恢复期间的新确认是partial ack：收回已确认部分带来的膨胀，再加回一个MSS(RFC 6582)
+    //完全恢复时随后的on_recovery_exit()会把窗口设为ssthresh
+    if (_in_recovery) {
+        _cwnd = (_cwnd > acked ? _cwnd - acked : 0) + _mss;
+        return;
+    }
+    //慢启动：按确认的字节数增长(RFC 3465)，即每个RTT翻倍，不受ack个数影响
+    //接收端合并报文段(receive_coalescing)或延迟ack时，一个ack会确认多个MSS，若每个ack最多只增长一个MSS，慢启动会被拖慢
+    //超时后的慢启动仍然每个ack最多增长一个MSS：此时一个ack可能确认大量对方早已收到的数据(RFC 3465 2.3节)
+    uint64_t avoidance_acked = acked;
+    if (_cwnd < _ssthresh) {
+        const uint64_t limit = _after_timeout ? min<uint64_t>(acked, _mss) : acked;
+        const uint64_t growth = min(limit, _ssthresh - _cwnd);
+        _cwnd += growth;
+        avoidance_acked = _after_timeout ? 0 : acked - growth;
+        if (_cwnd < _ssthresh) return;
+        _after_timeout = false;
+    }
+    //越过ssthresh之后剩下的确认量按拥塞避免处理
+    if (avoidance_acked > 0) grow(avoidance_acked, now_ms);
+}
+
+void LossBasedController::on_timeout(const uint64_t in_flight, const uint64_t now_ms) {
+    //超时说明整个窗口都可能丢失了，窗口降为一个MSS重新慢启动
+    _ssthresh = reduce(in_flight, now_ms);
+    _cwnd = _mss;
+    _in_recovery = false;
+    _after_timeout = true;
+}
+
+void LossBasedController::on_fast_retransmit(const uint64_t in_flight, const uint64_t now_ms) {
+    if (_in_recovery) return;
+    //三个重复ack说明有三个报文段已经离开网络，窗口 = ssthresh + 3 * MSS
+    _ssthresh = reduce(in_flight, now_ms);
+    _cwnd = _ssthresh + 3 * _mss;
+    _in_recovery = true;
+    _after_timeout = false;
+}
+
+void LossBasedController::on_dupack() {
+    if (_in_recovery) _cwnd += _mss;
+}
+
+void LossBasedController::on_recovery_exit() {
+    if (!_in_recovery) return;
+    _cwnd = _ssthresh;
+    _in_recovery = false;
+}
+
+void RenoController::grow(const uint64_t acked, const uint64_t /* now_ms */) {
+    //每确认一整个窗口的数据，窗口增长一个MSS(按字节计数，不受ack个数影响)
+    _acked_in_avoidance += acked;
+    if (_acked_in_avoidance >= _cwnd) {
+        _acked_in_avoidance -= _cwnd;
+        _cwnd += _mss;
+    }
+}
+
+uint64_t RenoController::reduce(const uint64_t in_flight, const uint64_t /* now_ms */) {
+    _acked_in_avoidance = 0;
+    return max<uint64_t>(in_flight / 2, 2 * _mss);
+}
+
+void CubicController::on_ack(const uint64_t acked,
+                             const uint64_t in_flight,
+                             const optional<uint64_t> rtt,
+                             const uint64_t now_ms) {
+    if (rtt.has_value()) _rtt = rtt.value();
+    LossBasedController::on_ack(acked, in_flight, rtt, now_ms);
+}
+
+void CubicController::grow(const uint64_t acked, const uint64_t now_ms) {
+    const double mss = _mss;
+    const double cwnd = _cwnd / mss;
+    //新一轮拥塞避免开始：如果窗口还没有恢复到_w_max，则K是回到_w_max所需的时间，否则以当前窗口为原点
+    if (!_epoch_start.has_value()) {
+        _epoch_start = now_ms;
+        if (cwnd < _w_max) {
+            _k = cbrt((_w_max - cwnd) / C);
+        } else {
+            _k = 0;
+            _w_max = cwnd;
+        }
+    }
+    //目标窗口取一个RTT之后的W(t)，但不低于同样条件下Reno能达到的窗口
+    //发送方的时钟以毫秒计，同一毫秒内收到的ack采样出的RTT为0，按1毫秒处理
+    const double t = (now_ms - _epoch_start.value()) / 1000.0;
+    const double rtt = max<uint64_t>(_rtt, 1) / 1000.0;
+    double target = C * pow(t + rtt - _k, 3) + _w_max;
+    target = max(target, _w_max * BETA + 3 * (1 - BETA) / (1 + BETA) * t / rtt);
+    target = min(target, 1.5 * cwnd);
+    //每确认一个MSS窗口增长(target - cwnd) / cwnd个MSS
+    //目标不高于当前窗口时(例如在_w_max附近的平台期)只以Reno速度的1/100缓慢增长，即每个RTT约增长0.01个MSS，
+    //这是有意为之(与Linux的cubic相同)，不要把常数100改成1
+    //不足一个字节的增长累积起来，不能每个ack都向上取整(那样每个ack至少增长一个字节，ack越多窗口涨得越快)
+    _growth += target > cwnd ? (target - cwnd) / cwnd * acked : acked * mss / _cwnd / 100;
+    const double whole = floor(_growth);
+    _cwnd += static_cast<uint64_t>(whole);
+    _growth -= whole;
+}
+
+uint64_t CubicController::reduce(const uint64_t /* in_flight */, const uint64_t /* now_ms */) {
+    //快速收敛：如果丢包时的窗口比上次的_w_max还小，说明有新流加入，主动让出更多带宽
+    const double cwnd = static_cast<double>(_cwnd) / _mss;
+    _w_max = cwnd < _w_max ? cwnd * (1 + BETA) / 2 : cwnd;
+    _epoch_start.reset();
+    _growth = 0;
+    return max<uint64_t>(_cwnd * BETA, 2 * _mss);
+}
+
+uint64_t BBRController::bdp() const {
+    if (!_min_rtt.has_value() || _btl_bw == 0) return 0;
+    return static_cast<uint64_t>(_btl_bw * max<uint64_t>(_min_rtt.value(), 1));
+}
+
+uint64_t BBRController::cwnd() const {
+    if (_timed_out) return _mss;
+    const uint64_t estimate = bdp();
+    //还没有任何带宽估计时，使用与Reno相同的初始窗口
+    if (estimate == 0) return LossBasedController::initial_window(_mss);
+    double gain = PROBE_BW_GAIN;
+    if (_phase == Phase::Startup) gain = STARTUP_GAIN;
+    if (_phase == Phase::Drain) gain = 1.0;  //没有pacing，只能靠把窗口限制在一个BDP来排空队列
+    return max<uint64_t>(gain * estimate, 4 * _mss);
+}
+
+void BBRController::on_ack(const uint64_t acked,
+                           const uint64_t in_flight,
+                           const optional<uint64_t> rtt,
+                           const uint64_t now_ms) {
+    _timed_out = false;
+    _delivered += acked;
+    //同一毫秒内的确认只保留一项(查找时取的本来就是该时刻最后的_delivered)，并且每个ack都丢弃超过HISTORY_MS的历史，
+    //这样即使很久没有RTT采样(例如确认的都是重传过的报文段)，_history也最多只有HISTORY_MS项
+    if (!_history.empty() && _history.back().first == now_ms) {
+        _history.back().second = _delivered;
+    } else {
+        _history.emplace_back(now_ms, _delivered);
+    }
+    const uint64_t horizon = now_ms > HISTORY_MS ? now_ms - HISTORY_MS : 0;
+    while (_history.size() > 1 && _history[1].first <= horizon) _history.pop_front();
+    if (rtt.has_value()) {
+        if (!_min_rtt.has_value() || rtt.value() <= _min_rtt.value() ||
+            now_ms - _min_rtt_stamp > MIN_RTT_WINDOW_MS) {
+            _min_rtt = rtt.value();
+            _min_rtt_stamp = now_ms;
+        }
+        sample_bandwidth(rtt.value(), now_ms);
+    }
+    if (now_ms >= _round_start + max<uint64_t>(_min_rtt.value_or(0), 1)) advance_round(now_ms);
+    if (_phase == Phase::Drain && in_flight <= bdp()) _phase = Phase::ProbeBW;
+}
+
+void BBRController::on_timeout(const uint64_t /* in_flight */, const uint64_t /* now_ms */) { _timed_out = true; }
+
+void BBRController::sample_bandwidth(const uint64_t rtt, const uint64_t now_ms) {
+    //交付速率 = 这个报文段发出之后到现在确认的字节数 / RTT，发出时的确认量从_history中查找
+    const uint64_t interval = max<uint64_t>(rtt, 1);
+    const uint64_t sent_at = now_ms > interval ? now_ms - interval : 0;
+    uint64_t delivered_at_send = 0;
+    for (auto it = _history.rbegin(); it != _history.rend(); ++it) {
+        if (it->first <= sent_at) {
+            delivered_at_send = it->second;
+            break;
+        }
+    }
+    const double rate = static_cast<double>(_delivered - delivered_at_send) / interval;
+
+    //窗口内的最大值滤波器：_bw_samples中的速率单调递减，队首即最大值
+    while (!_bw_samples.empty() && _bw_samples.back().second <= rate) _bw_samples.pop_back();
+    _bw_samples.emplace_back(_round, rate);
+    while (_bw_samples.front().first + BW_WINDOW_ROUNDS <= _round) _bw_samples.pop_front();
+    _btl_bw = _bw_samples.front().second;
+}
+
+void BBRController::advance_round(const uint64_t now_ms) {
+    _round += 1;
+    _round_start = now_ms;
+    while (!_bw_samples.empty() && _bw_samples.front().first + BW_WINDOW_ROUNDS <= _round) {
+        _bw_samples.pop_front();
+    }
+    if (!_bw_samples.empty()) _btl_bw = _bw_samples.front().second;
+    if (_phase != Phase::Startup) return;
+    //Startup：带宽连续FULL_BW_ROUNDS轮增长不到25%，说明管道已满，进入Drain排空多出来的队列
+    if (_btl_bw >= _full_bw * 1.25) {
+        _full_bw = _btl_bw;
+        _full_bw_rounds = 0;
+    } else if (++_full_bw_rounds >= FULL_BW_ROUNDS) {
+        _phase = Phase::Drain;
+    }
+}
@@ -0,0 +1,222 @@
+#ifndef SPONGE_LIBSPONGE_CONGESTION_CONTROL_HH
+#define SPONGE_LIBSPONGE_CONGESTION_CONTROL_HH
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+
+//! \brief Congestion control for the TCPSender
+//! \details The TCPSender never has more than min(receiver window, cwnd()) sequence numbers in flight.
+//! It calls on_ack() for every ack that acknowledges new sequence numbers and on_timeout() when the
+//! retransmission timer expires. on_fast_retransmit(), on_dupack() and on_recovery_exit() drive fast recovery.
+//! All byte counts are in sequence space; times are the sender's clock in milliseconds.
+class CongestionController {
+  public:
+    //! The available algorithms (selected through TCPConfig::congestion_control)
+    enum class Algorithm {
+        None,   //!< only the receiver's window limits the sender
+        Reno,   //!< slow start, AIMD congestion avoidance and fast recovery (RFC 5681)
+        Cubic,  //!< window growth as a cubic function of the time since the last loss (RFC 8312)
+        BBR     //!< window sized from the estimated bottleneck bandwidth and minimum RTT (simplified BBRv1)
+    };
+
+    //! Create the controller for `algorithm`, for segments of at most `mss` bytes
+    static std::unique_ptr<CongestionController> make(const Algorithm algorithm, const size_t mss);
+
+    //! The algorithm called `name` ("none", "reno", "cubic" or "bbr"), if any
+    static std::optional<Algorithm> algorithm_from_name(const std::string &name);
+
+    //! The name of `algorithm`, as accepted by algorithm_from_name()
+    static std::string algorithm_name(const Algorithm algorithm);
+
+    virtual ~CongestionController() = default;
+
+    //! How many sequence numbers may be in flight
+    virtual uint64_t cwnd() const = 0;
+
+    //! \brief An ack acknowledged new data (during fast recovery: a partial or the final ack)
+    //! \param acked number of newly acknowledged sequence numbers, not counting the SYN
+    //! \param in_flight sequence numbers still in flight after this ack
+    //! \param rtt round-trip time of the newest acknowledged segment, unless it had been retransmitted
+    //! \param now_ms the sender's clock
+    virtual void on_ack(const uint64_t acked, const uint64_t in_flight, const std::optional<uint64_t> rtt,
+                        const uint64_t now_ms) = 0;
+
+    //! The retransmission timer expired with `in_flight` sequence numbers outstanding
+    virtual void on_timeout(const uint64_t in_flight, const uint64_t now_ms) = 0;
+
+    //! A loss was detected by duplicate acks and the oldest segment is being resent (enter fast recovery)
+    virtual void on_fast_retransmit(const uint64_t in_flight, const uint64_t now_ms) = 0;
+
+    //! Another duplicate ack arrived while in fast recovery
+    virtual void on_dupack() = 0;
+
+    //! Everything that was in flight when fast recovery started has been acknowledged
+    virtual void on_recovery_exit() = 0;
+
+    //! Slow start threshold (max value while there is none)
+    virtual uint64_t ssthresh() const { return std::numeric_limits<uint64_t>::max(); }
+
+    virtual Algorithm algorithm() const = 0;
+};
+
+//! No congestion control: cwnd() is unlimited
+class NoCongestionControl : public CongestionController {
+  public:
+    uint64_t cwnd() const override { return std::numeric_limits<uint64_t>::max(); }
+    void on_ack(const uint64_t, const uint64_t, const std::optional<uint64_t>, const uint64_t) override {}
+    void on_timeout(const uint64_t, const uint64_t) override {}
+    void on_fast_retransmit(const uint64_t, const uint64_t) override {}
+    void on_dupack() override {}
+    void on_recovery_exit() override {}
+    Algorithm algorithm() const override { return Algorithm::None; }
+};
+
+//! \brief Loss-based window control shared by Reno and CUBIC
+//! \details Slow start below ssthresh (counting acknowledged bytes, RFC 3465), fast recovery with
+//! window inflation (RFC 5681 section 3.2), and one-segment loss window after a timeout. Subclasses
+//! decide how the window grows in congestion avoidance and how far it is cut on loss.
+class LossBasedController : public CongestionController {
+  protected:
+    size_t _mss;
+    uint64_t _cwnd;
+    uint64_t _ssthresh{std::numeric_limits<uint64_t>::max()};
+    bool _in_recovery{false};
+    bool _after_timeout{false};  //超时之后的慢启动，每个ack最多增长一个MSS
+
+    //! 拥塞避免阶段收到acked个新确认的序列号时，拥塞窗口如何增长
+    virtual void grow(const uint64_t acked, const uint64_t now_ms) = 0;
+
+    //! 检测到丢包时的新ssthresh(同时可以记录子类自己的状态)
+    virtual uint64_t reduce(const uint64_t in_flight, const uint64_t now_ms) = 0;
+
+  public:
+    //! Initial window of RFC 5681: min(4 * MSS, max(2 * MSS, 4380))
+    static uint64_t initial_window(const size_t mss);
+
+    explicit LossBasedController(const size_t mss) : _mss(mss), _cwnd(initial_window(mss)) {}
+
+    uint64_t cwnd() const override { return _cwnd; }
+    uint64_t ssthresh() const override { return _ssthresh; }
+    bool in_recovery() const { return _in_recovery; }
+
+    void on_ack(const uint64_t acked,
+                const uint64_t in_flight,
+                const std::optional<uint64_t> rtt,
+                const uint64_t now_ms) override;
+    void on_timeout(const uint64_t in_flight, const uint64_t now_ms) override;
+    void on_fast_retransmit(const uint64_t in_flight, const uint64_t now_ms) override;
+    void on_dupack() override;
+    void on_recovery_exit() override;
+};
+
+//! Reno: one MSS of growth per window of acknowledged data, ssthresh = half the flight on loss
+class RenoController : public LossBasedController {
+  private:
+    uint64_t _acked_in_avoidance{0};  //拥塞避免阶段累积确认的字节数，每满一个cwnd窗口增长一个MSS
+
+  protected:
+    void grow(const uint64_t acked, const uint64_t now_ms) override;
+    uint64_t reduce(const uint64_t in_flight, const uint64_t now_ms) override;
+
+  public:
+    using LossBasedController::LossBasedController;
+    Algorithm algorithm() const override { return Algorithm::Reno; }
+};
+
+//! CUBIC: W(t) = C * (t - K)^3 + W_max, never slower than the Reno-friendly estimate
+class CubicController : public LossBasedController {
+  public:
+    static constexpr double C = 0.4;     //!< scaling constant, in MSS per second^3
+    static constexpr double BETA = 0.7;  //!< multiplicative decrease factor
+
+  private:
+    double _w_max{0};                        //上次丢包前的窗口(以MSS为单位)
+    double _k{0};                            //从丢包开始到窗口重新增长到_w_max所需要的时间(秒)
+    std::optional<uint64_t> _epoch_start{};  //本轮拥塞避免的开始时刻，丢包后清空
+    uint64_t _rtt{0};                        //最近一次RTT采样(毫秒)，用于TCP-friendly估计
+    double _growth{0};                       //还没有加到_cwnd上的不足一个字节的增长
+
+  protected:
+    void grow(const uint64_t acked, const uint64_t now_ms) override;
+    uint64_t reduce(const uint64_t in_flight, const uint64_t now_ms) override;
+
+  public:
+    using LossBasedController::LossBasedController;
+    void on_ack(const uint64_t acked,
+                const uint64_t in_flight,
+                const std::optional<uint64_t> rtt,
+                const uint64_t now_ms) override;
+    Algorithm algorithm() const override { return Algorithm::Cubic; }
+};
+
+//! \brief Simplified BBR
+//! \details Estimates the bottleneck bandwidth as the maximum delivery rate seen over the last
+//! BW_WINDOW_ROUNDS round trips, and the propagation delay as the minimum RTT over MIN_RTT_WINDOW_MS.
+//! The window is a gain times their product (the BDP). Startup doubles the window every round
+//! until the bandwidth estimate stops growing, Drain lets the queue built by Startup empty, and
+//! ProbeBW then keeps two BDPs in flight. Losses found by duplicate acks do not cut the window.
+//! There is no pacing and no ProbeRTT phase.
+class BBRController : public CongestionController {
+  public:
+    enum class Phase { Startup, Drain, ProbeBW };
+
+    static constexpr double STARTUP_GAIN = 2.885;          //!< 2 / ln(2)
+    static constexpr double PROBE_BW_GAIN = 2.0;           //!< cwnd gain once the pipe is full
+    static constexpr unsigned BW_WINDOW_ROUNDS = 10;       //!< rounds covered by the bandwidth max filter
+    static constexpr uint64_t MIN_RTT_WINDOW_MS = 10000;   //!< how long a min RTT sample stays valid
+    static constexpr unsigned FULL_BW_ROUNDS = 3;          //!< rounds without 25% growth that end Startup
+    static constexpr uint64_t HISTORY_MS = 10000;          //!< longest RTT a delivery rate can be measured over
+
+  private:
+    size_t _mss;
+    Phase _phase{Phase::Startup};
+    uint64_t _delivered{0};                                 //累积确认的字节数
+    std::deque<std::pair<uint64_t, uint64_t>> _history{};   //(时刻, 当时的_delivered)，用于计算交付速率
+    std::deque<std::pair<uint64_t, double>> _bw_samples{};  //(轮次, 交付速率字节/毫秒)，窗口内的最大值即带宽估计
+    double _btl_bw{0};
+    std::optional<uint64_t> _min_rtt{};
+    uint64_t _min_rtt_stamp{0};
+    uint64_t _round{0};           //已经经过的往返轮次
+    uint64_t _round_start{0};     //本轮开始的时刻
+    double _full_bw{0};           //Startup阶段最近一次带宽增长超过25%时的带宽
+    unsigned _full_bw_rounds{0};  //带宽没有明显增长的轮数
+    bool _timed_out{false};       //超时后窗口降为一个MSS，直到下一次收到新的确认
+
+    //! 当前的BDP(字节)，还没有带宽或RTT估计时为0
+    uint64_t bdp() const;
+
+    //! 记录一次交付速率采样并更新_btl_bw
+    void sample_bandwidth(const uint64_t rtt, const uint64_t now_ms);
+
+    //! 每轮结束时推进Startup/Drain状态
+    void advance_round(const uint64_t now_ms);
+
+  public:
+    explicit BBRController(const size_t mss) : _mss(mss) {}
+
+    uint64_t cwnd() const override;
+    void on_ack(const uint64_t acked,
+                const uint64_t in_flight,
+                const std::optional<uint64_t> rtt,
+                const uint64_t now_ms) override;
+    void on_timeout(const uint64_t in_flight, const uint64_t now_ms) override;
+    void on_fast_retransmit(const uint64_t, const uint64_t) override {}
+    void on_dupack() override {}
+    void on_recovery_exit() override {}
+    Algorithm algorithm() const override { return Algorithm::BBR; }
+
+    //! \name Model of the path
+    //!@{
+    Phase phase() const { return _phase; }
+    double bottleneck_bandwidth() const { return _btl_bw; }  //!< bytes per millisecond
+    std::optional<uint64_t> min_rtt() const { return _min_rtt; }
+    //!@}
+};
+
+#endif  // SPONGE_LIBSPONGE_CONGESTION_CONTROL_HH
@@ -61,7 +61,7 @@ optional<InternetDatagram> NetworkInterface::recv_frame(const EthernetFrame &fra
     //如果里面包含的是IPv4数据报，则抽取该IP数据报
     if (frame.header().type == EthernetHeader::TYPE_IPv4) {
         InternetDatagram ip_datagram{};
-        if (ip_datagram.parse(Buffer(frame.payload().concatenate())) == ParseResult::NoError) {
+        if (ip_datagram.parse(frame.payload().contiguous()) == ParseResult::NoError) {
             parse_result = ip_datagram;
         } 
         return parse_result; 
@@ -69,7 +69,7 @@ optional<InternetDatagram> NetworkInterface::recv_frame(const EthernetFrame &fra
     //如果里面包含的是ARP分组，则抽取该分组，并将该映射关系记录30s
     if (frame.header().type == EthernetHeader::TYPE_ARP) {
         ARPMessage arp_message{};
-        if (arp_message.parse(Buffer(frame.payload().concatenate())) == ParseResult::NoError) {
+        if (arp_message.parse(frame.payload().contiguous()) == ParseResult::NoError) {
             //cout << arp_message.sender_ip_address << endl;
             //cout << _frames_waited.front().second.ipv4_numeric() << endl;
             //记录发送方IP地址和MAC地址的映射关系
@@ -140,11 +140,10 @@ void NetworkInterface::send_ARP(uint16_t opcode,
     linkframe_header.src = _ethernet_address;
     linkframe_header.type = EthernetHeader::TYPE_ARP;
 
-    //Frame header + ARP message的序列化，创立buffer
-    Buffer serialized_frame(linkframe_header.serialize() + arp_message.serialize());
-    //解析该序列，得到structure 链路层帧
+    //直接组装链路层帧：首部 + 序列化的ARP message
     EthernetFrame ethernet_frame{};
-    ethernet_frame.parse(serialized_frame);
+    ethernet_frame.header() = linkframe_header;
+    ethernet_frame.payload() = arp_message.serialize();
     //把ARP message广播/发送出去
     _frames_out.push(ethernet_frame);
 
@@ -157,11 +156,10 @@ void NetworkInterface::send_frame(const InternetDatagram &dgram, EthernetAddress
     linkframe_header.src = _ethernet_address;
     linkframe_header.type = EthernetHeader::TYPE_IPv4;
 
-    //设置序列化的 链路层首部字段 + IP数据报
-    Buffer serialized_frame(linkframe_header.serialize() + dgram.serialize().concatenate());
-    //解析该序列，得到structure 链路层帧
+    //直接组装链路层帧：IP数据报序列化后的各段缓冲区原样挂在帧首部之后，不拼接、不拷贝载荷
     EthernetFrame ethernet_frame{};
-    ethernet_frame.parse(serialized_frame);
+    ethernet_frame.header() = linkframe_header;
+    ethernet_frame.payload() = dgram.serialize();
     //将得到的链路层帧发送出去
     _frames_out.push(ethernet_frame);    
 }
@@ -38,6 +38,7 @@ void Router::route_one_datagram(InternetDatagram &dgram) {
     //ttl自减1判断是否是0，如果是，则丢弃数据报
     if (dgram.header().ttl == 0) return;
     if (--dgram.header().ttl == 0) return;
+    //首部校验和不用在这里更新：IPv4Datagram::serialize()总会重新计算
     //获得数据报的目标IP地址，以32位数字表示
     uint32_t dst_ip = dgram.header().dst;
     uint8_t max_prelen = 0; //记录哪个表项与dst_ip相匹配的的prefix_length最长？
@@ -1,5 +1,9 @@
 #include "stream_reassembler.hh"
 
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+
 // Dummy implementation of a stream reassembler.
 
 // For Lab 1, please replace with a real implementation that passes the
@@ -12,104 +16,287 @@ void DUMMY_CODE(Targs &&... /* unused */) {}
 
 using namespace std;
 
-StreamReassembler::StreamReassembler(const size_t capacity) : _output(capacity), _capacity(capacity) {}
+StreamReassembler::StreamReassembler(const size_t capacity, const Engine engine)
+    : _output(capacity)
+    , _capacity(capacity)
+    , _engine(engine)
+    , _window(engine == Engine::Bitmap ? capacity : 0, 0)
+    , _present(engine == Engine::Bitmap ? (capacity + 63) / 64 : 0, 0) {}
 
-/**
- * @return 此函数的目的在于根据capacity和EOF的信息对数据进行截断
- * 基本上用于截断这个数据的尾部
-*/
-string StreamReassembler::truncation_data(const string& data, const size_t index) {
-    //size_t data_length = data.length();
-    string new_data = data;
-    //如果我们已经得到了EOF，即最后一个字节的序号
-    //那么超出的部分将被直接丢弃
-    if (_has_eof && index + data.length() > _final_idx + 1) {
-        new_data = new_data.substr(0, _final_idx - index + 1);
+namespace {
+//! 取出原始子串中[offset, offset + len)的部分：持有Buffer时只截取引用，否则拷贝一次
+Buffer make_piece(const string_view data, const Buffer *owner, const size_t offset, const size_t len) {
+    if (owner == nullptr) { return Buffer(string(data.substr(offset, len))); }
+    Buffer piece = *owner;
+    piece.remove_suffix(piece.size() - offset - len);
+    piece.remove_prefix(offset);
+    return piece;
+}
+}  // namespace
+
+//! \details This function accepts a substring (aka a segment) of bytes,
+//! possibly out-of-order, from the logical stream, and assembles any newly
+//! contiguous substrings and writes them into the output stream in order.
+void StreamReassembler::push_substring(const string &data, const uint64_t index, const bool eof) {
+    push_piece(data, nullptr, index, eof);
+}
+
+void StreamReassembler::push_substring(const string_view data, const uint64_t index, const bool eof) {
+    push_piece(data, nullptr, index, eof);
+}
+
+//! \details The payload is shared rather than copied: the in-order part is handed to the
+//! output stream as a slice of `data`, and out-of-order parts are kept as slices until they
+//! can be written.
+void StreamReassembler::push_substring(const Buffer &data, const uint64_t index, const bool eof) {
+    push_piece(data.str(), &data, index, eof);
+}
+
+void StreamReassembler::push_substring(const Buffer &data, const uint64_t index, const bool eof, const size_t staged) {
+    if (staged > 0 && index != _first_unassembled) {
+        throw runtime_error("StreamReassembler: staged bytes must start at the first unassembled byte");
     }
-    //其次考虑总容量的截断作用
-    //通过_capacity可以得到第一个不可接受之index
-    //data超出该不可接受index的部分将被截断
-    size_t _first_unacceptable = get_first_unacceptable();
-    if (index + new_data.length() > _first_unacceptable) {
-        new_data = new_data.substr(0, _first_unacceptable - index);
+    push_piece(data.str(), &data, index, eof, staged);
+}
+
+void StreamReassembler::push_piece(
+    const string_view data, const Buffer *owner, const uint64_t index, const bool eof, const size_t staged) {
+    //维护变量记录这个字节流的最后一个字节序列号
+    if (eof) { _has_eof = true;  _final_idx = index + data.length() - 1; }
+
+    //根据_first_unassembled、_first_unacceptable以及EOF对数据进行截断
+    //只保留[begin, end)之内的字节，截断只做下标运算，不拷贝数据
+    size_t begin = max(index, _first_unassembled);
+    size_t end = min(index + data.length(), get_first_unacceptable());
+    if (_has_eof) { end = min(end, _final_idx + 1); }
+
+    if (begin < end) {
+        if (begin == _first_unassembled) {
+            //简单情况：数据直接契合_first_unassembled，直接写入_output
+            //数据已经在_output的空闲空间里了(stage时边拷贝边校验)，只需提交
+            if (staged > 0) {
+                _output.commit(end - begin);
+            } else if (owner != nullptr) {
+                _output.write(make_piece(data, owner, begin - index, end - begin));
+            } else {
+                _output.write(data.substr(begin - index, end - begin));
+            }
+            if (_engine == Engine::Bitmap && _unassembled_bytes > 0) { clear_window(begin, end); }
+            _first_unassembled = end;
+        } else {
+            //数据不能直接读出：Bitmap引擎直接写到它在_window中的最终位置，否则只能暂存，进入_mapbuffer
+            //只有真正存下了新的字节才记为最近的乱序数据；重复的、或者因为内存预算被丢弃的子串不能占据第一个SACK块
+            const bool stored = _engine == Engine::Bitmap ? store_window(data, index, begin, end)
+                                                          : store_substring(data, owner, index, begin, end);
+            if (stored) { _latest_out_of_order = begin; }
+        }
+    }
+
+    //考察缓存中的元素能否读出？
+    if (_engine == Engine::Bitmap) {
+        drain_window();
+    } else {
+        drain_buffered();
     }
-    return new_data;
+    if (_has_eof && _first_unassembled == _final_idx + 1) { _output.end_input(); }
 }
 
-bool StreamReassembler::push_onestr(const std::string &new_data, const size_t index) {
-    //简单情况：如果new_data直接契合_first_unassembled
-    if (index == _first_unassembled) {
-        _output.write(new_data);
-        _first_unassembled = _first_unassembled + new_data.length();
-        if (_has_eof && _first_unassembled == _final_idx + 1) { _output.end_input(); } 
-        return true;
+bool StreamReassembler::store_substring(string_view data, const Buffer *owner, const size_t index, size_t begin, size_t end) {
+    //前一个子串：如果它完全覆盖了新数据就直接丢弃，否则裁掉新数据与它重叠的头部
+    auto it = _mapbuffer.upper_bound(begin);
+    if (it != _mapbuffer.begin()) {
+        const auto prev_it = prev(it);
+        const size_t prev_end = prev_it->first + prev_it->second.size();
+        if (prev_end >= end) { return false; }
+        begin = max(begin, prev_end);
     }
-    //稍显复杂的情况：如果new_data没有对新数据更新作出任何贡献
-    if (index + new_data.length() <= _first_unassembled) { 
-        if (_has_eof && _first_unassembled == _final_idx + 1) { _output.end_input(); } 
-        return true; 
+    //后面的子串：被新数据完全覆盖的会被删除(合并进新子串)；部分重叠的则裁掉新数据的尾部
+    //先只找出[it, last)这段被覆盖的子串，RejectNew策略需要在不改动_mapbuffer的前提下判断能否放下
+    auto last = it;
+    size_t freed = 0;
+    while (last != _mapbuffer.end() && last->first < end) {
+        const size_t next_end = last->first + last->second.size();
+        if (next_end > end) {
+            end = last->first;
+            break;
+        }
+        freed += fragment_cost(last->second.size());
+        ++last;
+    }
+    if (begin >= end) { return false; }
+    if (_memory_budget > 0 && _eviction == EvictionPolicy::RejectNew &&
+        _buffered_memory - freed + fragment_cost(end - begin) > _memory_budget) {
+        _evicted_fragments++;
+        _evicted_bytes += end - begin;
+        return false;
     }
+    while (it != last) { it = erase_fragment(it); }
+    //切片会让整个payload(一个MTU大小甚至64KiB的slab、合并后的大字符串)一直存活。
+    //如果切片远小于它所在的存储，就拷贝一份恰好大小的，保证实际占用的内存不超过计费的两倍
+    Buffer piece = make_piece(data, owner, begin - index, end - begin);
+    if (owner != nullptr && piece.storage_size() > 2 * piece.size()) { piece = Buffer(piece.copy()); }
+    _mapbuffer.emplace_hint(it, begin, move(piece));
+    _unassembled_bytes += end - begin;
+    _buffered_memory += fragment_cost(end - begin);
+    enforce_budget();
+    //超出预算时新子串本身也可能被丢弃
+    return _mapbuffer.count(begin) > 0;
+}
 
-    //稍显复杂的情况：如果new_data部分契合_first_unassembled
-    //那么就部分发送这个数据
-    if (index < _first_unassembled && index + new_data.length() > _first_unassembled) {
-        _output.write(new_data.substr(_first_unassembled - index, 
-                                        index + new_data.length() - _first_unassembled));
-        _first_unassembled = _first_unassembled + index + new_data.length() - _first_unassembled;
-        if (_has_eof && _first_unassembled == _final_idx + 1) { _output.end_input(); } 
-        return true;
-    }   
-    return false;   
+map<size_t, Buffer>::iterator StreamReassembler::erase_fragment(map<size_t, Buffer>::iterator it) {
+    _unassembled_bytes -= it->second.size();
+    _buffered_memory -= fragment_cost(it->second.size());
+    return _mapbuffer.erase(it);
 }
 
-//! \details This function accepts a substring (aka a segment) of bytes,
-//! possibly out-of-order, from the logical stream, and assembles any newly
-//! contiguous substrings and writes them into the output stream in order.
-void StreamReassembler::push_substring(const string &data, const size_t index, const bool eof) {
-    //维护变量记录这个字节流的最后一个字节序列号
-    if (eof) { _has_eof = true;  _final_idx = index + data.length() - 1; }
-    //对数据进行截断，防止出现不可接受之字节位
-    string new_data = truncation_data(data, index);
-    
-    //尝试直接读出new_data
-    push_onestr(new_data, index);
-
-    //更加复杂的情况：new_data不能直接读出，只能暂存，进入_mapbuffer
-    if (index > _first_unassembled) {
-        //! \bug 忘记把这个最终元素插入进去了，导致buffer中的数值凭空消失
-        //! \note 将此处改为移动语义，可有效减少拷贝时间，提高reordering benchmark大约0.2Gbit/s  
-        _mapbuffer.insert(pair<size_t, string>(index, move(new_data)));
+void StreamReassembler::enforce_budget() {
+    if (_memory_budget == 0) { return; }
+    //离_first_unassembled最远的数据最晚才能用上，先丢弃它们；新子串本身也可能因此被丢弃
+    while (_buffered_memory > _memory_budget && !_mapbuffer.empty()) {
+        const auto last = prev(_mapbuffer.end());
+        _evicted_fragments++;
+        _evicted_bytes += last->second.size();
+        erase_fragment(last);
     }
+}
 
-    //考察缓存_mapbuffer中的元素能否读出？
-    bool can_readout = true;
-    while (can_readout) {
-        can_readout = false;
-        for (auto& primer_pair : _mapbuffer) {
-            if (push_onestr(primer_pair.second, primer_pair.first)) {
-                _mapbuffer.erase(primer_pair);
-                can_readout = true;
-                break;
-            }
-        }        
+void StreamReassembler::set_memory_budget(const size_t budget, const EvictionPolicy policy) {
+    _memory_budget = budget;
+    _eviction = policy;
+    enforce_budget();
+}
+
+void StreamReassembler::drain_buffered() {
+    auto it = _mapbuffer.begin();
+    while (it != _mapbuffer.end() && it->first <= _first_unassembled) {
+        const size_t piece_end = it->first + it->second.size();
+        //子串可能已经被之前直接写入的数据部分覆盖，只写出还没有写过的尾部
+        if (piece_end > _first_unassembled) {
+            Buffer tail = it->second;
+            tail.remove_prefix(_first_unassembled - it->first);
+            _output.write(move(tail));
+            _first_unassembled = piece_end;
+        }
+        it = erase_fragment(it);
     }
 }
 
-/**
- * @note 实现策略：遍历_mapbuffer，用集合统计每个比特位是否被占据
- * 由于集合的唯一性，所以同一个比特位只能出现一次
-*/
-size_t StreamReassembler::unassembled_bytes() const { 
-    set<int> _unassembled_bytes{};
-    for (const auto& elem : _mapbuffer) {
-        for (size_t i = 0; i < elem.second.length(); ++i) {
-            _unassembled_bytes.insert(elem.first + i);
+bool StreamReassembler::store_window(string_view data, const size_t index, const size_t begin, const size_t end) {
+    const size_t pos = begin % _capacity;
+    const size_t len = end - begin;
+    //窗口的长度不超过_capacity，因此最多绕回一次
+    const size_t first_part = min(len, _capacity - pos);
+    data.copy(&_window[pos], first_part, begin - index);
+    data.copy(&_window[0], len - first_part, begin - index + first_part);
+    const size_t added = update_bits(pos, first_part, true) + update_bits(0, len - first_part, true);
+    _unassembled_bytes += added;
+    return added > 0;
+}
+
+void StreamReassembler::clear_window(const size_t begin, const size_t end) {
+    const size_t pos = begin % _capacity;
+    const size_t len = end - begin;
+    const size_t first_part = min(len, _capacity - pos);
+    _unassembled_bytes -= update_bits(pos, first_part, false) + update_bits(0, len - first_part, false);
+}
+
+void StreamReassembler::drain_window() {
+    while (_unassembled_bytes > 0) {
+        const size_t pos = _first_unassembled % _capacity;
+        const size_t run = count_run(pos, _capacity - pos);
+        if (run == 0) { break; }
+        //连续的字节在_window中本来就是连续存放的，直接写出；如果run到达_window末尾，下一轮从头继续
+        _output.write(string_view(_window).substr(pos, run));
+        update_bits(pos, run, false);
+        _unassembled_bytes -= run;
+        _first_unassembled += run;
+    }
+}
+
+size_t StreamReassembler::update_bits(size_t pos, size_t len, const bool set) {
+    size_t changed = 0;
+    while (len > 0) {
+        const size_t bit = pos % 64;
+        const size_t n = min(len, 64 - bit);
+        const uint64_t mask = (n == 64 ? ~uint64_t{0} : (uint64_t{1} << n) - 1) << bit;
+        uint64_t &word = _present[pos / 64];
+        const uint64_t flipped = mask & (set ? ~word : word);
+        changed += __builtin_popcountll(flipped);
+        word ^= flipped;
+        pos += n;
+        len -= n;
+    }
+    return changed;
+}
+
+size_t StreamReassembler::count_run(size_t pos, const size_t limit, const bool set) const {
+    size_t run = 0;
+    while (run < limit) {
+        const size_t bit = pos % 64;
+        //右移后高位补0：数连续置位时取反后变成1，ctz最多只会数到本字的末尾；数连续清零时需要截断到本字末尾
+        const uint64_t word = _present[pos / 64] >> bit;
+        const uint64_t missing = set ? ~word : word;
+        const size_t ones = min<size_t>(missing == 0 ? 64 : __builtin_ctzll(missing), 64 - bit);
+        run += ones;
+        if (ones < 64 - bit) { break; }
+        pos += ones;
+    }
+    return min(run, limit);
+}
+
+vector<pair<uint64_t, uint64_t>> StreamReassembler::sack_ranges(const size_t max_blocks) const {
+    vector<pair<uint64_t, uint64_t>> ranges{};
+    if (_unassembled_bytes == 0 || max_blocks == 0) { return ranges; }
+
+    if (_engine == Engine::Bitmap) {
+        //交替数出窗口内连续清零(空洞)和连续置位(已收到)的比特，遇到_window末尾就绕回开头
+        size_t idx = _first_unassembled;
+        const size_t window_end = get_first_unacceptable();
+        while (idx < window_end) {
+            const size_t pos = idx % _capacity;
+            const size_t limit = min(window_end - idx, _capacity - pos);
+            const size_t gap = count_run(pos, limit, false);
+            if (gap > 0) {
+                idx += gap;
+                continue;
+            }
+            const size_t run = count_run(pos, limit);
+            if (!ranges.empty() && ranges.back().second == idx) {
+                ranges.back().second += run;
+            } else {
+                ranges.emplace_back(idx, idx + run);
+            }
+            idx += run;
         }
+    } else {
+        //_mapbuffer中的子串互不重叠，但可能首尾相接，相接的合并为一个区间
+        for (const auto &[begin, piece] : _mapbuffer) {
+            if (!ranges.empty() && ranges.back().second == begin) {
+                ranges.back().second += piece.size();
+            } else {
+                ranges.emplace_back(begin, begin + piece.size());
+            }
+        }
+    }
+
+    //包含最近收到的乱序数据的区间排在第一位，其余保持递增顺序
+    if (_latest_out_of_order.has_value()) {
+        const size_t latest = _latest_out_of_order.value();
+        const auto it = find_if(ranges.begin(), ranges.end(),
+                                [latest](const auto &range) { return range.first <= latest && latest < range.second; });
+        if (it != ranges.end()) { rotate(ranges.begin(), it, next(it)); }
     }
-    return _unassembled_bytes.size();
+    if (ranges.size() > max_blocks) { ranges.resize(max_blocks); }
+    return ranges;
 }
 
 /**
- * @note 如果_mapbuffer中没有元素，说明没有待集成的子字符串了
+ * @note _unassembled_bytes在插入与读出时增量维护，由于_mapbuffer中的子串互不重叠
+ * 同一个字节只会被统计一次
+*/
+size_t StreamReassembler::unassembled_bytes() const { return _unassembled_bytes; }
+
+/**
+ * @note 如果缓存中没有字节，说明没有待集成的子字符串了
 */
-bool StreamReassembler::empty() const { return _mapbuffer.empty(); }
+bool StreamReassembler::empty() const { return _unassembled_bytes == 0; }
@@ -1,51 +1,135 @@
 #ifndef SPONGE_LIBSPONGE_STREAM_REASSEMBLER_HH
 #define SPONGE_LIBSPONGE_STREAM_REASSEMBLER_HH
 
+#include "buffer.hh"
 #include "byte_stream.hh"
 
 #include <cstdint>
 #include <string>
 #include <map>
-#include <set>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
 
 //! \brief A class that assembles a series of excerpts from a byte stream (possibly out of order,
 //! possibly overlapping) into an in-order byte stream.
 class StreamReassembler {
+  public:
+    //! How bytes that arrive out of order are stored until they can be reassembled
+    enum class Engine {
+        IntervalMap,  //!< non-overlapping substrings kept in a std::map
+        Bitmap        //!< one preallocated window-sized ring of bytes plus a presence bitmap
+    };
+
+    //! What to drop when out-of-order substrings exceed the memory budget
+    enum class EvictionPolicy {
+        FurthestFirst,  //!< evict the stored substrings furthest from the first unassembled byte
+        RejectNew       //!< keep what is stored and drop the substring that does not fit
+    };
+
+    //! Estimated bookkeeping cost of one stored substring (map node, Buffer and its control block)
+    static constexpr size_t FRAGMENT_OVERHEAD = 96;
+
   private:
     // Your code here -- add private members as necessary.
 
     ByteStream _output;  //!< The reassembled in-order byte stream
     size_t _capacity;    //!< The maximum number of bytes
-    size_t _bytes_in_buffer{0};
+    Engine _engine;      //!< The storage engine for out-of-order bytes
 
     bool _has_eof{false};
     size_t _final_idx{0}; //标记这个字节流的最后一个字符的编号
     
-    //_mapbuffer 允许储存的substring发生重叠现象，它本身是没有容量限制的
-    std::set<std::pair<size_t, std::string>> _mapbuffer{};
+    //! \note 之前使用std::set<std::pair<size_t, std::string>>，允许子串重叠，每次push后都要从头重新扫描，
+    //! 乱序报文段一多就是O(n^2)。现在改为区间map：key是子串的首字节序号，任意两个子串互不重叠，
+    //! 插入时就完成裁剪与合并，单次push只需要O(log n)。value是Buffer：如果数据来自报文段的payload，
+    //! 暂存的只是payload的一个切片，不会拷贝
+    std::map<size_t, Buffer> _mapbuffer{};
+    size_t _unassembled_bytes{0}; //缓存中尚未重组的字节总数(两种引擎共用)，随插入/读出增量维护
+
+    //! \name 乱序数据的内存预算(只对IntervalMap引擎生效，Bitmap引擎的内存本来就是固定的)
+    //! 每个暂存的子串按"字节数 + FRAGMENT_OVERHEAD"计费，这样大量极小的子串也会很快触及预算。
+    //! 暂存的切片所在的存储不会超过切片的两倍(否则存一份拷贝)，所以实际内存不会比计费多出太多
+    //!@{
+    size_t _memory_budget{0};  //0表示不限制
+    EvictionPolicy _eviction{EvictionPolicy::FurthestFirst};
+    size_t _buffered_memory{0};
+    size_t _evicted_fragments{0};
+    size_t _evicted_bytes{0};
+
+    //! 一个暂存子串的计费
+    static size_t fragment_cost(const size_t len) { return len + FRAGMENT_OVERHEAD; }
+
+    //! 从_mapbuffer中删除一个子串并更新计数，返回下一个位置
+    std::map<size_t, Buffer>::iterator erase_fragment(std::map<size_t, Buffer>::iterator it);
+
+    //! FurthestFirst策略：超出预算时从序号最大的子串开始删除
+    void enforce_budget();
+    //!@}
     size_t _first_unassembled{0}; //第一个未被按序接受的字节序号
-    size_t get_first_unacceptable() {
+    size_t get_first_unacceptable() const {
       return _output.remaining_capacity() + _first_unassembled;
     }
 
     /**
-     * 根据_final_idx和_first_unacceptable对数据进行截断
-     * 直接忽略(也就是截断)超出这些范围的字节
+     * 三个push_substring的公共实现
+     * @param data 原始子串，其首字节序号为index
+     * @param owner 如果data来自一个Buffer则指向它(写入_output或暂存时只截取切片)，否则为nullptr
+     * @param staged data开头已经由ByteStream::stage()拷进_output空闲空间的字节数，只需提交
     */
-    std::string truncation_data(const std::string& data, const size_t index);
+    void push_piece(std::string_view data,
+                    const Buffer *owner,
+                    const uint64_t index,
+                    const bool eof,
+                    const size_t staged = 0);
 
     /**
-     * 此函数的作用在于，对于已经截断的数据，判断其是否能直接读出(_output.write())
-     * @return 如果能直接读出(_output.write())，就读出并更新相应变量，并返回true；
-     * 如果不能，返回false，说明该string需要加入缓存或仍需待在缓存里面；
+     * 把[begin, end)范围内的数据(已经截断到窗口之内)存入_mapbuffer
+     * 与已有子串重叠的部分会被裁掉，被新子串完全覆盖的旧子串会被删除，保证_mapbuffer中的子串互不重叠
+     * @param data 原始子串，其首字节序号为index；owner的含义同push_piece
+     * @return 是否存下了新的字节(完全重复、或者因为内存预算被丢弃时为false)
     */
-    bool push_onestr(const std::string &new_data, const size_t index);
+    bool store_substring(std::string_view data, const Buffer *owner, const size_t index, size_t begin, size_t end);
+
+    /**
+     * 从_mapbuffer头部开始，一次遍历把所有与_first_unassembled相连的子串写入_output
+    */
+    void drain_buffered();
+
+    //最近一次存下了新字节的乱序子串的首字节序号，用于把包含它的区间排在SACK块的第一位(RFC 2018)
+    std::optional<size_t> _latest_out_of_order{};
+
+    //! \name Bitmap引擎
+    //! 字节序号为i的字节直接存放在_window[i % _capacity]，_present的第(i % _capacity)位标记该字节是否已收到。
+    //! 由于窗口[_first_unassembled, _first_unacceptable)的长度不超过_capacity，窗口内的字节不会互相覆盖；
+    //! 乱序字节一到达就写在最终位置上，不需要再存一份
+    //!@{
+    std::string _window{};
+    std::vector<uint64_t> _present{};
+
+    //! 把[begin, end)范围内的数据拷贝进_window，并置位对应的_present比特；返回是否有之前没收到的字节
+    bool store_window(std::string_view data, const size_t index, const size_t begin, const size_t end);
+
+    //! 清除[begin, end)对应的_present比特(这些字节已经被直接写入_output)
+    void clear_window(const size_t begin, const size_t end);
+
+    //! 按字扫描_present，把从_first_unassembled开始连续已收到的字节写入_output
+    void drain_window();
+
+    //! 对[pos, pos + len)(不跨越_window末尾)的比特置位或清零，返回状态发生变化的比特数
+    size_t update_bits(size_t pos, size_t len, const bool set);
+
+    //! 从pos开始(最多limit位，不跨越_window末尾)连续置位(set为false时：连续清零)的比特数
+    size_t count_run(size_t pos, const size_t limit, const bool set = true) const;
+    //!@}
 
   public:
     //! \brief Construct a `StreamReassembler` that will store up to `capacity` bytes.
     //! \note This capacity limits both the bytes that have been reassembled,
     //! and those that have not yet been reassembled.
-    StreamReassembler(const size_t capacity);
+    //! \param engine selects how out-of-order bytes are stored (see StreamReassembler::Engine)
+    StreamReassembler(const size_t capacity, const Engine engine = Engine::IntervalMap);
 
     //! \brief Receive a substring and write any newly contiguous bytes into the stream.
     //!
@@ -57,6 +141,20 @@ class StreamReassembler {
     //! \param eof the last byte of `data` will be the last byte in the entire stream
     void push_substring(const std::string &data, const uint64_t index, const bool eof);
 
+    //! \brief Same as above, for data the caller keeps ownership of (it is copied at most once)
+    void push_substring(std::string_view data, const uint64_t index, const bool eof);
+
+    //! \brief Same as above, for a reference-counted payload (e.g. a TCPSegment's)
+    //! \details Bytes are trimmed by offset only; the output stream and the out-of-order storage
+    //! keep slices of `data` instead of copying it, unless the storage itself needs a copy
+    //! (the ring-buffer ByteStream and the Bitmap engine copy each byte into place once).
+    void push_substring(const Buffer &data, const uint64_t index, const bool eof);
+
+    //! \brief Same as above, when the first `staged` bytes of `data` have already been copied into the output
+    //! stream's free space with ByteStream::stage() (possible only if `index` is the first unassembled byte);
+    //! those bytes are committed instead of copied again
+    void push_substring(const Buffer &data, const uint64_t index, const bool eof, const size_t staged);
+
     //! \name Access the reassembled byte stream
     //!@{
     const ByteStream &stream_out() const { return _output; }
@@ -69,6 +167,25 @@ class StreamReassembler {
     //! should only be counted once for the purpose of this function.
     size_t unassembled_bytes() const;
 
+    //! \brief Bound the memory held by out-of-order substrings (IntervalMap engine only)
+    //! \param budget maximum bytes, counting FRAGMENT_OVERHEAD per stored substring; 0 means unlimited
+    //! \param policy which substrings to drop when the budget would be exceeded
+    //! \note Dropped bytes are simply not acknowledged, so the peer will retransmit them.
+    void set_memory_budget(const size_t budget, const EvictionPolicy policy = EvictionPolicy::FurthestFirst);
+
+    //! \name Memory accounting for out-of-order substrings
+    //!@{
+    size_t buffered_memory() const { return _buffered_memory; }      //!< Bytes charged against the budget
+    size_t evicted_fragments() const { return _evicted_fragments; }  //!< Substrings dropped by the budget
+    size_t evicted_bytes() const { return _evicted_bytes; }          //!< Bytes dropped by the budget
+    //!@}
+
+    //! \brief The stored out-of-order bytes as [begin, end) ranges of stream indices, e.g. for SACK
+    //! \details Adjacent substrings are merged into one range. The range holding the most recently
+    //! stored substring comes first (as RFC 2018 asks of SACK blocks), the rest in increasing order.
+    //! \param max_blocks return at most this many ranges
+    std::vector<std::pair<uint64_t, uint64_t>> sack_ranges(const size_t max_blocks) const;
+
     //! \brief Is the internal state empty (other than the output stream)?
     //! \returns `true` if no substrings are waiting to be assembled
     bool empty() const;
@@ -27,11 +27,33 @@ size_t TCPConnection::time_since_last_segment_received() const { return _time_si
 void TCPConnection::segment_received(const TCPSegment &seg) {
     //如果连接已经被杀掉了，就直接返回
     if (!active()) return;
+    //解析时推迟了校验和的报文段：先核对(按序的负载顺便拷进接收字节流)，不对就当没收到过
+    if (!_receiver.verify_checksum(seg)) return;
     //接受到任何报文段，都可以把计时器刷新，即刚刚(0ms前)接受了新的报文段
     _time_since_last_segrecv = 0;
 
+    //对方的SYN带有SACK-permitted选项，并且我们也愿意使用SACK
+    if (seg.header().syn && seg.header().sack_permitted && _cfg.sack) _sack_agreed = true;
+    //窗口扩大选项同理；只有收到对方的SYN之后才知道它的位移量
+    if (seg.header().syn && seg.header().window_scale.has_value() && _cfg.window_scaling) {
+        _window_scaling_agreed = true;
+        _snd_wscale = seg.header().window_scale.value();
+        _rcv_wscale = receive_window_shift();
+    }
+    if (seg.header().syn && seg.header().timestamps.has_value() && _cfg.timestamps) _timestamps_agreed = true;
+
+    //记下收到之前的ackno和乱序字节数，用来判断这个报文段是不是正好按序到达
+    const optional<WrappingInt32> ackno_before = _receiver.ackno();
+    const size_t unassembled_before = _receiver.unassembled_bytes();
+
     //把报文段交给TCPReceiver
-    _receiver.segment_received(seg);
+    //被PAWS丢弃的报文段是序列号绕回之前的过时副本，其中的ack、窗口、SACK块和TSecr都不可信，
+    //不能交给TCPSender(否则会确认没有确认过的数据、得到错误的RTT样本)，只回复一个ACK(RFC 7323 5.3节)
+    if (!_receiver.segment_received(seg)) {
+        _sender.send_empty_segment();
+        send_all();
+        return;
+    }
 
     //! \bug 收到rst报文段就进行unclean shutdown
     //! \bug 只不过收到rst报文段时无需发送rst报文段
@@ -42,7 +64,20 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
 
     //如果ack被设置，将报文段中的ackno和window_size交给TCPSender
     if (seg.header().ack) {
-        _sender.ack_received(seg.header().ackno, seg.header().win);    
+        //SACK块要在处理ack之前记入记分板，这样重复ack触发的重传才能跳过对方已经收到的报文段
+        if (_sack_agreed && !seg.header().sack_blocks.empty()) _sender.sack_received(seg.header().sack_blocks);
+        //TSecr回显的是我们发出某个报文段时的时钟，二者之差就是RTT(按模2^32计算)
+        if (_timestamps_agreed && seg.header().timestamps.has_value()) {
+            _sender.timestamp_echo(static_cast<uint32_t>(_clock_ms - seg.header().timestamps.value().ecr));
+        }
+        //窗口字段按对方的位移量扩大(SYN报文段除外)
+        const uint64_t window = _window_scaling_agreed && !seg.header().syn
+                                    ? static_cast<uint64_t>(seg.header().win) << _snd_wscale
+                                    : seg.header().win;
+        //携带数据(或SYN/FIN)的报文段上的ack不算重复ack
+        _sender.ack_received(seg.header().ackno, window, seg.length_in_sequence_space() == 0);
+        //Nagle算法扣下的小报文段等的就是在途数据被确认，确认到了就再试一次
+        if (_sender.small_segment_held()) _sender.fill_window();
     }
 
     //! \bug 判断此处是否需要将_linger_after_streams_finish设置为false
@@ -70,7 +105,21 @@ void TCPConnection::segment_received(const TCPSegment &seg) {
     }
 
     //在报文段占用序号大于等于1的情况, 并且当前没有待发送的报文段，就创建一个空的ACK报文段
-    if (_sender.segments_out().empty()) _sender.send_empty_segment(); 
+    if (_sender.segments_out().empty()) {
+        //延迟确认：只有恰好按序到达、不带SYN/FIN、也没有填补空洞的数据才能推迟确认
+        //乱序数据、重复数据要立即确认，这样对方才能及时凭重复ack快速重传
+        const bool in_order = ackno_before.has_value() && !seg.header().syn && !seg.header().fin &&
+                              unassembled_before == 0 && _receiver.unassembled_bytes() == 0 &&
+                              _receiver.ackno().value() - ackno_before.value() ==
+                                  static_cast<int32_t>(seg.length_in_sequence_space());
+        if (_cfg.delayed_ack && in_order) {
+            if (_bytes_unacked == 0) _ack_delay_elapsed = 0;
+            _bytes_unacked += seg.payload().size();
+            //每收到两个满载报文段至少确认一次
+            if (_bytes_unacked < 2 * TCPConfig::MAX_PAYLOAD_SIZE) return;
+        }
+        _sender.send_empty_segment();
+    }
     //此函数会将_sender中发送队列的所有报文段发出，可让对方得知当前的ackno和window_size
     send_all();
  }
@@ -90,11 +139,21 @@ size_t TCPConnection::write(const string &data) {
     return written_size;
 }
 
+size_t TCPConnection::write(Buffer data) {
+    //与上面相同，只是Chunked模式的outbound stream直接持有这个Buffer
+    const size_t written_size = _sender.stream_in().write(move(data));
+    _sender.fill_window();
+    send_all();
+    return written_size;
+}
+
 //! \param[in] ms_since_last_tick number of milliseconds since the last call to this method
 void TCPConnection::tick(const size_t ms_since_last_tick) { 
     //1:告知TCPSender时间的流逝，并记录接收到上个报文段后过去了多久
+    _clock_ms += ms_since_last_tick;
     _sender.tick(ms_since_last_tick);
     _time_since_last_segrecv += ms_since_last_tick;
+    _ack_delay_elapsed += ms_since_last_tick;
 
     //2:如果连续重传次数超出上限，首先需要[终止连接]，然后发送带有RST的空报文段
     if (_sender.consecutive_retransmissions() > TCPConfig::MAX_RETX_ATTEMPTS) {
@@ -107,6 +166,10 @@ void TCPConnection::tick(const size_t ms_since_last_tick) {
      * BUG: 这里绝对不能发送SYN或者SYNACK报文段
     */
     if (_sender.syn_sent()) _sender.fill_window();
+    //被推迟的ACK等到了时限，又没有数据报文段可以捎带它，就单独发一个空报文段
+    if (_bytes_unacked > 0 && _ack_delay_elapsed >= _cfg.delayed_ack_timeout && _sender.segments_out().empty()) {
+        _sender.send_empty_segment();
+    }
     send_all();
 
     //3:在必要的情况下结束此次连接，CLEANEY
@@ -134,6 +197,19 @@ void TCPConnection::end_input_stream() {
     send_all();
 }
 
+void TCPConnection::set_nodelay(const bool nodelay) {
+    _sender.set_nagle(!nodelay);
+    //关掉Nagle算法之后，之前扣下的小报文段可以立即发出
+    if (_sender.syn_sent()) _sender.fill_window();
+    send_all();
+}
+
+void TCPConnection::uncork() {
+    _sender.set_corked(false);
+    if (_sender.syn_sent()) _sender.fill_window();
+    send_all();
+}
+
 void TCPConnection::connect() {
     //初始阶段，_sender只会发送一个SYN报文段以建立连接
     _sender.fill_window();
@@ -148,8 +224,38 @@ void TCPConnection::handle_sender_segment(TCPSegment& sender_segment) {
         sender_segment.header().ackno = _receiver.ackno().value(); 
     }
     //可能出错的逻辑：无论如何，都把窗口大小设置上，注意窗口大小是16位，因此存在上限
-    sender_segment.header().win = _receiver.window_size() > numeric_limits<uint16_t>::max() ? 
-                               numeric_limits<uint16_t>::max() : _receiver.window_size();
+    //协商了窗口扩大选项时先右移(向下取整，不会通告超出实际容量的窗口)；SYN报文段的窗口从不缩放
+    const size_t window = _window_scaling_agreed && !sender_segment.header().syn
+                              ? _receiver.window_size() >> _rcv_wscale
+                              : _receiver.window_size();
+    sender_segment.header().win = window > numeric_limits<uint16_t>::max() ? 
+                               numeric_limits<uint16_t>::max() : window;
+    //SYN提出使用SACK；SYNACK只有在对方的SYN也提出了时才回应(RFC 2018)
+    //协商成功之后，每个报文段都用SACK块告诉对方已经收到的乱序数据
+    if (sender_segment.header().syn) {
+        sender_segment.header().sack_permitted = _cfg.sack && (!sender_segment.header().ack || _sack_agreed);
+        if (_cfg.window_scaling && (!sender_segment.header().ack || _window_scaling_agreed)) {
+            sender_segment.header().window_scale = receive_window_shift();
+        }
+    } else if (_sack_agreed) {
+        //时间戳选项占去12字节之后，选项空间只够放3个SACK块
+        sender_segment.header().sack_blocks =
+            _receiver.sack_blocks(_timestamps_agreed ? TCPHeader::MAX_SACK_BLOCKS - 1 : TCPHeader::MAX_SACK_BLOCKS);
+    }
+    const bool stamp = sender_segment.header().syn ? _cfg.timestamps && (!sender_segment.header().ack || _timestamps_agreed)
+                                                   : _timestamps_agreed;
+    if (stamp) {
+        const uint32_t echo = sender_segment.header().ack ? _receiver.ts_recent().value_or(0) : 0;
+        sender_segment.header().timestamps = TCPHeader::Timestamps{static_cast<uint32_t>(_clock_ms), echo};
+    }
+}
+
+uint8_t TCPConnection::receive_window_shift() const {
+    uint8_t shift = 0;
+    while (shift < TCPHeader::MAX_WINDOW_SCALE && (_cfg.recv_capacity >> shift) > numeric_limits<uint16_t>::max()) {
+        shift++;
+    }
+    return shift;
 }
 
 void TCPConnection::send_all() {
@@ -161,6 +267,8 @@ void TCPConnection::send_all() {
         handle_sender_segment(segment); 
         //然后“发送”出该报文段
         _segments_out.push(segment);
+        //每个报文段都带着最新的ackno，被推迟的ACK也就随之发出了
+        _bytes_unacked = 0;
     }    
 }
 
@@ -10,8 +10,8 @@
 class TCPConnection {
   private:
     TCPConfig _cfg;
-    TCPReceiver _receiver{_cfg.recv_capacity};
-    TCPSender _sender{_cfg.send_capacity, _cfg.rt_timeout, _cfg.fixed_isn};
+    TCPReceiver _receiver{_cfg};
+    TCPSender _sender{_cfg};
     /**
      * @attention _sender的ByteStream对应outBoundStream
      * @attention _receiver对应的是inBoundStream
@@ -31,6 +31,33 @@ class TCPConnection {
     //接收到上个报文段时过去了多久？
     size_t _time_since_last_segrecv{0};
 
+    //双方的SYN都带有SACK-permitted选项时才使用SACK：发出的ack附带SACK块，收到的SACK块交给TCPSender
+    bool _sack_agreed{false};
+
+    //! \name 窗口扩大选项(RFC 7323)
+    //! 双方的SYN都带有该选项时才生效；SYN报文段本身的窗口字段从不缩放
+    //!@{
+    bool _window_scaling_agreed{false};
+    uint8_t _snd_wscale{0};  //对方通告的窗口需要左移的位数(对方SYN中的选项)
+    uint8_t _rcv_wscale{0};  //我们通告的窗口需要右移的位数(我们SYN中的选项)
+
+    //能让recv_capacity放进16位窗口字段的最小位移量
+    uint8_t receive_window_shift() const;
+    //!@}
+
+    //双方的SYN都带有时间戳选项时，每个报文段都带上TSval(_clock_ms)和TSecr(TCPReceiver的TS.Recent)
+    bool _timestamps_agreed{false};
+
+    //连接的时钟：所有tick累积经过的毫秒数，用作时间戳选项的TSval
+    uint64_t _clock_ms{0};
+
+    //! \name 延迟确认(RFC 1122 4.2.3.2)
+    //! 按序到达的数据先不确认：攒够两个满载报文段，或者计时器到期，或者有报文段可以捎带ack时才确认
+    //!@{
+    size_t _bytes_unacked{0};       //还没有确认过的按序数据字节数，大于0表示有一个ACK被推迟了
+    size_t _ack_delay_elapsed{0};   //被推迟的ACK已经等了多少毫秒
+    //!@}
+
     //使用状态变量来维护是否保持_active的状态
     //由于初始读入和读出字节流都在运行，因此初始是true
     bool _active{true};
@@ -46,12 +73,26 @@ class TCPConnection {
     //! \returns the number of bytes from `data` that were actually written.
     size_t write(const std::string &data);
 
+    //! \brief Write a Buffer to the outbound byte stream (kept by reference, without a copy), and send it
+    //! \returns the number of bytes from `data` that were actually written.
+    size_t write(Buffer data);
+
     //! \returns the number of `bytes` that can be written right now.
     //! ALERT!::此函数的实现可能是错误的！
     size_t remaining_outbound_capacity() const;
 
     //! \brief Shut down the outbound byte stream (still allows reading incoming data)
     void end_input_stream();
+
+    //! \brief Turn Nagle's algorithm off (`true`) or on (`false`), like the TCP_NODELAY socket option
+    void set_nodelay(const bool nodelay);
+
+    //! \brief Hold back partial segments until uncork(), so that several small writes share segments
+    //! (like the TCP_CORK socket option)
+    void cork() { _sender.set_corked(true); }
+
+    //! \brief Send whatever cork() held back
+    void uncork();
     //!@}
 
     //! \name "Output" interface for the reader
@@ -70,6 +111,18 @@ class TCPConnection {
     size_t unassembled_bytes() const;
     //! \brief Number of milliseconds since the last segment was received
     size_t time_since_last_segment_received() const;
+    //! \brief the sending half of the connection (RTT estimates, RTO, congestion window)
+    const TCPSender &sender() const { return _sender; }
+    //! \brief did both SYNs carry the SACK-permitted option?
+    bool sack_agreed() const { return _sack_agreed; }
+    //! \brief did both SYNs carry the window scale option?
+    bool window_scaling_agreed() const { return _window_scaling_agreed; }
+    //! \brief did both SYNs carry the timestamps option?
+    bool timestamps_agreed() const { return _timestamps_agreed; }
+    //! \brief Milliseconds until pacing lets the next segment go, if it is holding data back
+    std::optional<uint64_t> time_until_next_send() const { return _sender.time_until_next_send(); }
+    //! \brief the receiving half of the connection (e.g. for its PAWS counter)
+    const TCPReceiver &receiver() const { return _receiver; }
     //!< \brief summarize the state of the sender, receiver, and the connection
     TCPState state() const { return {_sender, _receiver, active(), _linger_after_streams_finish}; };
     //!@}
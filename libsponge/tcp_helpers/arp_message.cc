@@ -1,41 +1,41 @@
 #include "arp_message.hh"
 
+#include <algorithm>
 #include <arpa/inet.h>
 #include <iomanip>
 #include <sstream>
 
 using namespace std;
 
-ParseResult ARPMessage::parse(const Buffer buffer) {
-    NetParser p{buffer};
+ParseResult ARPMessage::parse(Buffer buffer) {
+    NetParser p{move(buffer)};
 
-    if (p.buffer().size() < ARPMessage::LENGTH) {
-        return ParseResult::PacketTooShort;
+    const auto h = p.header<ARPMessage::LENGTH>();
+    if (not h) {
+        return p.get_error();
     }
 
-    hardware_type = p.u16();
-    protocol_type = p.u16();
-    hardware_address_size = p.u8();
-    protocol_address_size = p.u8();
-    opcode = p.u16();
+    hardware_type = h->u16<0>();
+    protocol_type = h->u16<2>();
+    hardware_address_size = h->u8<4>();
+    protocol_address_size = h->u8<5>();
+    opcode = h->u16<6>();
 
     if (not supported()) {
         return ParseResult::Unsupported;
     }
 
     // read sender addresses (Ethernet and IP)
-    for (auto &byte : sender_ethernet_address) {
-        byte = p.u8();
-    }
-    sender_ip_address = p.u32();
+    const auto sender_bytes = h->bytes<8, sizeof(sender_ethernet_address)>();
+    copy(sender_bytes.begin(), sender_bytes.end(), sender_ethernet_address.begin());
+    sender_ip_address = h->u32<14>();
 
     // read target addresses (Ethernet and IP)
-    for (auto &byte : target_ethernet_address) {
-        byte = p.u8();
-    }
-    target_ip_address = p.u32();
+    const auto target_bytes = h->bytes<18, sizeof(target_ethernet_address)>();
+    copy(target_bytes.begin(), target_bytes.end(), target_ethernet_address.begin());
+    target_ip_address = h->u32<24>();
 
-    return p.get_error();
+    return ParseResult::NoError;
 }
 
 bool ARPMessage::supported() const {
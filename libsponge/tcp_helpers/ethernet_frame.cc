@@ -8,8 +8,8 @@
 
 using namespace std;
 
-ParseResult EthernetFrame::parse(const Buffer buffer) {
-    NetParser p{buffer};
+ParseResult EthernetFrame::parse(Buffer buffer) {
+    NetParser p{move(buffer)};
     _header.parse(p);
     _payload = p.buffer();
 
@@ -2,49 +2,61 @@
 
 #include "util.hh"
 
+#include <algorithm>
 #include <iomanip>
 #include <sstream>
+#include <stdexcept>
 
 using namespace std;
 
 ParseResult EthernetHeader::parse(NetParser &p) {
-    if (p.buffer().size() < EthernetHeader::LENGTH) {
-        return ParseResult::PacketTooShort;
+    const auto h = p.header<EthernetHeader::LENGTH>();
+    if (not h) {
+        return p.get_error();
     }
 
     /* read destination address */
-    for (auto &byte : dst) {
-        byte = p.u8();
-    }
+    const auto dst_bytes = h->bytes<0, sizeof(dst)>();
+    copy(dst_bytes.begin(), dst_bytes.end(), dst.begin());
 
     /* read source address */
-    for (auto &byte : src) {
-        byte = p.u8();
-    }
+    const auto src_bytes = h->bytes<sizeof(dst), sizeof(src)>();
+    copy(src_bytes.begin(), src_bytes.end(), src.begin());
 
     /* read the frame's type (e.g. IPv4, ARP, or something else) */
-    type = p.u16();
+    type = h->u16<sizeof(dst) + sizeof(src)>();
 
-    return p.get_error();
+    return ParseResult::NoError;
 }
 
-string EthernetHeader::serialize() const {
-    string ret;
-    ret.reserve(LENGTH);
+//! \param[out] out receives the header; it must have room for `size` bytes
+//! \returns the number of bytes written, i.e. LENGTH
+size_t EthernetHeader::serialize_into(char *const out, const size_t size) const {
+    if (LENGTH > size) {
+        throw runtime_error("EthernetHeader::serialize_into: buffer too small");
+    }
+
+    char *cursor = out;
 
     /* write destination address */
     for (auto &byte : dst) {
-        NetUnparser::u8(ret, byte);
+        NetUnparser::u8(cursor, byte);
     }
 
     /* write source address */
     for (auto &byte : src) {
-        NetUnparser::u8(ret, byte);
+        NetUnparser::u8(cursor, byte);
     }
 
     /* write the frame's type (e.g. IPv4, ARP or something else) */
-    NetUnparser::u16(ret, type);
+    NetUnparser::u16(cursor, type);
 
+    return LENGTH;
+}
+
+string EthernetHeader::serialize() const {
+    string ret(LENGTH, 0);
+    serialize_into(ret.data(), ret.size());
     return ret;
 }
 
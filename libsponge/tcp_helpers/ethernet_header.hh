@@ -33,6 +33,9 @@ struct EthernetHeader {
     //! Serialize the Ethernet fields to a string
     std::string serialize() const;
 
+    //! Serialize the Ethernet fields into a caller-provided buffer of `size` bytes (e.g. on the stack)
+    size_t serialize_into(char *const out, const size_t size) const;
+
     //! Return a string containing a header in human-readable format
     std::string to_string() const;
 };
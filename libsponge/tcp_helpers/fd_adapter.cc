@@ -1,12 +1,15 @@
 #include "fd_adapter.hh"
 
+#include "packet_builder.hh"
+#include "tcp_config.hh"
+
 #include <iostream>
 #include <stdexcept>
 #include <utility>
 
 using namespace std;
 
-//! \details This function first attempts to parse a TCP segment from the next UDP
+//! \details This function first attempts to parse a TCP segment from a UDP
 //! payload recv()d from the socket.
 //!
 //! If this succeeds, it then checks that the received segment is related to the
@@ -18,17 +21,16 @@ using namespace std;
 //! `_listen` flag and calls calls connect() on the underlying UDP socket, with
 //! the result that future outgoing segments go to the sender of the SYN segment.
 //! \returns a std::optional<TCPSegment> that is empty if the segment was invalid or unrelated
-optional<TCPSegment> TCPOverUDPSocketAdapter::read() {
-    auto datagram = _sock.recv();
-
+optional<TCPSegment> TCPOverUDPSocketAdapter::_accept(UDPSocket::received_buffer datagram) {
     // is it for us?
     if (not listening() and (datagram.source_address != config().destination)) {
         return {};
     }
 
-    // is the payload a valid TCP segment?
+    // is the payload a valid TCP segment? (with defer_checksum, the TCPConnection checks the payload's checksum
+    // while copying it; a SYN that we might start listening to is always checked here)
     TCPSegment seg;
-    if (ParseResult::NoError != seg.parse(move(datagram.payload), 0)) {
+    if (ParseResult::NoError != seg.parse(move(datagram.payload), 0, config().defer_checksum and not listening())) {
         return {};
     }
 
@@ -50,7 +52,18 @@ optional<TCPSegment> TCPOverUDPSocketAdapter::read() {
 void TCPOverUDPSocketAdapter::write(TCPSegment &seg) {
     seg.header().sport = config().source.port();
     seg.header().dport = config().destination.port();
-    _sock.sendto(config().destination, seg.serialize(0));
+    if (seg.payload().size() <= TCPConfig::MAX_PAYLOAD_SIZE) {
+        // the header is built on the stack and sent together with the payload, in place
+        PacketBuilder packet;
+        packet.tcp(seg.header(), seg.payload());
+        _sock.sendto(config().destination, packet.views());
+        return;
+    }
+
+    // segmentation offload: split a large segment into wire-sized datagrams here
+    for (const auto &piece : seg.serialize_segmented(TCPConfig::MAX_PAYLOAD_SIZE, [](size_t) { return 0; })) {
+        _sock.sendto(config().destination, piece);
+    }
 }
 
 //! Specialize LossyFdAdapter to TCPOverUDPSocketAdapter
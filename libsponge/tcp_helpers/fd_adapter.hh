@@ -10,6 +10,7 @@
 
 #include <optional>
 #include <utility>
+#include <vector>
 
 //! \brief Basic functionality for file descriptor adaptors
 //! \details See TCPOverUDPSocketAdapter and TCPOverIPv4OverTunFdAdapter for more information.
@@ -21,6 +22,26 @@ class FdAdapterBase {
   protected:
     FdAdapterConfig &config_mutable() { return _cfg; }
 
+    //! \brief Read packets with `try_read` until none is waiting (at most `max_reads`), and give each to `accept`
+    //! \details `try_read` must not block: it returns nothing once no packet is left, so a burst of packets costs one
+    //! failed read at its end (rather than a poll() before every read).
+    //! \returns the segments that `accept` returned, in arrival order
+    template <typename TryReadT, typename AcceptT>
+    static std::vector<TCPSegment> read_while_ready(const size_t max_reads, TryReadT &&try_read, AcceptT &&accept) {
+        std::vector<TCPSegment> ret;
+        for (size_t i = 0; i < max_reads; i++) {
+            auto packet = try_read();
+            if (not packet) {
+                break;
+            }
+            auto seg = accept(std::move(packet.value()));
+            if (seg) {
+                ret.push_back(std::move(seg.value()));
+            }
+        }
+        return ret;
+    }
+
   public:
     //! \brief Set the listening flag
     //! \param[in] l is the new value for the flag
@@ -47,12 +68,22 @@ class TCPOverUDPSocketAdapter : public FdAdapterBase {
   private:
     UDPSocket _sock;
 
+    //! The TCP segment in a received datagram, if it is valid and related to the current connection
+    std::optional<TCPSegment> _accept(UDPSocket::received_buffer datagram);
+
   public:
     //! Construct from a UDPSocket sliced into a FileDescriptor
     explicit TCPOverUDPSocketAdapter(UDPSocket &&sock) : _sock(std::move(sock)) {}
 
     //! Attempts to read and return a TCP segment related to the current connection from a UDP payload
-    std::optional<TCPSegment> read();
+    std::optional<TCPSegment> read() { return _accept(_sock.recv_pooled()); }
+
+    //! \brief Reads the datagrams that are waiting, without blocking
+    //! \returns the segments related to the current connection, in arrival order
+    std::vector<TCPSegment> read_many(const size_t max_datagrams) {
+        return read_while_ready(
+            max_datagrams, [&] { return _sock.try_recv_pooled(); }, [&](auto datagram) { return _accept(std::move(datagram)); });
+    }
 
     //! Writes a TCP segment into a UDP payload
     void write(TCPSegment &seg);
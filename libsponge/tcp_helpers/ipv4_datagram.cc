@@ -8,8 +8,8 @@
 
 using namespace std;
 
-ParseResult IPv4Datagram::parse(const Buffer buffer) {
-    NetParser p{buffer};
+ParseResult IPv4Datagram::parse(Buffer buffer) {
+    NetParser p{move(buffer)};
     _header.parse(p);
     _payload = p.buffer();
 
@@ -25,17 +25,19 @@ BufferList IPv4Datagram::serialize() const {
         throw runtime_error("IPv4Datagram::serialize: payload is wrong size");
     }
 
-    IPv4Header header_out = _header;
-    header_out.cksum = 0;
-    const string header_zero_checksum = header_out.serialize();
+    // serialize the header once and patch the checksum in afterwards (the sum is taken with the field zeroed)
+    string header = _header.serialize();
+    header[10] = header[11] = 0;
 
     // calculate checksum -- taken over header only
     InternetChecksum check;
-    check.add(header_zero_checksum);
-    header_out.cksum = check.value();
+    check.add(header);
+    const uint16_t cksum = check.value();
+    header[10] = static_cast<char>(cksum >> 8);
+    header[11] = static_cast<char>(cksum);
 
-    BufferList ret;
-    ret.append(header_out.serialize());
+    // the payload (e.g. a serialized TCPSegment) is referenced, not copied
+    BufferList ret{move(header)};
     ret.append(_payload);
     return ret;
 }
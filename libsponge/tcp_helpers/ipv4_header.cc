@@ -2,6 +2,7 @@
 
 #include "util.hh"
 
+#include <algorithm>
 #include <arpa/inet.h>
 #include <iomanip>
 #include <sstream>
@@ -21,30 +22,32 @@ using namespace std;
 //! - there is less data in the full datagram than the `len` field claims
 //! - the checksum is bad
 ParseResult IPv4Header::parse(NetParser &p) {
-    Buffer original_serialized_version = p.buffer();
+    // the header is checksummed where it lies, so remember where it starts
+    const string_view original_serialized_version = p.unparsed();
+    const size_t data_size = original_serialized_version.size();
 
-    const size_t data_size = p.buffer().size();
-    if (data_size < IPv4Header::LENGTH) {
-        return ParseResult::PacketTooShort;
+    const auto h = p.header<IPv4Header::LENGTH>();
+    if (not h) {
+        return p.get_error();
     }
 
-    const uint8_t first_byte = p.u8();
+    const uint8_t first_byte = h->u8<0>();
     ver = first_byte >> 4;     // version
     hlen = first_byte & 0x0f;  // header length
-    tos = p.u8();              // type of service
-    len = p.u16();             // length
-    id = p.u16();              // id
+    tos = h->u8<1>();          // type of service
+    len = h->u16<2>();         // length
+    id = h->u16<4>();          // id
 
-    const uint16_t fo_val = p.u16();
+    const uint16_t fo_val = h->u16<6>();
     df = static_cast<bool>(fo_val & 0x4000);  // don't fragment
     mf = static_cast<bool>(fo_val & 0x2000);  // more fragments
     offset = fo_val & 0x1fff;                 // offset
 
-    ttl = p.u8();     // ttl
-    proto = p.u8();   // proto
-    cksum = p.u16();  // checksum
-    src = p.u32();    // source address
-    dst = p.u32();    // destination address
+    ttl = h->u8<8>();      // ttl
+    proto = h->u8<9>();    // proto
+    cksum = h->u16<10>();  // checksum
+    src = h->u32<12>();    // source address
+    dst = h->u32<16>();    // destination address
 
     if (data_size < 4 * hlen) {
         return ParseResult::PacketTooShort;
@@ -66,7 +69,7 @@ ParseResult IPv4Header::parse(NetParser &p) {
     }
 
     InternetChecksum check;
-    check.add({original_serialized_version.str().data(), size_t(4 * hlen)});
+    check.add(original_serialized_version.substr(0, 4 * hlen));
     if (check.value()) {
         return ParseResult::BadChecksum;
     }
@@ -75,7 +78,9 @@ ParseResult IPv4Header::parse(NetParser &p) {
 }
 
 //! Serialize the IPv4Header to a string (does not recompute the checksum)
-string IPv4Header::serialize() const {
+//! \param[out] out receives the header; it must have room for `size` bytes
+//! \returns the number of bytes written, i.e. 4 * hlen
+size_t IPv4Header::serialize_into(char *const out, const size_t size) const {
     // sanity checks
     if (ver != 4) {
         throw runtime_error("wrong IP version");
@@ -84,28 +89,37 @@ string IPv4Header::serialize() const {
         throw runtime_error("IP header too short");
     }
 
-    string ret;
-    ret.reserve(4 * hlen);
+    if (4 * size_t{hlen} > size) {
+        throw runtime_error("IPv4Header::serialize_into: buffer too small");
+    }
+
+    char *cursor = out;
 
     const uint8_t first_byte = (ver << 4) | (hlen & 0xf);
-    NetUnparser::u8(ret, first_byte);  // version and header length
-    NetUnparser::u8(ret, tos);         // type of service
-    NetUnparser::u16(ret, len);        // length
-    NetUnparser::u16(ret, id);         // id
+    NetUnparser::u8(cursor, first_byte);  // version and header length
+    NetUnparser::u8(cursor, tos);         // type of service
+    NetUnparser::u16(cursor, len);        // length
+    NetUnparser::u16(cursor, id);         // id
 
     const uint16_t fo_val = (df ? 0x4000 : 0) | (mf ? 0x2000 : 0) | (offset & 0x1fff);
-    NetUnparser::u16(ret, fo_val);  // flags and offset
+    NetUnparser::u16(cursor, fo_val);  // flags and offset
+
+    NetUnparser::u8(cursor, ttl);    // time to live
+    NetUnparser::u8(cursor, proto);  // protocol number
 
-    NetUnparser::u8(ret, ttl);    // time to live
-    NetUnparser::u8(ret, proto);  // protocol number
+    NetUnparser::u16(cursor, cksum);  // checksum
 
-    NetUnparser::u16(ret, cksum);  // checksum
+    NetUnparser::u32(cursor, src);  // src address
+    NetUnparser::u32(cursor, dst);  // dst address
 
-    NetUnparser::u32(ret, src);  // src address
-    NetUnparser::u32(ret, dst);  // dst address
+    fill(cursor, out + 4 * hlen, 0);  // expand header to advertised size
 
-    ret.resize(4 * hlen);  // expand header to advertised size
+    return 4 * hlen;
+}
 
+string IPv4Header::serialize() const {
+    string ret(4 * size_t{hlen}, 0);
+    serialize_into(ret.data(), ret.size());
     return ret;
 }
 
@@ -7,6 +7,7 @@
 //! \note IP options are not supported
 struct IPv4Header {
     static constexpr size_t LENGTH = 20;         //!< [IPv4](\ref rfc::rfc791) header length, not including options
+    static constexpr size_t MAX_LENGTH = 60;     //!< header length including the largest possible options
     static constexpr uint8_t DEFAULT_TTL = 128;  //!< A reasonable default TTL value
     static constexpr uint8_t PROTO_TCP = 6;      //!< Protocol number for [tcp](\ref rfc::rfc793)
 
@@ -54,6 +55,9 @@ struct IPv4Header {
     //! 将IP首部字节序列化成字符串
     std::string serialize() const;
 
+    //! Serialize the IP fields into a caller-provided buffer of `size` bytes (e.g. on the stack)
+    size_t serialize_into(char *const out, const size_t size) const;
+
     //! Length of the payload
     uint16_t payload_length() const;
 
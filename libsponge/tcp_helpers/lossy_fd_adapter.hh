@@ -6,9 +6,11 @@
 #include "tcp_segment.hh"
 #include "util.hh"
 
+#include <algorithm>
 #include <optional>
 #include <random>
 #include <utility>
+#include <vector>
 
 //! An adapter class that adds random dropping behavior to an FD adapter
 template <typename AdapterT>
@@ -47,9 +49,25 @@ class LossyFdAdapter {
         return ret;
     }
 
+    //! \brief Read a batch from the underlying AdapterT instance, dropping each datagram independently
+    //! \returns the segments that were not dropped, in arrival order
+    std::vector<TCPSegment> read_many(const size_t max_datagrams) {
+        auto ret = _adapter.read_many(max_datagrams);
+        ret.erase(std::remove_if(ret.begin(), ret.end(), [&](const TCPSegment &) { return _should_drop(false); }),
+                  ret.end());
+        return ret;
+    }
+
     //! \brief Write to the underlying AdapterT instance, potentially dropping the datagram to be written
     //! \param[in] seg is the packet to either write or drop
     void write(TCPSegment &seg) {
+        // a large (segmentation offload) segment is split first, so that each wire segment can be lost on its own
+        if (seg.payload().size() > TCPConfig::MAX_PAYLOAD_SIZE) {
+            for (auto &piece : seg.split(TCPConfig::MAX_PAYLOAD_SIZE)) {
+                write(piece);
+            }
+            return;
+        }
         if (_should_drop(true)) {
             return;
         }
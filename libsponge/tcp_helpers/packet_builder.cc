@@ -0,0 +1,58 @@
+#include "packet_builder.hh"
+
+#include "parser.hh"
+#include "util.hh"
+
+using namespace std;
+
+void PacketBuilder::_append_tcp(const TCPHeader &tcp, const uint32_t datagram_layer_checksum) {
+    char *const out = _headers.data() + _length;
+    const size_t len = tcp.serialize_into(out, _headers.size() - _length);
+
+    // checksum over the header (with the checksum field zeroed) and the payload, patched in place
+    store_big_endian<uint16_t>(out + 16, 0);
+    InternetChecksum check(datagram_layer_checksum);
+    check.add({out, len});
+    check.add(_payload);
+    store_big_endian(out + 16, check.value());
+
+    _length += len;
+}
+
+uint32_t PacketBuilder::_append_ipv4(IPv4Header ip, const size_t tcp_length) {
+    ip.proto = IPv4Header::PROTO_TCP;
+    ip.len = ip.hlen * 4 + tcp_length + _payload.size();
+    ip.cksum = 0;
+
+    char *const out = _headers.data() + _length;
+    const size_t len = ip.serialize_into(out, _headers.size() - _length);
+
+    // checksum over the header only
+    InternetChecksum check;
+    check.add({out, len});
+    store_big_endian(out + 10, check.value());
+
+    _length += len;
+    return ip.pseudo_cksum();
+}
+
+void PacketBuilder::tcp(const TCPHeader &tcp, const string_view payload, const uint32_t datagram_layer_checksum) {
+    _length = 0;
+    _payload = payload;
+    _append_tcp(tcp, datagram_layer_checksum);
+}
+
+void PacketBuilder::tcp_in_ipv4(const IPv4Header &ip, const TCPHeader &tcp, const string_view payload) {
+    _length = 0;
+    _payload = payload;
+    _append_tcp(tcp, _append_ipv4(ip, tcp.length()));
+}
+
+void PacketBuilder::tcp_in_ipv4_in_ethernet(const EthernetHeader &eth,
+                                            const IPv4Header &ip,
+                                            const TCPHeader &tcp,
+                                            const string_view payload) {
+    _length = eth.serialize_into(_headers.data(), _headers.size());
+    _payload = payload;
+    _append_tcp(tcp, _append_ipv4(ip, tcp.length()));
+}
@@ -0,0 +1,59 @@
+#ifndef SPONGE_LIBSPONGE_PACKET_BUILDER_HH
+#define SPONGE_LIBSPONGE_PACKET_BUILDER_HH
+
+#include "buffer.hh"
+#include "ethernet_header.hh"
+#include "ipv4_header.hh"
+#include "tcp_header.hh"
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+//! \brief Lays out the headers of an outgoing TCP packet contiguously in one fixed-size buffer
+//! \details The Ethernet, IPv4 and TCP headers (whichever are present) are serialized back to back into an
+//! array held by the builder, usually on the caller's stack, and the IPv4 length and both checksums are filled
+//! in there. The payload is referenced, not copied, so it must outlive the builder's views().
+class PacketBuilder {
+  public:
+    //! Room for the longest Ethernet + IPv4 + TCP header stack
+    static constexpr size_t MAX_HEADERS_LENGTH = EthernetHeader::LENGTH + IPv4Header::MAX_LENGTH + TCPHeader::MAX_LENGTH;
+
+  private:
+    std::array<char, MAX_HEADERS_LENGTH> _headers{};
+    size_t _length{0};
+    std::string_view _payload{};
+
+    //! Append the TCP header, with its checksum over the header and payload
+    void _append_tcp(const TCPHeader &tcp, const uint32_t datagram_layer_checksum);
+
+    //! Append an IPv4 header for a TCP segment of `tcp_length` bytes, and return its pseudo-header sum
+    uint32_t _append_ipv4(IPv4Header ip, const size_t tcp_length);
+
+  public:
+    //! \brief A bare TCP segment (e.g. for TCP-over-UDP)
+    //! \param[in] datagram_layer_checksum as for TCPSegment::serialize
+    void tcp(const TCPHeader &tcp, const std::string_view payload, const uint32_t datagram_layer_checksum = 0);
+
+    //! \brief A TCP segment in an IPv4 datagram
+    //! \note `ip`'s protocol, length and checksum are overwritten
+    void tcp_in_ipv4(const IPv4Header &ip, const TCPHeader &tcp, const std::string_view payload);
+
+    //! \brief A TCP segment in an IPv4 datagram in an Ethernet frame
+    //! \note `ip`'s protocol, length and checksum are overwritten
+    void tcp_in_ipv4_in_ethernet(const EthernetHeader &eth,
+                                 const IPv4Header &ip,
+                                 const TCPHeader &tcp,
+                                 const std::string_view payload);
+
+    //! The serialized headers
+    std::string_view headers() const { return {_headers.data(), _length}; }
+
+    //! The payload they are followed by
+    std::string_view payload() const { return _payload; }
+
+    //! The whole packet, for FileDescriptor::write or UDPSocket::sendto
+    BufferViewList views() const { return {headers(), _payload}; }
+};
+
+#endif  // SPONGE_LIBSPONGE_PACKET_BUILDER_HH
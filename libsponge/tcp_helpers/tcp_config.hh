@@ -2,6 +2,8 @@
 #define SPONGE_LIBSPONGE_TCP_CONFIG_HH
 
 #include "address.hh"
+#include "congestion_control.hh"
+#include "stream_reassembler.hh"
 #include "wrapping_integers.hh"
 
 #include <cstddef>
@@ -15,11 +17,54 @@ class TCPConfig {
     static constexpr size_t MAX_PAYLOAD_SIZE = 1000;   //!< Conservative max payload size for real Internet
     static constexpr uint16_t TIMEOUT_DFLT = 1000;     //!< Default re-transmit timeout is 1 second
     static constexpr unsigned MAX_RETX_ATTEMPTS = 8;   //!< Maximum re-transmit attempts before giving up
+    static constexpr uint16_t MIN_TIMEOUT_DFLT = 200;  //!< Default lower bound of an adaptive re-transmit timeout
+    static constexpr unsigned MAX_TIMEOUT = 60000;     //!< Upper bound of an adaptive re-transmit timeout
+    static constexpr unsigned DUPACK_THRESHOLD = 3;    //!< Duplicate acks that trigger a fast retransmit
+    static constexpr uint16_t DELAYED_ACK_DFLT = 40;   //!< Default longest delay of a delayed ack, in milliseconds
+    //! Largest payload of a segment built with segmentation offload
+    static constexpr size_t MAX_OFFLOAD_PAYLOAD_SIZE = 64 * MAX_PAYLOAD_SIZE;
 
     uint16_t rt_timeout = TIMEOUT_DFLT;       //!< Initial value of the retransmission timeout, in milliseconds
+    //! Compute the retransmission timeout from measured RTTs (RFC 6298) once the first one is known
+    bool adaptive_rt_timeout = false;
+    uint16_t min_rt_timeout = MIN_TIMEOUT_DFLT;  //!< Lower bound of the adaptive retransmission timeout, in ms
     size_t recv_capacity = DEFAULT_CAPACITY;  //!< Receive capacity, in bytes
     size_t send_capacity = DEFAULT_CAPACITY;  //!< Sender capacity, in bytes
     std::optional<WrappingInt32> fixed_isn{};
+    //! How the receiver stores out-of-order bytes
+    StreamReassembler::Engine reassembler_engine = StreamReassembler::Engine::IntervalMap;
+    //! Memory limit for out-of-order segments, including per-segment overhead (0 = only the window limits it)
+    size_t reassembler_memory_budget = 0;
+    //! What the receiver drops when the out-of-order memory limit is reached
+    StreamReassembler::EvictionPolicy reassembler_eviction = StreamReassembler::EvictionPolicy::FurthestFirst;
+    //! Retransmit after DUPACK_THRESHOLD duplicate acks and recover NewReno-style (RFC 6582)
+    bool fast_retransmit = false;
+    //! Offer SACK (RFC 2018) on the SYN; used if the peer offers it too
+    bool sack = false;
+    //! Offer window scaling (RFC 7323) on the SYN, so that a recv_capacity above 64 KiB can be advertised;
+    //! used if the peer offers it too
+    bool window_scaling = false;
+    //! Offer the timestamps option (RFC 7323) on the SYN: RTT samples from every ack, and PAWS;
+    //! used if the peer offers it too
+    bool timestamps = false;
+    //! Ack in-order data only for every second full-sized segment or after delayed_ack_timeout
+    //! (RFC 1122 4.2.3.2); out-of-order data, SYN and FIN are still acked at once
+    bool delayed_ack = false;
+    uint16_t delayed_ack_timeout = DELAYED_ACK_DFLT;  //!< Longest time a delayed ack is held back, in ms
+    //! Nagle's algorithm (RFC 896): coalesce small writes while data is in flight
+    //! (TCPConnection::set_nodelay() changes it later)
+    bool nagle = false;
+    //! Pace new data with a token bucket instead of sending the window in one burst
+    bool pacing = false;
+    uint64_t pacing_rate = 0;  //!< Pacing rate in bytes per second (0 = derived from the window and SRTT)
+    //! Segmentation offload: the sender builds segments of up to MAX_OFFLOAD_PAYLOAD_SIZE bytes,
+    //! which the adapter splits into wire-sized ones
+    bool segmentation_offload = false;
+    //! Receive-side coalescing: merge each burst of in-order segments read from the adapter into one segment
+    //! (up to MAX_OFFLOAD_PAYLOAD_SIZE bytes) before the TCPConnection sees it
+    bool receive_coalescing = false;
+    //! Congestion control algorithm of the sender (None: only the receiver's window limits it)
+    CongestionController::Algorithm congestion_control = CongestionController::Algorithm::None;
 };
 
 //! Config for classes derived from FdAdapter
@@ -30,6 +75,10 @@ class FdAdapterConfig {
 
     uint16_t loss_rate_dn = 0;  //!< Downlink loss rate (for LossyFdAdapter)
     uint16_t loss_rate_up = 0;  //!< Uplink loss rate (for LossyFdAdapter)
+
+    //! Parse segments with a deferred payload checksum (TCPSegment::parse), leaving the check to the
+    //! TCPConnection, which sums an in-order payload while copying it into the inbound stream
+    bool defer_checksum = false;
 };
 
 #endif  // SPONGE_LIBSPONGE_TCP_CONFIG_HH
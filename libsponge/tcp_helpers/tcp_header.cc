@@ -1,6 +1,8 @@
 #include "tcp_header.hh"
 
+#include <algorithm>
 #include <sstream>
+#include <stdexcept>
 
 using namespace std;
 
@@ -13,15 +15,22 @@ using namespace std;
 //! - data stream inside the NetParser is too short to contain a header
 //! - the header's `doff` field is shorter than the minimum allowed
 //! - there is less data in the header than the `doff` field claims
+//! - an option claims to be longer than what is left of the header
 //! - the checksum is bad
 ParseResult TCPHeader::parse(NetParser &p) {
-    sport = p.u16();                 // source port
-    dport = p.u16();                 // destination port
-    seqno = WrappingInt32{p.u32()};  // sequence number
-    ackno = WrappingInt32{p.u32()};  // ack number
-    doff = p.u8() >> 4;              // data offset
+    // the fixed part of the header is length-checked once, then read at known offsets
+    const auto h = p.header<TCPHeader::LENGTH>();
+    if (not h) {
+        return p.get_error();
+    }
 
-    const uint8_t fl_b = p.u8();                  // byte including flags
+    sport = h->u16<0>();                 // source port
+    dport = h->u16<2>();                 // destination port
+    seqno = WrappingInt32{h->u32<4>()};  // sequence number
+    ackno = WrappingInt32{h->u32<8>()};  // ack number
+    doff = h->u8<12>() >> 4;             // data offset
+
+    const uint8_t fl_b = h->u8<13>();             // byte including flags
     urg = static_cast<bool>(fl_b & 0b0010'0000);  // binary literals and ' digit separator since C++14!!!
     ack = static_cast<bool>(fl_b & 0b0001'0000);
     psh = static_cast<bool>(fl_b & 0b0000'1000);
@@ -29,16 +38,63 @@ ParseResult TCPHeader::parse(NetParser &p) {
     syn = static_cast<bool>(fl_b & 0b0000'0010);
     fin = static_cast<bool>(fl_b & 0b0000'0001);
 
-    win = p.u16();    // window size
-    cksum = p.u16();  // checksum
-    uptr = p.u16();   // urgent pointer
+    win = h->u16<14>();    // window size
+    cksum = h->u16<16>();  // checksum
+    uptr = h->u16<18>();   // urgent pointer
 
+    // errors are also recorded on the parser, so that a caller checking only p.get_error() sees them
     if (doff < 5) {
-        return ParseResult::HeaderTooShort;
+        p.set_error(ParseResult::HeaderTooShort);
+        return p.get_error();
     }
 
-    // skip any options or anything extra in the header
-    p.remove_prefix(doff * 4 - TCPHeader::LENGTH);
+    // options: SACK-permitted and SACK are kept, anything else is skipped by its length
+    sack_permitted = false;
+    window_scale.reset();
+    timestamps.reset();
+    sack_blocks.clear();
+    size_t remaining = doff * 4 - TCPHeader::LENGTH;
+    while (remaining > 0 && not p.error()) {
+        const uint8_t kind = p.u8();
+        remaining -= 1;
+        if (kind == OPT_EOL) {
+            break;
+        }
+        if (kind == OPT_NOP) {
+            continue;
+        }
+
+        const uint8_t len = remaining > 0 ? p.u8() : 0;
+        if (len < 2 or len - 1u > remaining) {
+            if (not p.error()) {
+                p.set_error(ParseResult::TruncatedPacket);
+            }
+            return p.get_error();
+        }
+        remaining -= len - 1u;
+
+        if (kind == OPT_SACK_PERMITTED and len == 2) {
+            sack_permitted = true;
+        } else if (kind == OPT_WINDOW_SCALE and len == 3) {
+            // shift counts above 14 are treated as 14 (RFC 7323 section 2.3)
+            window_scale = min(p.u8(), MAX_WINDOW_SCALE);
+        } else if (kind == OPT_TIMESTAMPS and len == 10) {
+            const uint32_t val = p.u32();
+            const uint32_t ecr = p.u32();
+            timestamps = Timestamps{val, ecr};
+        } else if (kind == OPT_SACK and (len - 2) % 8 == 0) {
+            for (size_t i = 0; i < (len - 2u) / 8; i++) {
+                const WrappingInt32 left{p.u32()};
+                const WrappingInt32 right{p.u32()};
+                sack_blocks.emplace_back(left, right);
+            }
+        } else {
+            p.remove_prefix(len - 2u);
+        }
+    }
+
+    // skip the padding after the end of the option list
+    p.remove_prefix(remaining);
 
     if (p.error()) {
         return p.get_error();
@@ -47,33 +103,86 @@ ParseResult TCPHeader::parse(NetParser &p) {
     return ParseResult::NoError;
 }
 
-//! Serialize the TCPHeader to a string (does not recompute the checksum)
-string TCPHeader::serialize() const {
+//! \details Each option is preceded by two NOPs, which keeps the SACK blocks 32-bit aligned
+//! (the layout most stacks use). The data offset is `doff` or the length of the options, whichever is larger.
+size_t TCPHeader::length() const {
+    const size_t options = (sack_permitted ? 4 : 0) + (window_scale.has_value() ? 4 : 0) +
+                           (timestamps.has_value() ? 12 : 0) + (sack_blocks.empty() ? 0 : 4 + 8 * sack_blocks.size());
+    return max(4 * size_t{doff}, TCPHeader::LENGTH + options);
+}
+
+//! Serialize the TCPHeader into `out` (does not recompute the checksum)
+//! \param[out] out receives the header; it must have room for `size` bytes
+//! \returns the number of bytes written, i.e. length()
+size_t TCPHeader::serialize_into(char *const out, const size_t size) const {
     // sanity check
     if (doff < 5) {
         throw runtime_error("TCP header too short");
     }
 
-    string ret;
-    ret.reserve(4 * doff);
+    const size_t len = length();
+    if (len > MAX_LENGTH) {
+        throw runtime_error("TCP options do not fit in the header");
+    }
 
-    NetUnparser::u16(ret, sport);              // source port
-    NetUnparser::u16(ret, dport);              // destination port
-    NetUnparser::u32(ret, seqno.raw_value());  // sequence number
-    NetUnparser::u32(ret, ackno.raw_value());  // ack number
-    NetUnparser::u8(ret, doff << 4);           // data offset
+    if (len > size) {
+        throw runtime_error("TCPHeader::serialize_into: buffer too small");
+    }
+
+    char *cursor = out;
+
+    NetUnparser::u16(cursor, sport);              // source port
+    NetUnparser::u16(cursor, dport);              // destination port
+    NetUnparser::u32(cursor, seqno.raw_value());  // sequence number
+    NetUnparser::u32(cursor, ackno.raw_value());  // ack number
+    NetUnparser::u8(cursor, (len / 4) << 4);      // data offset
 
     const uint8_t fl_b = (urg ? 0b0010'0000 : 0) | (ack ? 0b0001'0000 : 0) | (psh ? 0b0000'1000 : 0) |
                          (rst ? 0b0000'0100 : 0) | (syn ? 0b0000'0010 : 0) | (fin ? 0b0000'0001 : 0);
-    NetUnparser::u8(ret, fl_b);  // flags
-    NetUnparser::u16(ret, win);  // window size
+    NetUnparser::u8(cursor, fl_b);  // flags
+    NetUnparser::u16(cursor, win);  // window size
 
-    NetUnparser::u16(ret, cksum);  // checksum
+    NetUnparser::u16(cursor, cksum);  // checksum
 
-    NetUnparser::u16(ret, uptr);  // urgent pointer
+    NetUnparser::u16(cursor, uptr);  // urgent pointer
 
-    ret.resize(4 * doff);  // expand header to advertised size
+    if (sack_permitted) {
+        NetUnparser::u16(cursor, (OPT_NOP << 8) | OPT_NOP);
+        NetUnparser::u8(cursor, OPT_SACK_PERMITTED);
+        NetUnparser::u8(cursor, 2);
+    }
+    if (window_scale.has_value()) {
+        NetUnparser::u8(cursor, OPT_NOP);
+        NetUnparser::u8(cursor, OPT_WINDOW_SCALE);
+        NetUnparser::u8(cursor, 3);
+        NetUnparser::u8(cursor, window_scale.value());
+    }
+    if (timestamps.has_value()) {
+        NetUnparser::u16(cursor, (OPT_NOP << 8) | OPT_NOP);
+        NetUnparser::u8(cursor, OPT_TIMESTAMPS);
+        NetUnparser::u8(cursor, 10);
+        NetUnparser::u32(cursor, timestamps.value().val);
+        NetUnparser::u32(cursor, timestamps.value().ecr);
+    }
+    if (not sack_blocks.empty()) {
+        NetUnparser::u16(cursor, (OPT_NOP << 8) | OPT_NOP);
+        NetUnparser::u8(cursor, OPT_SACK);
+        NetUnparser::u8(cursor, 2 + 8 * sack_blocks.size());
+        for (const auto &[left, right] : sack_blocks) {
+            NetUnparser::u32(cursor, left.raw_value());
+            NetUnparser::u32(cursor, right.raw_value());
+        }
+    }
+
+    fill(cursor, out + len, 0);  // expand header to advertised size (zeros are end-of-option-list)
 
+    return len;
+}
+
+//! Serialize the TCPHeader to a string (does not recompute the checksum)
+string TCPHeader::serialize() const {
+    string ret(length(), 0);
+    serialize_into(ret.data(), ret.size());
     return ret;
 }
 
@@ -89,14 +198,37 @@ string TCPHeader::to_string() const {
        << " fin: " << fin << '\n'
        << "TCP winsize: " << +win << '\n'
        << "TCP cksum: " << +cksum << '\n'
-       << "TCP uptr: " << +uptr << '\n';
+       << "TCP uptr: " << +uptr << '\n'
+       << "TCP options: sack_permitted: " << sack_permitted
+       << " wscale: " << (window_scale.has_value() ? std::to_string(window_scale.value()) : "none");
+    if (timestamps.has_value()) {
+        ss << " tsval: " << timestamps.value().val << " tsecr: " << timestamps.value().ecr;
+    }
+    ss << " sack:";
+    for (const auto &[left, right] : sack_blocks) {
+        ss << " [" << left << ", " << right << ")";
+    }
+    ss << '\n';
     return ss.str();
 }
 
 string TCPHeader::summary() const {
     stringstream ss{};
     ss << "Header(flags=" << (syn ? "S" : "") << (ack ? "A" : "") << (rst ? "R" : "") << (fin ? "F" : "")
-       << ",seqno=" << seqno << ",ack=" << ackno << ",win=" << win << ")";
+       << ",seqno=" << seqno << ",ack=" << ackno << ",win=" << win;
+    if (sack_permitted) {
+        ss << ",sackOK";
+    }
+    if (window_scale.has_value()) {
+        ss << ",wscale=" << +window_scale.value();
+    }
+    if (timestamps.has_value()) {
+        ss << ",ts=" << timestamps.value().val << "/" << timestamps.value().ecr;
+    }
+    for (const auto &[left, right] : sack_blocks) {
+        ss << ",sack=" << left << "-" << right;
+    }
+    ss << ")";
     return ss.str();
 }
 
@@ -104,5 +236,6 @@ bool TCPHeader::operator==(const TCPHeader &other) const {
     // TODO(aozdemir) more complete check (right now we omit cksum, src, dst
     return seqno == other.seqno && ackno == other.ackno && doff == other.doff && urg == other.urg && ack == other.ack &&
            psh == other.psh && rst == other.rst && syn == other.syn && fin == other.fin && win == other.win &&
-           uptr == other.uptr;
+           uptr == other.uptr && sack_permitted == other.sack_permitted &&
+           window_scale == other.window_scale && timestamps == other.timestamps && sack_blocks == other.sack_blocks;
 }
@@ -4,10 +4,39 @@
 #include "parser.hh"
 #include "wrapping_integers.hh"
 
+#include <optional>
+#include <utility>
+#include <vector>
+
 //! \brief [TCP](\ref rfc::rfc793) segment header
-//! \note TCP options are not supported
+//! \note Of the TCP options, only SACK-permitted, SACK (RFC 2018), window scale and timestamps (RFC 7323)
+//! are understood; other options are skipped when parsing and never sent
 struct TCPHeader {
     static constexpr size_t LENGTH = 20;  //!< [TCP](\ref rfc::rfc793) header length, not including options
+    static constexpr size_t MAX_LENGTH = 60;      //!< header length including the largest possible options
+    static constexpr size_t MAX_SACK_BLOCKS = 4;  //!< SACK blocks that fit in the option space
+    static constexpr uint8_t MAX_WINDOW_SCALE = 14;  //!< largest shift count allowed by RFC 7323
+
+    //! \name TCP option kinds
+    //!@{
+    static constexpr uint8_t OPT_EOL = 0;             //!< end of option list
+    static constexpr uint8_t OPT_NOP = 1;             //!< no-operation (padding)
+    static constexpr uint8_t OPT_WINDOW_SCALE = 3;    //!< window scale shift count, only on SYN segments
+    static constexpr uint8_t OPT_SACK_PERMITTED = 4;  //!< SACK-permitted, only on SYN segments
+    static constexpr uint8_t OPT_SACK = 5;            //!< SACK blocks
+    static constexpr uint8_t OPT_TIMESTAMPS = 8;      //!< timestamp value and echo reply
+    //!@}
+
+    //! A SACK block: the receiver holds the sequence numbers [first, second)
+    using SACKBlock = std::pair<WrappingInt32, WrappingInt32>;
+
+    //! Contents of the timestamps option
+    struct Timestamps {
+        uint32_t val;  //!< TSval: the sender's clock when the segment was sent
+        uint32_t ecr;  //!< TSecr: the most recent TSval received from the peer (meaningful with ACK set)
+
+        bool operator==(const Timestamps &other) const { return val == other.val && ecr == other.ecr; }
+    };
 
     //! \struct TCPHeader
     //! ~~~{.txt}
@@ -50,12 +79,28 @@ struct TCPHeader {
     uint16_t uptr = 0;          //!< urgent pointer
     //!@}
 
+    //! \name TCP options
+    //! \note serialize() writes them after the fixed header, padded to a multiple of four bytes,
+    //! and raises the data offset as far as needed
+    //!@{
+    bool sack_permitted = false;             //!< SACK-permitted option
+    std::optional<uint8_t> window_scale{};   //!< window scale option: shift count for the peer's `win`
+    std::optional<Timestamps> timestamps{};  //!< timestamps option
+    std::vector<SACKBlock> sack_blocks{};    //!< SACK option (at most MAX_SACK_BLOCKS blocks)
+    //!@}
+
     //! Parse the TCP fields from the provided NetParser
     ParseResult parse(NetParser &p);
 
     //! Serialize the TCP fields
     std::string serialize() const;
 
+    //! Serialize the TCP fields into a caller-provided buffer of `size` bytes (e.g. on the stack)
+    size_t serialize_into(char *const out, const size_t size) const;
+
+    //! Length of the serialized header, including options and padding
+    size_t length() const;
+
     //! Return a string containing a header in human-readable format
     std::string to_string() const;
 
@@ -3,6 +3,7 @@
 #include "ipv4_datagram.hh"
 #include "ipv4_header.hh"
 #include "parser.hh"
+#include "tcp_config.hh"
 
 #include <arpa/inet.h>
 #include <stdexcept>
@@ -40,9 +41,12 @@ optional<TCPSegment> TCPOverIPv4Adapter::unwrap_tcp_in_ip(const InternetDatagram
         return {};
     }
 
-    // is the payload a valid TCP segment?
+    // is the payload a valid TCP segment? (with defer_checksum, the TCPConnection checks the payload's checksum
+    // while copying it; a SYN that we might start listening to is always checked here)
     TCPSegment tcp_seg;
-    if (ParseResult::NoError != tcp_seg.parse(ip_dgram.payload(), ip_dgram.header().pseudo_cksum())) {
+    const bool defer_checksum = config().defer_checksum and not listening();
+    if (ParseResult::NoError !=
+        tcp_seg.parse(ip_dgram.payload(), ip_dgram.header().pseudo_cksum(), defer_checksum)) {
         return {};
     }
 
@@ -81,10 +85,52 @@ InternetDatagram TCPOverIPv4Adapter::wrap_tcp_in_ip(TCPSegment &seg) {
     InternetDatagram ip_dgram;
     ip_dgram.header().src = config().source.ipv4_numeric();
     ip_dgram.header().dst = config().destination.ipv4_numeric();
-    ip_dgram.header().len = ip_dgram.header().hlen * 4 + seg.header().doff * 4 + seg.payload().size();
+    ip_dgram.header().len = ip_dgram.header().hlen * 4 + seg.header().length() + seg.payload().size();
 
     // set payload, calculating TCP checksum using information from IP header
     ip_dgram.payload() = seg.serialize(ip_dgram.header().pseudo_cksum());
 
     return ip_dgram;
 }
+
+//! \param[in] seg is the TCP segment to convert
+//! \param[out] packet receives the serialized headers
+void TCPOverIPv4Adapter::build_tcp_in_ip(TCPSegment &seg, PacketBuilder &packet) {
+    seg.header().sport = config().source.port();
+    seg.header().dport = config().destination.port();
+
+    IPv4Header ip_header;
+    ip_header.src = config().source.ipv4_numeric();
+    ip_header.dst = config().destination.ipv4_numeric();
+
+    packet.tcp_in_ipv4(ip_header, seg.header(), seg.payload());
+}
+
+//! \param[in] seg is the TCP segment to convert, possibly larger than one wire segment
+vector<InternetDatagram> TCPOverIPv4Adapter::wrap_tcp_in_ip_segmented(TCPSegment &seg) {
+    if (seg.payload().size() <= TCPConfig::MAX_PAYLOAD_SIZE) {
+        return {wrap_tcp_in_ip(seg)};
+    }
+
+    seg.header().sport = config().source.port();
+    seg.header().dport = config().destination.port();
+
+    // one IP header template; only its length changes from piece to piece
+    IPv4Header ip_header;
+    ip_header.src = config().source.ipv4_numeric();
+    ip_header.dst = config().destination.ipv4_numeric();
+
+    vector<InternetDatagram> ret;
+    for (auto &piece : seg.serialize_segmented(TCPConfig::MAX_PAYLOAD_SIZE, [&](const size_t tcp_length) {
+             ip_header.len = ip_header.hlen * 4 + tcp_length;
+             return ip_header.pseudo_cksum();
+         })) {
+        InternetDatagram ip_dgram;
+        ip_dgram.header() = ip_header;
+        ip_dgram.header().len = ip_header.hlen * 4 + piece.size();
+        ip_dgram.payload() = move(piece);
+        ret.push_back(move(ip_dgram));
+    }
+
+    return ret;
+}
@@ -4,9 +4,11 @@
 #include "buffer.hh"
 #include "fd_adapter.hh"
 #include "ipv4_datagram.hh"
+#include "packet_builder.hh"
 #include "tcp_segment.hh"
 
 #include <optional>
+#include <vector>
 
 //! \brief A converter from TCP segments to serialized IPv4 datagrams
 class TCPOverIPv4Adapter : public FdAdapterBase {
@@ -14,6 +16,14 @@ class TCPOverIPv4Adapter : public FdAdapterBase {
     std::optional<TCPSegment> unwrap_tcp_in_ip(const InternetDatagram &ip_dgram);
 
     InternetDatagram wrap_tcp_in_ip(TCPSegment &seg);
+
+    //! \brief Like wrap_tcp_in_ip(), but lays the IPv4 and TCP headers out in `packet` instead of allocating them
+    //! \note `packet` references the segment's payload
+    void build_tcp_in_ip(TCPSegment &seg, PacketBuilder &packet);
+
+    //! \brief Like wrap_tcp_in_ip(), but splits a segment with more than TCPConfig::MAX_PAYLOAD_SIZE bytes of
+    //! payload into one datagram per wire-sized piece (segmentation offload)
+    std::vector<InternetDatagram> wrap_tcp_in_ip_segmented(TCPSegment &seg);
 };
 
 #endif  // SPONGE_LIBSPONGE_TCP_OVER_IP_HH
@@ -3,43 +3,226 @@
 #include "parser.hh"
 #include "util.hh"
 
+#include <algorithm>
+#include <stdexcept>
 #include <variant>
 
 using namespace std;
 
 //! \param[in] buffer string/Buffer to be parsed
 //! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol
-ParseResult TCPSegment::parse(const Buffer buffer, const uint32_t datagram_layer_checksum) {
-    InternetChecksum check(datagram_layer_checksum);
-    check.add(buffer);
-    if (check.value()) {
-        return ParseResult::BadChecksum;
+//! \param[in] defer_payload_checksum leave the payload out of the checksum for now (see checksum_pending())
+ParseResult TCPSegment::parse(Buffer buffer,
+                              const uint32_t datagram_layer_checksum,
+                              const bool defer_payload_checksum) {
+    _pending_checksum.reset();
+    if (not defer_payload_checksum) {
+        InternetChecksum check(datagram_layer_checksum);
+        check.add(buffer);
+        if (check.value()) {
+            return ParseResult::BadChecksum;
+        }
     }
 
-    NetParser p{buffer};
-    _header.parse(p);
+    NetParser p{move(buffer)};
+    const string_view segment = p.unparsed();
+    const ParseResult header_result = _header.parse(p);
+    if (header_result != ParseResult::NoError) {
+        return header_result;
+    }
     _payload = p.buffer();
+
+    if (defer_payload_checksum) {
+        InternetChecksum check(datagram_layer_checksum);
+        check.add(segment.substr(0, segment.size() - _payload.size()));
+        _pending_checksum = check;
+    }
     return p.get_error();
 }
 
+bool TCPSegment::verify_checksum() {
+    if (not _pending_checksum.has_value()) {
+        return true;
+    }
+    InternetChecksum check = _pending_checksum.value();
+    _pending_checksum.reset();
+    check.add(_payload);
+    return check.value() == 0;
+}
+
 size_t TCPSegment::length_in_sequence_space() const {
     return payload().str().size() + (header().syn ? 1 : 0) + (header().fin ? 1 : 0);
 }
 
 //! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol
 BufferList TCPSegment::serialize(const uint32_t datagram_layer_checksum) const {
-    TCPHeader header_out = _header;
-    header_out.cksum = 0;
+    // serialize the header once and patch the checksum in afterwards (the sum is taken with the field zeroed)
+    string header(_header.length(), 0);
+    _header.serialize_into(header.data(), header.size());
+    header[16] = header[17] = 0;
 
     // calculate checksum -- taken over entire segment
     InternetChecksum check(datagram_layer_checksum);
-    check.add(header_out.serialize());
+    check.add(header);
     check.add(_payload);
-    header_out.cksum = check.value();
+    const uint16_t cksum = check.value();
+    header[16] = static_cast<char>(cksum >> 8);
+    header[17] = static_cast<char>(cksum);
+
+    // the payload is referenced, not copied
+    BufferList ret{move(header)};
+    ret.push_back(_payload);
+    return ret;
+}
+
+//! \param[in] max_payload largest payload of a piece
+//! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol for a TCP segment of the given length
+vector<BufferList> TCPSegment::serialize_segmented(const size_t max_payload,
+                                                   const function<uint32_t(size_t)> &datagram_layer_checksum) const {
+    if (max_payload == 0) {
+        throw runtime_error("TCPSegment::serialize_segmented: max_payload must be positive");
+    }
+
+    // serialize the header once, without the fields that differ between pieces
+    TCPHeader header_out = _header;
+    header_out.seqno = WrappingInt32{0};
+    header_out.syn = false;
+    header_out.fin = false;
+    header_out.cksum = 0;
+    const string header_template = header_out.serialize();
+    const uint8_t template_flags = header_template[13];
+
+    // one's-complement sum of the template (its length is a multiple of 4)
+    uint32_t template_sum = 0;
+    for (size_t i = 0; i < header_template.size(); i += 2) {
+        template_sum += (uint8_t(header_template[i]) << 8) | uint8_t(header_template[i + 1]);
+    }
+
+    const size_t total = _payload.size();
+    const size_t pieces = max<size_t>(1, (total + max_payload - 1) / max_payload);
+    vector<BufferList> ret;
+    ret.reserve(pieces);
+
+    size_t offset = 0;
+    for (size_t i = 0; i < pieces; i++) {
+        const size_t len = min(max_payload, total - offset);
+        const bool syn = _header.syn and i == 0;
+        const bool fin = _header.fin and i == pieces - 1;
+        const uint32_t seqno = (_header.seqno + static_cast<uint32_t>(offset + (_header.syn and i > 0))).raw_value();
+        const uint8_t flags = template_flags | (syn ? 0b0000'0010 : 0) | (fin ? 0b0000'0001 : 0);
+
+        Buffer payload = _payload;
+        payload.remove_prefix(offset);
+        payload.remove_suffix(total - offset - len);
+
+        // adjust the template's sum for this piece's fields, then add the payload
+        InternetChecksum check(datagram_layer_checksum(header_template.size() + len) + template_sum + (seqno >> 16) +
+                               (seqno & 0xffff) + (flags - template_flags));
+        check.add(payload);
+        const uint16_t cksum = check.value();
 
-    BufferList ret;
-    ret.append(header_out.serialize());
-    ret.append(_payload);
+        string header = header_template;
+        header[4] = static_cast<char>(seqno >> 24);
+        header[5] = static_cast<char>(seqno >> 16);
+        header[6] = static_cast<char>(seqno >> 8);
+        header[7] = static_cast<char>(seqno);
+        header[13] = static_cast<char>(flags);
+        header[16] = static_cast<char>(cksum >> 8);
+        header[17] = static_cast<char>(cksum);
+
+        ret.emplace_back(move(header));
+        ret.back().append(payload);
+        offset += len;
+    }
+
+    return ret;
+}
+
+//! \param[in] max_payload largest payload of a piece
+vector<TCPSegment> TCPSegment::split(const size_t max_payload) const {
+    if (max_payload == 0) {
+        throw runtime_error("TCPSegment::split: max_payload must be positive");
+    }
+
+    const size_t total = _payload.size();
+    const size_t pieces = max<size_t>(1, (total + max_payload - 1) / max_payload);
+    vector<TCPSegment> ret(pieces);
+
+    size_t offset = 0;
+    for (size_t i = 0; i < pieces; i++) {
+        const size_t len = min(max_payload, total - offset);
+        ret[i]._header = _header;
+        ret[i]._header.syn = _header.syn and i == 0;
+        ret[i]._header.fin = _header.fin and i == pieces - 1;
+        ret[i]._header.seqno = _header.seqno + static_cast<uint32_t>(offset + (_header.syn and i > 0));
+        ret[i]._payload = _payload;
+        ret[i]._payload.remove_prefix(offset);
+        ret[i]._payload.remove_suffix(total - offset - len);
+        offset += len;
+    }
+
+    return ret;
+}
+
+//! \returns whether `next` carries the data right after `prev`'s and could have been sent in one segment with it
+static bool continues(const TCPSegment &prev, const TCPSegment &next) {
+    const TCPHeader &p = prev.header();
+    const TCPHeader &n = next.header();
+    if (prev.payload().size() == 0 or next.payload().size() == 0) {
+        return false;
+    }
+    if (prev.checksum_pending() or next.checksum_pending()) {
+        return false;
+    }
+    if (p.syn or p.fin or p.rst or p.urg or n.syn or n.rst or n.urg) {
+        return false;
+    }
+    if (n.seqno != p.seqno + static_cast<uint32_t>(prev.payload().size())) {
+        return false;
+    }
+
+    // everything else (ports, ackno, window, options) must match
+    TCPHeader normalized = n;
+    normalized.seqno = p.seqno;
+    normalized.fin = p.fin;
+    normalized.cksum = p.cksum;
+    return normalized == p;
+}
+
+//! \param[in] segments the segments in arrival order
+//! \param[in] max_payload largest payload of a merged segment
+vector<TCPSegment> TCPSegment::coalesce(vector<TCPSegment> segments, const size_t max_payload) {
+    vector<TCPSegment> ret;
+    ret.reserve(segments.size());
+
+    size_t first = 0;
+    while (first < segments.size()) {
+        size_t end = first + 1;
+        size_t total = segments[first].payload().size();
+        while (end < segments.size() and continues(segments[end - 1], segments[end]) and
+               total + segments[end].payload().size() <= max_payload) {
+            total += segments[end].payload().size();
+            end++;
+        }
+
+        if (end == first + 1) {
+            ret.push_back(move(segments[first]));
+        } else {
+            // copy the run's payloads once into one buffer
+            string payload;
+            payload.reserve(total);
+            for (size_t i = first; i < end; i++) {
+                payload.append(segments[i].payload().str());
+            }
+            TCPSegment merged;
+            merged._header = segments[first]._header;
+            merged._header.fin = segments[end - 1]._header.fin;
+            merged._header.cksum = 0;
+            merged._payload = Buffer(move(payload));
+            ret.push_back(move(merged));
+        }
+        first = end;
+    }
 
     return ret;
 }
@@ -3,22 +3,65 @@
 
 #include "buffer.hh"
 #include "tcp_header.hh"
+#include "util.hh"
 
 #include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
 
 //! \brief [TCP](\ref rfc::rfc793) segment
 class TCPSegment {
   private:
     TCPHeader _header{};
     Buffer _payload{};
+    //! With a deferred checksum: the sum of the pseudo-header and the header, still missing the payload
+    std::optional<InternetChecksum> _pending_checksum{};
 
   public:
     //! \brief Parse the segment from a string
-    ParseResult parse(const Buffer buffer, const uint32_t datagram_layer_checksum = 0);
+    //! \param defer_payload_checksum only sum the header now and leave the payload's share of the checksum to
+    //! whoever copies the payload (see checksum_pending()), so that the bytes are read once, not twice
+    ParseResult parse(const Buffer buffer,
+                      const uint32_t datagram_layer_checksum = 0,
+                      const bool defer_payload_checksum = false);
+
+    //! \name Deferred checksum
+    //! A segment parsed with `defer_payload_checksum` has not been checked yet: the receiver must add the payload
+    //! to pending_checksum() (e.g. with InternetChecksum::add_and_copy()) and drop the segment unless value() is 0
+    //!@{
+    bool checksum_pending() const { return _pending_checksum.has_value(); }
+    const InternetChecksum &pending_checksum() const { return _pending_checksum.value(); }
+
+    //! \brief Finish a deferred checksum by summing the payload here
+    //! \returns whether the checksum is correct (always `true` if it was not deferred)
+    bool verify_checksum();
+    //!@}
 
     //! \brief Serialize the segment to a string
     BufferList serialize(const uint32_t datagram_layer_checksum = 0) const;
 
+    //! \brief Serialize the segment as wire segments carrying at most `max_payload` bytes each
+    //! (segmentation offload)
+    //! \details The header is serialized once and its checksum summed once; each piece patches in its own
+    //! sequence number, SYN/FIN and checksum. Only the first piece keeps the SYN and only the last the FIN.
+    //! The pieces share the payload's storage.
+    //! \param datagram_layer_checksum the lower layer's pseudo-checksum for a TCP segment of the given length
+    std::vector<BufferList> serialize_segmented(
+        const size_t max_payload, const std::function<uint32_t(size_t)> &datagram_layer_checksum) const;
+
+    //! \brief Split the segment into segments carrying at most `max_payload` bytes each,
+    //! as serialize_segmented() does on the wire
+    std::vector<TCPSegment> split(const size_t max_payload) const;
+
+    //! \brief Merge each run of back-to-back data segments into one segment of at most `max_payload` bytes
+    //! (receive-side coalescing, the inverse of split())
+    //! \details A segment joins the run before it only if it starts where the run ends and its header matches
+    //! the run's in everything but the sequence number, FIN and checksum. SYN, RST and URG segments and
+    //! segments without payload are never merged (so duplicate acks are still seen one by one); a FIN ends a run.
+    //! Segments whose checksum is still pending are not merged either.
+    static std::vector<TCPSegment> coalesce(std::vector<TCPSegment> segments, const size_t max_payload);
+
     //! \name Accessors
     //!@{
     const TCPHeader &header() const { return _header; }
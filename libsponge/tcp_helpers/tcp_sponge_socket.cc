@@ -5,6 +5,7 @@
 #include "tun.hh"
 #include "util.hh"
 
+#include <algorithm>
 #include <cstddef>
 #include <exception>
 #include <iostream>
@@ -20,13 +21,19 @@ using namespace std;
 
 static constexpr size_t TCP_TICK_MS = 10;
 
+//! Most datagrams read from the adapter in one go when input is ready
+static constexpr size_t MAX_READ_BURST = 64;
+
 //! \param[in] condition is a function returning true if loop should continue
 template <typename AdaptT>
 void TCPSpongeSocket<AdaptT>::_tcp_loop(const function<bool()> &condition) {
     auto base_time = timestamp_ms();
     //cout << "无尽循环 开始" << endl;
     while (condition()) {
-        auto ret = _eventloop.wait_next_event(TCP_TICK_MS);
+        //发送节拍扣着数据时，只睡到下一个报文段可以发出的时候
+        const auto pacing_delay = _tcp.has_value() ? _tcp->time_until_next_send() : nullopt;
+        auto ret = _eventloop.wait_next_event(
+            pacing_delay.has_value() ? min<size_t>(pacing_delay.value(), TCP_TICK_MS) : TCP_TICK_MS);
         if (ret == EventLoop::Result::Exit or _abort) {
             break;
         }
@@ -54,6 +61,7 @@ TCPSpongeSocket<AdaptT>::TCPSpongeSocket(pair<FileDescriptor, FileDescriptor> da
 template <typename AdaptT>
 void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
     _tcp.emplace(config);
+    _coalesce_receives = config.receive_coalescing;
 
     // Set up the event loop
 
@@ -77,16 +85,32 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
     _eventloop.add_rule(_datagram_adapter,
                         Direction::In,
                         [&] {
-                            auto seg = _datagram_adapter.read();
-                            if (seg) {
-                                _tcp->segment_received(move(seg.value()));
+                            // read everything that has arrived; with receive coalescing, each in-order burst
+                            // reaches the TCPConnection as one segment
+                            auto segments = _datagram_adapter.read_many(MAX_READ_BURST);
+                            if (_coalesce_receives) {
+                                segments =
+                                    TCPSegment::coalesce(move(segments), TCPConfig::MAX_OFFLOAD_PAYLOAD_SIZE);
+                            }
+                            for (auto &seg : segments) {
+                                if (not _tcp->active()) {
+                                    break;
+                                }
+                                _tcp->segment_received(move(seg));
                             }
 
                             // debugging output:
                             if (_thread_data.eof() and _tcp.value().bytes_in_flight() == 0 and not _fully_acked) {
+                                const TCPSender &sender = _tcp.value().sender();
                                 cerr << "DEBUG: Outbound stream to "
                                      << _datagram_adapter.config().destination.to_string()
-                                     << " has been fully acknowledged.\n";
+                                     << " has been fully acknowledged";
+                                if (sender.smoothed_rtt().has_value()) {
+                                    cerr << " (srtt " << sender.smoothed_rtt().value() << " ms, rttvar "
+                                         << sender.rtt_variation().value() << " ms, rto "
+                                         << sender.retransmission_timeout() << " ms)";
+                                }
+                                cerr << ".\n";
                                 _fully_acked = true;
                             }
                         },
@@ -97,7 +121,9 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
         _thread_data,
         Direction::In,
         [&] {
-            const auto data = _thread_data.read(_tcp->remaining_outbound_capacity());
+            // read into pooled slabs, which the outbound stream keeps without copying
+            Buffer data =
+                _thread_data.read_pooled(min(_tcp->remaining_outbound_capacity(), BufferPool::LARGE_SLAB_SIZE));
             const auto len = data.size();
             const auto amount_written = _tcp->write(move(data));
             if (amount_written != len) {
@@ -130,8 +156,8 @@ void TCPSpongeSocket<AdaptT>::_initialize_TCP(const TCPConfig &config) {
             // the pipe, handling the possibility of a partial
             // write (i.e., only pop what was actually written).
             const size_t amount_to_write = min(size_t(65536), inbound.buffer_size());
-            const std::string buffer = inbound.peek_output(amount_to_write);
-            const auto bytes_written = _thread_data.write(move(buffer), false);
+            const auto [first, second] = inbound.peek_views(amount_to_write);
+            const auto bytes_written = _thread_data.write({first, second}, false);
             inbound.pop_output(bytes_written);
 
             if (inbound.eof() or inbound.error()) {
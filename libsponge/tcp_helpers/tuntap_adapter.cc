@@ -14,12 +14,23 @@ TCPOverIPv4OverEthernetAdapter::TCPOverIPv4OverEthernetAdapter(TapFD &&tap,
     // Linux seems to ignore the first frame sent on a TAP device, so send a dummy frame to prime the pump :-(
     EthernetFrame dummy_frame;
     _tap.write(dummy_frame.serialize());
+
+    // non-blocking, so that read_many() can tell when it has read every frame that is waiting
+    _tap.set_blocking(false);
 }
 
 optional<TCPSegment> TCPOverIPv4OverEthernetAdapter::read() {
     // Read Ethernet frame from the raw device
+    auto frame = _tap.try_read_pooled();
+    if (not frame) {
+        return {};
+    }
+    return _accept(move(frame.value()));
+}
+
+optional<TCPSegment> TCPOverIPv4OverEthernetAdapter::_accept(Buffer raw_frame) {
     EthernetFrame frame;
-    if (frame.parse(_tap.read()) != ParseResult::NoError) {
+    if (frame.parse(move(raw_frame)) != ParseResult::NoError) {
         return {};
     }
 
@@ -44,7 +55,9 @@ void TCPOverIPv4OverEthernetAdapter::tick(const size_t ms_since_last_tick) {
 
 //! \param[in] seg the TCPSegment to send
 void TCPOverIPv4OverEthernetAdapter::write(TCPSegment &seg) {
-    _interface.send_datagram(wrap_tcp_in_ip(seg), _next_hop);
+    for (const auto &ip_dgram : wrap_tcp_in_ip_segmented(seg)) {
+        _interface.send_datagram(ip_dgram, _next_hop);
+    }
     send_pending();
 }
 
@@ -8,27 +8,52 @@
 #include <optional>
 #include <unordered_map>
 #include <utility>
+#include <vector>
 
 //! \brief A FD adapter for IPv4 datagrams read from and written to a TUN device
 class TCPOverIPv4OverTunFdAdapter : public TCPOverIPv4Adapter {
   private:
     TunFD _tun;
 
-  public:
-    //! Construct from a TunFD
-    explicit TCPOverIPv4OverTunFdAdapter(TunFD &&tun) : _tun(std::move(tun)) {}
-
-    //! Attempts to read and parse an IPv4 datagram containing a TCP segment related to the current connection
-    std::optional<TCPSegment> read() {
+    //! The TCP segment in an IPv4 datagram, if it is related to the current connection
+    std::optional<TCPSegment> _accept(Buffer packet) {
         InternetDatagram ip_dgram;
-        if (ip_dgram.parse(_tun.read()) != ParseResult::NoError) {
+        if (ip_dgram.parse(std::move(packet)) != ParseResult::NoError) {
             return {};
         }
         return unwrap_tcp_in_ip(ip_dgram);
     }
 
-    //! Creates an IPv4 datagram from a TCP segment and writes it to the TUN device
-    void write(TCPSegment &seg) { _tun.write(wrap_tcp_in_ip(seg).serialize()); }
+  public:
+    //! Construct from a TunFD (which is made non-blocking, so that read_many() can tell when it has read everything)
+    explicit TCPOverIPv4OverTunFdAdapter(TunFD &&tun) : _tun(std::move(tun)) { _tun.set_blocking(false); }
+
+    //! Attempts to read and parse an IPv4 datagram containing a TCP segment related to the current connection
+    std::optional<TCPSegment> read() {
+        auto packet = _tun.try_read_pooled();
+        return packet ? _accept(std::move(packet.value())) : std::nullopt;
+    }
+
+    //! Reads the datagrams that are waiting (see TCPOverUDPSocketAdapter::read_many)
+    std::vector<TCPSegment> read_many(const size_t max_datagrams) {
+        return read_while_ready(
+            max_datagrams, [&] { return _tun.try_read_pooled(); }, [&](Buffer packet) { return _accept(std::move(packet)); });
+    }
+
+    //! Creates IPv4 datagrams from a TCP segment (one per wire-sized piece) and writes them to the TUN device
+    void write(TCPSegment &seg) {
+        if (seg.payload().size() <= TCPConfig::MAX_PAYLOAD_SIZE) {
+            // the headers are built on the stack and written together with the payload, in place
+            PacketBuilder packet;
+            build_tcp_in_ip(seg, packet);
+            _tun.write(packet.views());
+            return;
+        }
+
+        for (auto &ip_dgram : wrap_tcp_in_ip_segmented(seg)) {
+            _tun.write(ip_dgram.serialize());
+        }
+    }
 
     //! Access the underlying TUN device
     operator TunFD &() { return _tun; }
@@ -51,6 +76,9 @@ class TCPOverIPv4OverEthernetAdapter : public TCPOverIPv4Adapter {
 
     void send_pending();  //!< Sends any pending Ethernet frames
 
+    //! The TCP segment in an Ethernet frame, if it carries one related to the current connection
+    std::optional<TCPSegment> _accept(Buffer frame);
+
   public:
     //! Construct from a TapFD
     explicit TCPOverIPv4OverEthernetAdapter(TapFD &&tap,
@@ -60,6 +88,12 @@ class TCPOverIPv4OverEthernetAdapter : public TCPOverIPv4Adapter {
     //! Attempts to read and parse an Ethernet frame containing an IPv4 datagram that contains a TCP segment
     std::optional<TCPSegment> read();
 
+    //! Reads the frames that are waiting (see TCPOverUDPSocketAdapter::read_many)
+    std::vector<TCPSegment> read_many(const size_t max_frames) {
+        return read_while_ready(
+            max_frames, [&] { return _tap.try_read_pooled(); }, [&](Buffer frame) { return _accept(std::move(frame)); });
+    }
+
     //! Sends a TCP segment (in an IPv4 datagram, in an Ethernet frame).
     void write(TCPSegment &seg);
 
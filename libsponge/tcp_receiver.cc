@@ -1,5 +1,7 @@
 #include "tcp_receiver.hh"
 
+#include <utility>
+
 // Dummy implementation of a TCP receiver
 
 // For Lab 2, please replace with a real implementation that passes the
@@ -10,19 +12,42 @@ void DUMMY_CODE(Targs &&... /* unused */) {}
 
 using namespace std;
 
-void TCPReceiver::segment_received(const TCPSegment &seg) {
+bool TCPReceiver::verify_checksum(const TCPSegment &seg) {
+    _staged = 0;
+    if (!seg.checksum_pending()) { return true; }
+    InternetChecksum check = seg.pending_checksum();
+    //正好按序到达的数据反正要拷进字节流：拷贝的同时求和，只读一遍负载
+    if (_ackno.has_value() && !seg.header().syn && seg.header().seqno == _ackno.value()) {
+        _staged = stream_out().stage(seg.payload(), check);
+    } else {
+        check.add(seg.payload());
+    }
+    //校验和不对：已经拷进空闲空间的字节不提交，相当于没写过
+    if (check.value() != 0) {
+        _staged = 0;
+        return false;
+    }
+    return true;
+}
+
+bool TCPReceiver::segment_received(const TCPSegment &seg) {
+    //verify_checksum()拷进字节流的字节只对紧接着的这一次调用有效
+    const size_t staged = exchange(_staged, 0);
+
     //如果还没有设置SYN但是已经有报文段到达了，则直接忽略
-    if (!_isn.has_value() && !seg.header().syn) { return; }
+    if (!_isn.has_value() && !seg.header().syn) { return true; }
+
+    //PAWS：序列号可能已经绕回，过时的重复报文段只能靠时间戳识别
+    if (!check_timestamp(seg)) { return false; }
 
     //首个到达的含有SYN的报文段所含的序号被标记为初始序列号_isn
     //我们对其进行单独处理。该部分结束后,_isn和_ackno都已经收到了
     //理论上TCPReceiver只会收到一次带有SYN的报文段
     if (seg.header().syn && !_isn.has_value()) {
         _isn = seg.header().seqno;
-        string payload = seg.payload().copy();
-        _reassembler.push_substring(payload, 0, seg.header().fin);
+        _reassembler.push_substring(seg.payload(), 0, seg.header().fin);
         _ackno = wrap(1 + _reassembler.get_first_unassembled() + seg.header().fin, _isn.value());
-        return;
+        return true;
     }
 
     //能运行到这个位置，说明SYN报文段已经被收到了，此时_isn和_ackno都已经被接收到了
@@ -30,13 +55,39 @@ void TCPReceiver::segment_received(const TCPSegment &seg) {
     //1：尝试获得reassembler.push_substring所要求的字符串初始序列号
     uint64_t abs_seqno = unwrap(seg.header().seqno, _isn.value(), _reassembler.get_first_unassembled());
     uint64_t seg_idx = abs_seqno - 1;
-    //2：把它包含的负载(string)放入reassembler中
-    _reassembler.push_substring(seg.payload().copy(), seg_idx, seg.header().fin);
+    //2：把它包含的负载放入reassembler中，直接传Buffer，由reassembler按偏移截取，不再先拷贝成string
+    _reassembler.push_substring(seg.payload(), seg_idx, seg.header().fin, staged);
     //3：更新_ackno，期待收到的下一个字节
     //细节在于需要处理FIN比特位：如果reassembler到达了字节流末尾，则需要加上FIN占用的序列号
     _ackno = wrap(_reassembler.get_first_unassembled() + 1 + (_reassembler.reach_end() ? 1 : 0), _isn.value());
+    return true;
+}
+
+bool TCPReceiver::check_timestamp(const TCPSegment &seg) {
+    const optional<TCPHeader::Timestamps> &timestamps = seg.header().timestamps;
+    if (!timestamps.has_value()) { return true; }
+    //时间戳也按模2^32比较；RST不受PAWS限制
+    const uint32_t val = timestamps.value().val;
+    if (_ts_recent.has_value() && !seg.header().rst && static_cast<int32_t>(val - _ts_recent.value()) < 0) {
+        _paws_rejected++;
+        return false;
+    }
+    //只有不超过上次ack的报文段(SEG.SEQ <= Last.ACK.sent)才更新TS.Recent，
+    //这样回显的是引起这次ack的、最早的报文段的时间戳，乱序到达的数据不会让RTT偏小
+    if (!_ackno.has_value() || seg.header().seqno - _ackno.value() <= 0) { _ts_recent = val; }
+    return true;
 }
 
 optional<WrappingInt32> TCPReceiver::ackno() const { return _ackno; }
 
+vector<TCPHeader::SACKBlock> TCPReceiver::sack_blocks(const size_t max_blocks) const {
+    vector<TCPHeader::SACKBlock> blocks{};
+    if (!_isn.has_value()) { return blocks; }
+    //reassembler中的字节序号不计SYN，换算成序列号时加1
+    for (const auto &[begin, end] : _reassembler.sack_ranges(max_blocks)) {
+        blocks.emplace_back(wrap(begin + 1, _isn.value()), wrap(end + 1, _isn.value()));
+    }
+    return blocks;
+}
+
 size_t TCPReceiver::window_size() const { return _capacity - _reassembler.stream_out().buffer_size() ; }
@@ -3,10 +3,12 @@
 
 #include "byte_stream.hh"
 #include "stream_reassembler.hh"
+#include "tcp_helpers/tcp_config.hh"
 #include "tcp_helpers/tcp_segment.hh"
 #include "wrapping_integers.hh"
 
 #include <optional>
+#include <vector>
 
 //! \brief The "receiver" part of a TCP implementation.
 
@@ -24,6 +26,17 @@ class TCPReceiver {
     std::optional<WrappingInt32> _isn{};
     std::optional<WrappingInt32> _ackno{};
 
+    //! \name 时间戳选项(RFC 7323)
+    //!@{
+    std::optional<uint32_t> _ts_recent{};  //TS.Recent：发出的ack要在TSecr中回显的时间戳
+    size_t _paws_rejected{0};              //被PAWS丢弃的报文段个数
+
+    //PAWS检查：时间戳比TS.Recent更旧的报文段返回false；否则在报文段覆盖窗口左边界时更新TS.Recent
+    bool check_timestamp(const TCPSegment &seg);
+    //!@}
+
+    //verify_checksum()在核对校验和时已经拷进字节流空闲空间的字节数，由紧接着的segment_received提交
+    size_t _staged{0};
 
     /**
      * _abs_first_unassembled与_first_unassembled的区别在于二者相差1
@@ -48,6 +61,13 @@ class TCPReceiver {
     //!                 store in its buffers at any give time.
     TCPReceiver(const size_t capacity) : _reassembler(capacity), _capacity(capacity) {}
 
+    //! \brief Construct a TCP receiver from the receive-side settings of a TCPConfig
+    //! (capacity, reassembler engine and out-of-order memory budget)
+    explicit TCPReceiver(const TCPConfig &cfg)
+        : _reassembler(cfg.recv_capacity, cfg.reassembler_engine), _capacity(cfg.recv_capacity) {
+        _reassembler.set_memory_budget(cfg.reassembler_memory_budget, cfg.reassembler_eviction);
+    }
+
     //! \name Accessors to provide feedback to the remote TCPSender
     //!@{
 
@@ -76,8 +96,30 @@ class TCPReceiver {
     //! \brief number of bytes stored but not yet reassembled
     size_t unassembled_bytes() const { return _reassembler.unassembled_bytes(); }
 
+    //! \brief The timestamp to echo in TSecr (RFC 7323 TS.Recent), if the peer sends timestamps
+    std::optional<uint32_t> ts_recent() const { return _ts_recent; }
+
+    //! \brief Number of segments dropped by PAWS (their timestamp was older than TS.Recent)
+    size_t paws_rejected() const { return _paws_rejected; }
+
+    //! \brief SACK blocks (RFC 2018) describing the out-of-order data held beyond the ackno
+    //! \param max_blocks at most this many blocks; the one with the most recent arrival comes first
+    std::vector<TCPHeader::SACKBlock> sack_blocks(const size_t max_blocks = TCPHeader::MAX_SACK_BLOCKS) const;
+
+    //! \brief the reassembler, e.g. for its eviction counters
+    const StreamReassembler &reassembler() const { return _reassembler; }
+
+    //! \brief Finish the checksum of a segment parsed with a deferred checksum, before segment_received()
+    //! \details An in-order payload is copied into the free space of the inbound stream while it is summed
+    //! (ByteStream::stage()), so the following segment_received() only commits it instead of copying it again.
+    //! \returns whether the checksum is correct; if not, the segment must be dropped
+    bool verify_checksum(const TCPSegment &seg);
+
     //! \brief handle an inbound segment
-    void segment_received(const TCPSegment &seg);
+    //! \details A segment whose timestamp is older than TS.Recent is a stale duplicate from an earlier
+    //! wrap of the sequence space (PAWS, RFC 7323 section 5) and is dropped before reassembly
+    //! \returns false if the segment was dropped by PAWS; nothing in it (ack, window, options) may be used
+    bool segment_received(const TCPSegment &seg);
 
     //! \name "Output" interface for the reader
     //!@{
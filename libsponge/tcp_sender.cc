@@ -2,6 +2,7 @@
 
 #include "tcp_config.hh"
 
+#include <algorithm>
 #include <random>
 #include <iostream>
 
@@ -18,23 +19,79 @@ using namespace std;
 //! \param[in] capacity the capacity of the outgoing byte stream
 //! \param[in] retx_timeout the initial amount of time to wait before retransmitting the oldest outstanding segment
 //! \param[in] fixed_isn the Initial Sequence Number to use, if set (otherwise uses a random ISN)
-TCPSender::TCPSender(const size_t capacity, const uint16_t retx_timeout, const std::optional<WrappingInt32> fixed_isn)
+//! \param[in] congestion the congestion control algorithm
+TCPSender::TCPSender(const size_t capacity,
+                     const uint16_t retx_timeout,
+                     const std::optional<WrappingInt32> fixed_isn,
+                     const CongestionController::Algorithm congestion)
     : _isn(fixed_isn.value_or(WrappingInt32{random_device()()}))
     , _initial_retransmission_timeout{retx_timeout}
     , _retransmission_timeout{retx_timeout}
-    , _stream(capacity) {}
+    , _stream(capacity, ByteStream::Mode::Chunked)
+    , _congestion(CongestionController::make(congestion, TCPConfig::MAX_PAYLOAD_SIZE)) {}
+
+TCPSender::TCPSender(const TCPConfig &cfg)
+    : TCPSender(cfg.send_capacity, cfg.rt_timeout, cfg.fixed_isn, cfg.congestion_control) {
+    set_adaptive_rto(cfg.adaptive_rt_timeout, cfg.min_rt_timeout);
+    set_fast_retransmit(cfg.fast_retransmit);
+    set_nagle(cfg.nagle);
+    set_pacing(cfg.pacing, cfg.pacing_rate);
+    set_segmentation_offload(cfg.segmentation_offload);
+}
+
+void TCPSender::set_pacing(const bool enable, const uint64_t rate) {
+    _pacing = enable;
+    _pacing_rate = rate;
+}
+
+double TCPSender::pacing_rate_per_ms() const {
+    if (!_pacing) return 0;
+    if (_pacing_rate != 0) return _pacing_rate / 1000.0;
+    //由窗口和SRTT推算：慢启动阶段每个RTT发出两倍窗口，之后1.2倍(与Linux的默认值相同)
+    if (!timer.rtt_measured()) return 0;
+    const uint64_t window = min(_window_size, _congestion->cwnd());
+    const double gain = _congestion->cwnd() < _congestion->ssthresh() ? 2.0 : 1.2;
+    return gain * window / max(timer.srtt(), Timer::CLOCK_GRANULARITY);
+}
+
+optional<uint64_t> TCPSender::time_until_next_send() const {
+    //只有节拍器扣着数据的时候才有意义
+    const bool waiting = _stream.buffer_size() > 0 || (_stream.eof() && !_FIN_sent);
+    if (!_SYN_sent || !waiting || _pacer.may_send()) return {};
+    return _pacer.ms_until_positive();
+}
+
+void TCPSender::set_adaptive_rto(const bool enable, const unsigned int min_timeout) {
+    _adaptive_rto = enable;
+    _min_retransmission_timeout = min_timeout;
+}
+
+unsigned int TCPSender::base_retransmission_timeout() const {
+    if (!_adaptive_rto || !timer.rtt_measured()) return _initial_retransmission_timeout;
+    return clamp(timer.estimated_rto(), _min_retransmission_timeout, TCPConfig::MAX_TIMEOUT);
+}
+
+optional<double> TCPSender::smoothed_rtt() const {
+    if (!timer.rtt_measured()) return {};
+    return timer.srtt();
+}
+
+optional<double> TCPSender::rtt_variation() const {
+    if (!timer.rtt_measured()) return {};
+    return timer.rttvar();
+}
 
 uint64_t TCPSender::bytes_in_flight() const { 
     //思路明晰：可用还未发送的字节 - 发送尚未确认的字节
     return _next_seqno - _abs_ackno;
 }
 
-TCPSegment TCPSender::make_segment(uint64_t abs_seqno, bool syn, bool fin, string& payload) {
+TCPSegment TCPSender::make_segment(uint64_t abs_seqno, bool syn, bool fin, Buffer payload) {
     TCPSegment SYN_segment{};
     SYN_segment.header().seqno = wrap(abs_seqno, _isn);
     SYN_segment.header().syn = syn;   
     SYN_segment.header().fin = fin; 
-    if (payload.length() != 0) SYN_segment.payload() = Buffer(move(payload));
+    if (payload.size() != 0) SYN_segment.payload() = move(payload);
     return SYN_segment;
 }
 
@@ -43,12 +100,7 @@ void TCPSender::fill_window() {
     //还需要把该报文段推入一个备用以待重发的数据结构
     //在发送方，我们需要关注：Seqno, SYN, FIN, Payload这四个元素
     if (!_SYN_sent) {
-        string payload = "";
-        TCPSegment SYN_segment = make_segment(_next_seqno, true, false, payload); 
-        _segments_out.push(SYN_segment); 
-        _segments_backup.push(SYN_segment);
-        if (timer.timer_closed()) timer.start_timer(_retransmission_timeout);
-        _next_seqno += SYN_segment.length_in_sequence_space(); 
+        send_segment(true, false, {});
         _SYN_sent = true; //BUG0:忘记设置SYN_sent比特位为真
         return;
     }
@@ -58,45 +110,125 @@ void TCPSender::fill_window() {
     //另一个需要注意的细节：如果_window_size == 0，那么要把它当成1
     //其它细节：这里需要写一个循环！为什么？每次我们的最大报文段长度是1452，如果窗口很大，且有多个
     //报文段需要读取的情况下，必然需要使用循环语句
-    uint16_t fill_size = max(static_cast<uint64_t>(_window_size), 1UL) > bytes_in_flight() ? 
-                         max(static_cast<uint64_t>(_window_size), 1UL) - bytes_in_flight() : 0;
+    //有拥塞控制时，发送窗口还不能超过拥塞窗口；零窗口探测不受拥塞窗口限制
+    const uint64_t window = _window_size == 0 ? 1 : min(_window_size, _congestion->cwnd());
+    uint64_t fill_size = window > bytes_in_flight() ? window - bytes_in_flight() : 0;
+    _small_segment_held = false;
+    _pacer.refill(_time_ms, pacing_rate_per_ms());
     
     //循环结束的两个条件：fill_size == 0 或者 没有信息需要获取
     //注意BUG：一旦发出FIN信号，就必须结束任何发送！
     while (fill_size > 0 && !_FIN_sent && _SYN_sent) {
+        //Nagle/cork：先算出这个报文段能装多少字节，不足一个满载报文段、又不是输出流的最后一段，就先扣下
+        const uint64_t size = min<uint64_t>({fill_size, TCPConfig::MAX_PAYLOAD_SIZE, _stream.buffer_size()});
+        const bool last = _stream.input_ended() && size == _stream.buffer_size();
+        if (size > 0 && size < TCPConfig::MAX_PAYLOAD_SIZE && !last &&
+            (_corked || (_nagle && bytes_in_flight() > 0))) {
+            _small_segment_held = true;
+            break;
+        }
+        //令牌用完了，剩下的等以后的tick再发
+        if (!_pacer.may_send()) break;
         //BUG：报文段负载的最大长度不能超过1452，尝试充满整个窗口
-        string payload = _stream.read(fill_size > TCPConfig::MAX_PAYLOAD_SIZE ? 
-                                    TCPConfig::MAX_PAYLOAD_SIZE : fill_size);
+        //outbound stream是Chunked模式，读出的是写入时的Buffer切片，只有跨越两个chunk时才需要拼接拷贝（拷进缓冲池）
+        //开启分段卸载时一次装出一个大报文段，由适配器切开
+        Buffer payload = _stream.read_contiguous(min<uint64_t>(fill_size, _max_segment_payload));
         //_stream.eof()：我们将之当成一个普通的字节即可
         //fill_size > payload.size()表示窗口空间是否留有FIN比特的一席之地？
-        TCPSegment segment = make_segment(_next_seqno, false, 
-                                          fill_size > payload.size() ? _stream.eof() : false, payload);
-        //如果发送了空的报文段，说明没有信息需要获取，直接结束循环即可
-        if (segment.length_in_sequence_space() == 0) break;
+        const bool fin = fill_size > payload.size() ? _stream.eof() : false;
+        const size_t length = payload.size() + fin;
+        //如果要发送的是空的报文段，说明没有信息需要获取，直接结束循环即可
+        if (length == 0) break;
         //如果报文段不是空报文段，则具有利用价值
-        if (segment.header().fin) _FIN_sent = true; //FIN标记被派上用场，标志这发送的结束
-        _segments_out.push(segment); 
-        _segments_backup.push(segment);
-        if (timer.timer_closed()) timer.start_timer(_retransmission_timeout); 
-        _next_seqno += segment.length_in_sequence_space();
-        fill_size -= segment.length_in_sequence_space();         
+        if (fin) _FIN_sent = true; //FIN标记被派上用场，标志这发送的结束
+        _pacer.consume(length);
+        send_segment(false, fin, move(payload));
+        fill_size -= length;
     }
 }
 
-bool TCPSender::check_seg_acked(const TCPSegment& seg) {
-    //获取报文段的绝对序列号
-    uint64_t abs_seq = unwrap(seg.header().seqno, _isn, _abs_ackno);
-    return abs_seq + seg.length_in_sequence_space() <= _abs_ackno;
+void TCPSender::send_segment(const bool syn, const bool fin, Buffer payload) {
+    OutstandingSegment record{_next_seqno, payload.size() + syn + fin, syn, fin, payload, _time_ms, false, false};
+    _segments_out.push(make_segment(_next_seqno, syn, fin, move(payload)));
+    if (timer.timer_closed()) timer.start_timer(_retransmission_timeout);
+    _next_seqno = record.end();
+    _outstanding.push_back(move(record));
+}
+
+void TCPSender::split_outstanding(const uint64_t seqno) {
+    //找到第一个end() > seqno的报文段，seqno严格落在它内部时才需要切
+    auto it = lower_bound(_outstanding.begin(), _outstanding.end(), seqno,
+                          [](const OutstandingSegment &segment, const uint64_t s) { return segment.end() <= s; });
+    if (it == _outstanding.end() || it->abs_seqno >= seqno) return;
+    //前一半保留SYN，后一半保留FIN；负载是共享存储的两个切片，不需要复制
+    OutstandingSegment second = *it;
+    const size_t offset = seqno - it->abs_seqno - it->syn;
+    second.abs_seqno = seqno;
+    second.syn = false;
+    second.payload.remove_prefix(offset);
+    second.length = it->end() - seqno;
+    it->fin = false;
+    it->payload.remove_suffix(it->payload.size() - offset);
+    it->length = seqno - it->abs_seqno;
+    _outstanding.insert(next(it), move(second));
+}
+
+deque<TCPSender::OutstandingSegment>::iterator TCPSender::first_wire_segment(deque<OutstandingSegment>::iterator it) {
+    if (it->payload.size() <= TCPConfig::MAX_PAYLOAD_SIZE) return it;
+    //insert会使迭代器失效，按下标重新定位
+    const auto index = it - _outstanding.begin();
+    split_outstanding(it->abs_seqno + it->syn + TCPConfig::MAX_PAYLOAD_SIZE);
+    return _outstanding.begin() + index;
+}
+
+void TCPSender::retransmit_oldest() {
+    //大报文段只重传第一个线上大小的部分
+    OutstandingSegment &oldest = *first_wire_segment(_outstanding.begin());
+    oldest.retransmitted = true;
+    _segments_out.push(make_segment(oldest.abs_seqno, oldest.syn, oldest.fin, oldest.payload));
+}
+
+void TCPSender::retransmit_next_hole() {
+    for (auto it = _outstanding.begin(); it != _outstanding.end(); ++it) {
+        if (it->abs_seqno >= _highest_sacked) return;
+        if (it->sacked || it->retransmitted) continue;
+        OutstandingSegment &segment = *first_wire_segment(it);
+        segment.retransmitted = true;
+        _segments_out.push(make_segment(segment.abs_seqno, segment.syn, segment.fin, segment.payload));
+        return;
+    }
+}
+
+void TCPSender::sack_received(const vector<TCPHeader::SACKBlock> &blocks) {
+    for (const auto &[left, right] : blocks) {
+        const uint64_t begin = unwrap(left, _isn, _abs_ackno);
+        const uint64_t end = unwrap(right, _isn, _abs_ackno);
+        //不合法的块、或者已经被累积确认的块直接忽略
+        if (begin >= end || end > _next_seqno || end <= _abs_ackno) continue;
+        //块的边界落在分段卸载的大报文段内部时先切开，这样块内的部分才能被标记
+        split_outstanding(begin);
+        split_outstanding(end);
+        //_outstanding按序列号递增排列，二分找到块内的第一个报文段，只标记完全落在块内的报文段
+        auto it = lower_bound(_outstanding.begin(), _outstanding.end(), begin,
+                              [](const OutstandingSegment &segment, const uint64_t seqno) { return segment.abs_seqno < seqno; });
+        for (; it != _outstanding.end() && it->end() <= end; ++it) it->sacked = true;
+        _highest_sacked = max(_highest_sacked, end);
+    }
 }
 
 //! \param ackno The remote receiver's ackno (acknowledgment number)
 //! \param window_size The remote receiver's advertised window size
-void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_size) { 
+//! \param may_be_duplicate whether the ack may count as a duplicate ack (see tcp_sender.hh)
+void TCPSender::ack_received(const WrappingInt32 ackno, const uint64_t window_size, const bool may_be_duplicate) { 
     //第一部分：接收来自TCPReceiver的数据 
     //if判断是为了实现《自顶向下》中的逻辑：(y > SendBase)
     //注意测试用例：Impossible ackno (beyond next seqno) is ignored
-    if (unwrap(ackno, _isn, _abs_ackno) > _abs_ackno && unwrap(ackno, _isn, _abs_ackno) <= _next_seqno) {
-        _abs_ackno = unwrap(ackno, _isn, _abs_ackno);  //注意：此处可能会有坑_abs_ackno是否合理？  
+    //ackno只需要unwrap一次，之后全部是绝对序列号之间的整数比较
+    const uint64_t abs_ackno = unwrap(ackno, _isn, _abs_ackno);
+    const uint64_t prev_ackno = _abs_ackno;
+    const uint64_t prev_window = _window_size;
+    if (abs_ackno > _abs_ackno && abs_ackno <= _next_seqno) {
+        _abs_ackno = abs_ackno;
     }
     _window_size = window_size;
 
@@ -105,31 +237,90 @@ void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_si
     //Timer doesn't restart without ACK of new data
     //因此需要设置flag，标志是否有新的报文段被确认，如果没有，就不重启计时器
     bool new_seg_acked{false};
-    while (!_segments_backup.empty() && check_seg_acked(_segments_backup.front())) {
-        _segments_backup.pop();
+    //RTT采样取被确认的最新一个报文段，重传过的不采样
+    optional<uint64_t> rtt{};
+    //确认号落在分段卸载的大报文段内部时，先把已确认的部分切出来，这样它也能出队并重启计时器
+    if (_max_segment_payload > TCPConfig::MAX_PAYLOAD_SIZE) split_outstanding(_abs_ackno);
+    //_outstanding按序列号递增排列，累积确认只需要从头部弹出所有end() <= _abs_ackno的报文段
+    while (!_outstanding.empty() && _outstanding.front().end() <= _abs_ackno) {
+        const OutstandingSegment &acked = _outstanding.front();
+        rtt = acked.retransmitted ? nullopt : optional<uint64_t>{_time_ms - acked.sent_at};
+        _outstanding.pop_front();
         new_seg_acked = true;
     }
+    //有时间戳回显时，任何确认了新数据的ack都能产生RTT采样
+    if (new_seg_acked && _echoed_rtt.has_value()) rtt = _echoed_rtt;
+    _echoed_rtt.reset();
+    if (rtt.has_value()) timer.rtt_sample(rtt.value());
+    //SYN占用的序列号不计入拥塞窗口的增长
+    if (_abs_ackno > prev_ackno) {
+        _congestion->on_ack(_abs_ackno - max<uint64_t>(prev_ackno, 1), bytes_in_flight(), rtt, _time_ms);
+    }
+
+    //快速重传：新数据的确认清空重复ack计数；快速恢复期间，没有越过恢复点的确认(partial ack)说明
+    //下一个报文段也丢了，立即重传它，越过恢复点则退出快速恢复
+    //有SACK信息时，partial ack和重复ack都只重传记分板上的下一个空洞
+    //重复ack：确认号不变、不携带数据、窗口不变、且还有未确认的数据(RFC 5681)
+    if (_fast_retransmit && _abs_ackno > prev_ackno) {
+        _dupacks = 0;
+        if (_in_recovery && _abs_ackno >= _recovery_point) {
+            _in_recovery = false;
+            _congestion->on_recovery_exit();
+        } else if (_in_recovery && !_outstanding.empty()) {
+            if (_highest_sacked > _abs_ackno) {
+                retransmit_next_hole();
+            } else {
+                retransmit_oldest();
+            }
+        }
+    } else if (_fast_retransmit && abs_ackno == prev_ackno && may_be_duplicate && window_size == prev_window &&
+               !_outstanding.empty()) {
+        _dupacks += 1;
+        if (_in_recovery) {
+            _congestion->on_dupack();
+            if (_highest_sacked > _abs_ackno) retransmit_next_hole();
+        } else if (_dupacks == TCPConfig::DUPACK_THRESHOLD && _abs_ackno >= _recovery_point) {
+            _in_recovery = true;
+            _recovery_point = _next_seqno;
+            _congestion->on_fast_retransmit(bytes_in_flight(), _time_ms);
+            retransmit_oldest();
+        }
+    }
     //如果所有发送但未确认的报文段都已经被确认了，那么就关闭计时器
-    if (_segments_backup.empty()) timer.stop_timer();
+    if (_outstanding.empty()) timer.stop_timer();
 
     //第三部分：修改重传时限、或许需要重启计时器、累积重传次数归零
-    _retransmission_timeout = _initial_retransmission_timeout;
+    //重传时限恢复为初始值，或者(自适应模式下)由最新的RTT估计算出
+    _retransmission_timeout = base_retransmission_timeout();
     //只有在尚存未发送报文段，并且此次接收ack有新的报文段被确认，才能重启计时器
-    if (!_segments_backup.empty() && new_seg_acked) timer.start_timer(_retransmission_timeout);
+    if (!_outstanding.empty() && new_seg_acked) timer.start_timer(_retransmission_timeout);
     _consecutive_retransmissions = 0;
  }
 
 //! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
 void TCPSender::tick(const size_t ms_since_last_tick) { 
+    _time_ms += ms_since_last_tick;
     timer.tick(ms_since_last_tick); //告知计时器时间流逝
     if (!timer.timer_expired()) return;
     //处理计时器计时结束的情况
-    //首先需要重传具有最小序号的发送但未确认的报文段
-    _segments_out.push(_segments_backup.front());
-    //设置连续重传次数+1，超时间隔翻倍
+    //首先需要重传具有最小序号的发送但未确认的报文段，此时才根据记录重新生成报文段
+    retransmit_oldest();
+    //超时后清空SACK记分板：接收方可能已经丢弃了SACK确认过的数据(reneging)，这些报文段要按未确认重新对待
+    //(RFC 2018第8节、RFC 6675第5.1节)
+    for (auto &segment : _outstanding) segment.sacked = false;
+    _highest_sacked = 0;
+    //超时后放弃快速恢复；在确认号越过当前已发送的数据之前，不再因为重复ack而快速重传(RFC 6582)
+    if (_fast_retransmit) {
+        _dupacks = 0;
+        _in_recovery = false;
+        _recovery_point = _next_seqno;
+    }
+    //设置连续重传次数+1，超时间隔翻倍；零窗口探测超时并不意味着拥塞
     if (_window_size != 0) {
         _consecutive_retransmissions += 1;
         _retransmission_timeout *= 2;
+        if (_adaptive_rto) _retransmission_timeout = min(_retransmission_timeout, TCPConfig::MAX_TIMEOUT);
+        _congestion->on_timeout(bytes_in_flight(), _time_ms);
     }
 
     //重新启动计时器
@@ -140,8 +331,7 @@ unsigned int TCPSender::consecutive_retransmissions() const { return _consecutiv
 
 void TCPSender::send_empty_segment(bool rst_set) {
     //创造一个空报文段，注意：这种不占用绝对序列号的报文段不需要备份重发
-    string payload = "";
-    TCPSegment empty_segment = make_segment(_next_seqno, false, false, payload);
+    TCPSegment empty_segment = make_segment(_next_seqno, false, false, {});
     empty_segment.header().rst = rst_set;
     _segments_out.push(empty_segment);
 }
@@ -2,12 +2,19 @@
 #define SPONGE_LIBSPONGE_TCP_SENDER_HH
 
 #include "byte_stream.hh"
+#include "congestion_control.hh"
 #include "tcp_config.hh"
 #include "tcp_segment.hh"
 #include "wrapping_integers.hh"
 
+#include <algorithm>
+#include <cmath>
+#include <deque>
 #include <functional>
+#include <memory>
+#include <optional>
 #include <queue>
+#include <vector>
 
 /**
  * Timer类，即TCPSender中的“计时器”
@@ -19,9 +26,18 @@ class Timer {
     bool _active; //Timer是否启动？
     unsigned int _time_passed; //从Timer启动到多次调用tick之后到底经过了多久？
     bool _expired; //判断计时器是否记时结束
+
+    //RFC 6298的往返时间估计：平滑RTT与RTT偏差(毫秒)，收到第一个RTT采样之前没有意义
+    double _srtt;
+    double _rttvar;
+    bool _rtt_measured;
   public:
+    //RFC 6298中的时钟粒度G：发送方的时钟以毫秒计
+    static constexpr double CLOCK_GRANULARITY = 1;
+
     //构造函数
-    Timer () : _RTO{0}, _active{false}, _time_passed{0}, _expired{false} {} 
+    Timer () : _RTO{0}, _active{false}, _time_passed{0}, _expired{false},
+               _srtt{0}, _rttvar{0}, _rtt_measured{false} {} 
 
     /**
      * 停止计时器，由于各种状态会在启动计时器后刷新
@@ -59,6 +75,80 @@ class Timer {
      * 一般在某次tick调用结束后紧随调用timer_expired
     */
    bool timer_expired() { return _expired; }
+
+    /**
+     * 用一个RTT采样更新SRTT与RTTVAR(RFC 6298第2节)
+     * 调用者需要遵守Karn算法：重传过的报文段不能产生RTT采样
+     * @param rtt 一个报文段从发出到被确认经过的毫秒数
+    */
+    void rtt_sample(const uint64_t rtt) {
+      if (!_rtt_measured) {
+        _srtt = rtt; _rttvar = rtt / 2.0; _rtt_measured = true;
+        return;
+      }
+      _rttvar = 0.75 * _rttvar + 0.25 * std::abs(_srtt - rtt);
+      _srtt = 0.875 * _srtt + 0.125 * rtt;
+    }
+
+    /**
+     * 根据估计得到的重传时限：SRTT + max(G, 4 * RTTVAR)，向上取整
+     * 还没有RTT采样时返回0
+    */
+    unsigned int estimated_rto() const {
+      if (!_rtt_measured) return 0;
+      return static_cast<unsigned int>(std::ceil(_srtt + std::max(CLOCK_GRANULARITY, 4 * _rttvar)));
+    }
+
+    bool rtt_measured() const { return _rtt_measured; }
+    double srtt() const { return _srtt; }
+    double rttvar() const { return _rttvar; }
+};
+
+/**
+ * TokenBucket类，即TCPSender的“节拍器”(pacing)
+ * 令牌按速率随时间积累，发送新数据时消耗与负载等长的令牌；令牌不为正时就不能再发，直到积累回来
+ * 桶的容量限制了一次突发的大小
+*/
+class TokenBucket {
+  private:
+    double _rate;       //速率：每毫秒积累多少字节的令牌，0表示不限速
+    double _tokens;     //当前的令牌数(字节)，发送之后可以为负
+    uint64_t _last_ms;  //上次补充令牌时发送方的时钟
+
+  public:
+    //桶里最多攒下多少毫秒的令牌，但至少能突发两个满载报文段
+    static constexpr double MAX_BURST_MS = 2;
+
+    TokenBucket() : _rate{0}, _tokens{0}, _last_ms{0} {}
+
+    double rate() const { return _rate; }
+
+    //桶的容量(字节)
+    double depth() const { return std::max(2.0 * TCPConfig::MAX_PAYLOAD_SIZE, _rate * MAX_BURST_MS); }
+
+    /**
+     * 补充从上次补充到now_ms之间积累的令牌，然后改用新的速率
+     * @param rate_bytes_per_ms 新的速率，0表示不限速
+    */
+    void refill(const uint64_t now_ms, const double rate_bytes_per_ms) {
+      //从不限速切换到限速时桶是满的，不能让第一个报文段就被扣下
+      _tokens = _rate == 0 ? depth() : std::min(depth(), _tokens + _rate * (now_ms - _last_ms));
+      _rate = rate_bytes_per_ms;
+      _tokens = std::min(_tokens, depth());
+      _last_ms = now_ms;
+    }
+
+    //现在能不能发送？
+    bool may_send() const { return _rate == 0 || _tokens > 0; }
+
+    //发送了bytes字节
+    void consume(const size_t bytes) { if (_rate != 0) _tokens -= bytes; }
+
+    //还要过多少毫秒令牌才变为正数？(向上取整，至少1毫秒)
+    uint64_t ms_until_positive() const {
+      if (may_send()) return 0;
+      return static_cast<uint64_t>(std::floor(-_tokens / _rate)) + 1;
+    }
 };
 
 
@@ -76,8 +166,29 @@ class TCPSender {
     //! outbound queue of segments that the TCPSender wants sent
     std::queue<TCPSegment> _segments_out{};
 
-    //该数据结构用于暂存那些发出，还未确认的报文段，以用于今后超时重传
-    std::queue<TCPSegment> _segments_backup{};
+    /**
+     * 一个已发出、还未确认的报文段
+     * 只记录绝对序列号、标志位和共享的payload(Buffer只增加引用计数)，不保存TCPSegment的副本，
+     * 确认时只需要整数比较；只有真正重传时才重新生成报文段头部
+    */
+    struct OutstandingSegment {
+        uint64_t abs_seqno;          //首个序列号(绝对)
+        uint64_t length;             //占用的序列号空间，SYN和FIN各占一个
+        bool syn;
+        bool fin;
+        Buffer payload;
+        uint64_t sent_at;            //首次发送的时刻(_time_ms)
+        bool retransmitted;          //是否被重传过？重传过的报文段不能用于RTT采样(Karn算法)
+        bool sacked;                 //是否已经被接收方用SACK块确认收到？
+
+        uint64_t end() const { return abs_seqno + length; }  //下一个报文段的首个序列号
+    };
+
+    //已发出、还未确认的报文段，按序列号递增排列，以用于今后超时重传
+    std::deque<OutstandingSegment> _outstanding{};
+
+    //发出一个占用序列号的报文段，并记录到_outstanding中
+    void send_segment(const bool syn, const bool fin, Buffer payload);
 
     //! retransmission timer for the connection
     unsigned int _initial_retransmission_timeout;
@@ -85,6 +196,70 @@ class TCPSender {
     //记录当前的重传时限
     unsigned int _retransmission_timeout;
 
+    //是否根据RTT估计计算重传时限？否则每次收到新的确认都恢复为_initial_retransmission_timeout
+    bool _adaptive_rto{false};
+    //自适应重传时限的下限
+    unsigned int _min_retransmission_timeout{TCPConfig::MIN_TIMEOUT_DFLT};
+
+    //收到新的确认之后应当使用的重传时限(尚未退避)
+    unsigned int base_retransmission_timeout() const;
+
+    //! \name 快速重传与NewReno快速恢复(RFC 5681、RFC 6582)
+    //!@{
+    bool _fast_retransmit{false};  //是否启用？
+    unsigned int _dupacks{0};      //连续收到的重复ack个数
+    bool _in_recovery{false};      //是否处于快速恢复阶段？
+    //进入快速恢复时的_next_seqno：确认号达到它才算完全恢复，超时之后也要等确认号越过它才能再次快速重传
+    uint64_t _recovery_point{0};
+    //!@}
+
+    //重传_outstanding中最早的报文段，被重传过的报文段不再产生RTT采样
+    void retransmit_oldest();
+
+    //! \name 分段卸载(segmentation offload)
+    //! fill_window一次装出最多MAX_OFFLOAD_PAYLOAD_SIZE字节的大报文段，由适配器切成线上大小的报文段；
+    //! 重传和SACK标记需要更细的粒度时，再把_outstanding中的大报文段按需切开
+    //!@{
+    size_t _max_segment_payload{TCPConfig::MAX_PAYLOAD_SIZE};  //fill_window装出的报文段的最大负载
+
+    //如果seqno落在_outstanding中某个报文段的内部，就从seqno处把它切成两个
+    void split_outstanding(const uint64_t seqno);
+
+    //it指向的报文段负载超过MAX_PAYLOAD_SIZE时，把第一个线上大小的部分切出来；返回指向该部分的迭代器
+    std::deque<OutstandingSegment>::iterator first_wire_segment(std::deque<OutstandingSegment>::iterator it);
+    //!@}
+
+    //! \name SACK记分板(RFC 6675的简化版)
+    //! 收到的SACK块把完全落在块内的报文段标记为sacked；低于_highest_sacked而没有被标记的报文段就是空洞，
+    //! 视为已经丢失。快速恢复期间每个重复ack或partial ack只重传下一个空洞，而不是从最早的报文段依次重传。
+    //! 重传计时器超时时记分板被清空
+    //!@{
+    uint64_t _highest_sacked{0};  //SACK块覆盖到的最高序列号(之后一个)
+
+    //重传低于_highest_sacked、没有被SACK确认、也还没有重传过的最早的报文段(如果有的话)
+    void retransmit_next_hole();
+    //!@}
+
+    //! \name Nagle算法(RFC 896)与cork
+    //! 不足MAX_PAYLOAD_SIZE的小报文段先扣下不发：开启Nagle时等到在途数据全部被确认，cork时等到uncork；
+    //! 输出流的最后一个报文段(带FIN)不受限制
+    //!@{
+    bool _nagle{false};
+    bool _corked{false};
+    bool _small_segment_held{false};  //上一次fill_window是否扣下了一个小报文段？
+    //!@}
+
+    //! \name 发送节拍(pacing)
+    //! 新数据不再整窗突发，而是按令牌桶的速率发出；速率是配置的固定值，或者由cwnd/SRTT推算
+    //!@{
+    bool _pacing{false};
+    uint64_t _pacing_rate{0};  //固定的速率(字节/秒)，0表示由cwnd/SRTT推算
+    TokenBucket _pacer{};
+
+    //当前应该使用的速率(字节/毫秒)，0表示不限速
+    double pacing_rate_per_ms() const;
+    //!@}
+
     //记录连续重传的次数[一般认为报文段首次发送不算作重传]
     unsigned int _consecutive_retransmissions{0};
 
@@ -99,7 +274,8 @@ class TCPSender {
 
     //收到的窗口大小。我们规定：当尚未收到来自对方的SYNACK时，假设窗口大小是1
     //接收窗口的范围也是发送的范围，具体是：[_abs_ackno, _abs_ackno + _window_size)
-    uint16_t _window_size{1};
+    //协商了窗口扩大选项(RFC 7323)时，TCPConnection传入的是已经按对方的位移量扩大之后的窗口，可以超过64KiB
+    uint64_t _window_size{1};
     
     //作为发送方，SYN比特是否发送出去了？
     bool _SYN_sent{false};
@@ -108,11 +284,52 @@ class TCPSender {
     //单个计时器
     Timer timer{}; 
 
+    //发送方的时钟：所有tick累积经过的毫秒数
+    uint64_t _time_ms{0};
+
+    //随下一个ack到达的时间戳回显得到的RTT(RFC 7323)，存在时代替按Karn算法从_outstanding得到的采样
+    std::optional<uint64_t> _echoed_rtt{};
+
+    //拥塞控制，发送窗口 = min(_window_size, cwnd)
+    std::unique_ptr<CongestionController> _congestion;
+
   public:
     //! Initialize a TCPSender
     TCPSender(const size_t capacity = TCPConfig::DEFAULT_CAPACITY,
               const uint16_t retx_timeout = TCPConfig::TIMEOUT_DFLT,
-              const std::optional<WrappingInt32> fixed_isn = {});
+              const std::optional<WrappingInt32> fixed_isn = {},
+              const CongestionController::Algorithm congestion = CongestionController::Algorithm::None);
+
+    //! \brief Construct a TCP sender from the send-side settings of a TCPConfig
+    //! (capacity, timeouts, ISN and congestion control)
+    explicit TCPSender(const TCPConfig &cfg);
+
+    //! \brief Compute the retransmission timeout from measured RTTs (RFC 6298) instead of
+    //! resetting it to the initial value on every ack
+    //! \param min_timeout lower bound of the computed timeout, in milliseconds
+    void set_adaptive_rto(const bool enable, const unsigned int min_timeout = TCPConfig::MIN_TIMEOUT_DFLT);
+
+    //! \brief Retransmit the oldest outstanding segment after TCPConfig::DUPACK_THRESHOLD duplicate acks,
+    //! and recover NewReno-style (RFC 6582) instead of waiting for the retransmission timer
+    void set_fast_retransmit(const bool enable) { _fast_retransmit = enable; }
+
+    //! \brief Nagle's algorithm (RFC 896): while data is in flight, hold back segments shorter than
+    //! TCPConfig::MAX_PAYLOAD_SIZE until everything outstanding is acknowledged or enough bytes are written
+    void set_nagle(const bool enable) { _nagle = enable; }
+
+    //! \brief While corked, only full-sized segments (and the last one, with the FIN) are sent
+    void set_corked(const bool corked) { _corked = corked; }
+
+    //! \brief Build segments of up to TCPConfig::MAX_OFFLOAD_PAYLOAD_SIZE bytes, to be split into wire-sized
+    //! segments by the adapter (TCPSegment::serialize_segmented()); retransmissions are always wire-sized
+    void set_segmentation_offload(const bool enable) {
+        _max_segment_payload = enable ? TCPConfig::MAX_OFFLOAD_PAYLOAD_SIZE : TCPConfig::MAX_PAYLOAD_SIZE;
+    }
+
+    //! \brief Pace new data with a token bucket instead of sending the whole window back to back
+    //! \param rate bytes per second; 0 derives the rate from the window and the smoothed RTT
+    //! (twice the window per RTT in slow start, 1.2 times afterwards; no pacing until the first RTT sample)
+    void set_pacing(const bool enable, const uint64_t rate = 0);
 
     //! \name "Input" interface for the writer
     //!@{
@@ -124,7 +341,21 @@ class TCPSender {
     //!@{
 
     //! \brief A new acknowledgment was received
-    void ack_received(const WrappingInt32 ackno, const uint16_t window_size);
+    //! \param window_size the receiver's window in bytes (already scaled if window scaling is in use)
+    //! \param may_be_duplicate false if the ack came on a segment that also occupied sequence numbers;
+    //! such an ack is never counted as a duplicate ack (RFC 5681)
+    void ack_received(const WrappingInt32 ackno, const uint64_t window_size, const bool may_be_duplicate = true);
+
+    //! \brief SACK blocks (RFC 2018) arrived with the next ack; call this before ack_received()
+    //! \details Segments entirely inside a block are not retransmitted during fast recovery,
+    //! which instead resends only the holes below the highest SACKed sequence number
+    void sack_received(const std::vector<TCPHeader::SACKBlock> &blocks);
+
+    //! \brief The next ack carried a timestamp echo (RFC 7323) showing an RTT of `rtt_ms`;
+    //! call this before ack_received()
+    //! \details If that ack acknowledges new data, the echo is used as the RTT sample, even when the
+    //! acknowledged segments had been retransmitted (the echo identifies the transmission that was acked)
+    void timestamp_echo(const uint64_t rtt_ms) { _echoed_rtt = rtt_ms; }
 
     /**
      * \brief Generate an empty-payload segment (useful for creating empty ACK segments)
@@ -150,6 +381,32 @@ class TCPSender {
     //! \brief Number of consecutive retransmissions that have occurred in a row
     unsigned int consecutive_retransmissions() const;
 
+    //! \brief How many sequence numbers the congestion controller allows in flight
+    uint64_t congestion_window() const { return _congestion->cwnd(); }
+
+    //! \brief The congestion controller (e.g. to inspect its state)
+    const CongestionController &congestion_controller() const { return *_congestion; }
+
+    //! \name Round-trip time estimates (RFC 6298), in milliseconds
+    //!@{
+    std::optional<double> smoothed_rtt() const;  //!< SRTT, empty until the first RTT sample
+    std::optional<double> rtt_variation() const;  //!< RTTVAR, empty until the first RTT sample
+    unsigned int retransmission_timeout() const { return _retransmission_timeout; }  //!< current RTO
+    //!@}
+
+    //! \brief Current pacing rate in bytes per second (0: not pacing)
+    uint64_t pacing_rate() const { return static_cast<uint64_t>(_pacer.rate() * 1000); }
+
+    //! \brief Milliseconds until the pacer lets the next segment of waiting data go, if it is holding any back
+    //! \details An event loop can sleep this long instead of a fixed tick
+    std::optional<uint64_t> time_until_next_send() const;
+
+    //! \brief Did the last fill_window() hold back a small segment (Nagle's algorithm or cork)?
+    bool small_segment_held() const { return _small_segment_held; }
+
+    //! \brief Is the sender in fast recovery (after a fast retransmit, until the recovery point is acked)?
+    bool in_fast_recovery() const { return _in_recovery; }
+
     //! \brief TCPSegments that the TCPSender has enqueued for transmission.
     //! \note These must be dequeued and sent by the TCPConnection,
     //! which will need to fill in the fields that are set by the TCPReceiver
@@ -171,14 +428,7 @@ class TCPSender {
     /**
      * 为了便于处理，我们设置一个从发送方制作报文段的函数
     */
-    TCPSegment make_segment(uint64_t abs_seqno, bool syn, bool fin, std::string& payload);
-
-    /**
-     * 此函数的作用：检查更新后的绝对ackno下，某个报文段是否
-     * 已经被完全确认收到，即_abs_ackno是否大于该报文段的所有
-     * 字节的序列号
-    */
-    bool check_seg_acked(const TCPSegment& seg);
+    TCPSegment make_segment(uint64_t abs_seqno, bool syn, bool fin, Buffer payload);
 
     /**
      *接口函数：FIN比特是否被发送了出去？
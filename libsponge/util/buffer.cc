@@ -2,14 +2,47 @@
 
 using namespace std;
 
+Buffer::Buffer(SlabRef slab, const size_t length) : _slab(move(slab)), _slab_length(length) {
+    if (_slab and length > _slab.capacity()) {
+        throw out_of_range("Buffer: length exceeds the slab");
+    }
+    _release_if_empty();
+}
+
+Buffer Buffer::copy_of(const string_view data, BufferPool &pool) {
+    if (data.empty()) {
+        return {};
+    }
+    if (data.size() < BufferPool::MIN_POOLED_SIZE) {
+        return Buffer(string(data));
+    }
+    SlabRef slab = pool.get(data.size());
+    std::copy(data.begin(), data.end(), slab.data());
+    return {move(slab), data.size()};
+}
+
+void Buffer::_release_if_empty() {
+    if (_starting_offset + _ending_offset == _whole().size()) {
+        _storage.reset();
+        _slab.reset();
+        _slab_length = _starting_offset = _ending_offset = 0;
+    }
+}
+
 void Buffer::remove_prefix(const size_t n) {
     if (n > str().size()) {
         throw out_of_range("Buffer::remove_prefix");
     }
     _starting_offset += n;
-    if (_storage and _starting_offset == _storage->size()) {
-        _storage.reset();
+    _release_if_empty();
+}
+
+void Buffer::remove_suffix(const size_t n) {
+    if (n > str().size()) {
+        throw out_of_range("Buffer::remove_suffix");
     }
+    _ending_offset += n;
+    _release_if_empty();
 }
 
 void BufferList::append(const BufferList &other) {
@@ -31,6 +64,13 @@ BufferList::operator Buffer() const {
     }
 }
 
+Buffer BufferList::contiguous() const {
+    if (_buffers.size() <= 1) {
+        return *this;
+    }
+    return concatenate();
+}
+
 string BufferList::concatenate() const {
     std::string ret;
     ret.reserve(size());
@@ -70,6 +110,14 @@ BufferViewList::BufferViewList(const BufferList &buffers) {
     }
 }
 
+BufferViewList::BufferViewList(initializer_list<string_view> views) {
+    for (const auto &x : views) {
+        if (not x.empty()) {
+            _views.push_back(x);
+        }
+    }
+}
+
 void BufferViewList::remove_prefix(size_t n) {
     while (n > 0) {
         if (_views.empty()) {
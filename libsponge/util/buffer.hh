@@ -1,8 +1,11 @@
 #ifndef SPONGE_LIBSPONGE_BUFFER_HH
 #define SPONGE_LIBSPONGE_BUFFER_HH
 
+#include "buffer_pool.hh"
+
 #include <algorithm>
 #include <deque>
+#include <initializer_list>
 #include <memory>
 #include <numeric>
 #include <stdexcept>
@@ -12,10 +15,29 @@
 #include <vector>
 
 //! \brief A reference-counted read-only string that can discard bytes from the front
+//! \details The bytes are either a std::string the Buffer took ownership of, or the start of a Slab from a
+//! BufferPool (which needs no allocation once the pool is warm).
 class Buffer {
   private:
     std::shared_ptr<std::string> _storage{};
+    SlabRef _slab{};
+    size_t _slab_length{};  //!< number of bytes of `_slab` that belong to the Buffer
     size_t _starting_offset{};
+    size_t _ending_offset{};
+
+    //! The whole of the underlying storage, before any prefix or suffix was removed
+    std::string_view _whole() const {
+        if (_slab) {
+            return {_slab.data(), _slab_length};
+        }
+        if (_storage) {
+            return *_storage;
+        }
+        return {};
+    }
+
+    //! Let go of the storage once every byte has been discarded
+    void _release_if_empty();
 
   public:
     Buffer() = default;
@@ -23,13 +45,18 @@ class Buffer {
     //! \brief Construct by taking ownership of a string
     Buffer(std::string &&str) noexcept : _storage(std::make_shared<std::string>(std::move(str))) {}
 
+    //! \brief Construct from the first `length` bytes of a slab (which must not be written to afterwards)
+    //! \note If `length` is 0, the slab is released right away.
+    Buffer(SlabRef slab, const size_t length);
+
+    //! \brief Copy `data` into a slab from `pool` (or, if it is tiny, into an exact-size string)
+    static Buffer copy_of(const std::string_view data, BufferPool &pool = BufferPool::global());
+
     //! \name Expose contents as a std::string_view
     //!@{
     std::string_view str() const {
-        if (not _storage) {
-            return {};
-        }
-        return {_storage->data() + _starting_offset, _storage->size() - _starting_offset};
+        const std::string_view whole = _whole();
+        return whole.substr(_starting_offset, whole.size() - _starting_offset - _ending_offset);
     }
 
     operator std::string_view() const { return str(); }
@@ -44,9 +71,22 @@ class Buffer {
     //! \brief Make a copy to a new std::string
     std::string copy() const { return std::string(str()); }
 
+    //! \brief Bytes of storage the Buffer keeps alive, including any discarded prefix and suffix
+    //! \note A small slice of a large packet pins all of it; copy the slice if it is to be kept for long.
+    size_t storage_size() const {
+        if (_slab) {
+            return _slab.capacity();
+        }
+        return _storage ? _storage->capacity() : 0;
+    }
+
     //! \brief Discard the first `n` bytes of the string (does not require a copy or move)
     //! \note Doesn't free any memory until the whole string has been discarded in all copies of the Buffer.
     void remove_prefix(const size_t n);
+
+    //! \brief Discard the last `n` bytes of the string (does not require a copy or move)
+    //! \note Doesn't free any memory until the whole string has been discarded in all copies of the Buffer.
+    void remove_suffix(const size_t n);
 };
 
 //! \brief A reference-counted discontiguous string that can discard bytes from the front
@@ -80,10 +120,16 @@ class BufferList {
     //! \brief Append a BufferList
     void append(const BufferList &other);
 
+    //! \brief Append a single Buffer (without building a temporary BufferList)
+    void push_back(Buffer buffer) { _buffers.push_back(std::move(buffer)); }
+
     //! \brief Transform to a Buffer
     //! \note Throws an exception unless BufferList is contiguous
     operator Buffer() const;
 
+    //! \brief Transform to a Buffer, copying only if the BufferList is not contiguous
+    Buffer contiguous() const;
+
     //! \brief Discard the first `n` bytes of the string (does not require a copy or move)
     void remove_prefix(size_t n);
 
@@ -113,6 +159,9 @@ class BufferViewList {
 
     //! \brief Construct from a std::string_view
     BufferViewList(std::string_view str) { _views.push_back({const_cast<char *>(str.data()), str.size()}); }
+
+    //! \brief Construct from a sequence of std::string_view (empty views are skipped)
+    BufferViewList(std::initializer_list<std::string_view> views);
     //!@}
 
     //! \brief Discard the first `n` bytes of the string (does not require a copy or move)
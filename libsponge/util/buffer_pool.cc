@@ -0,0 +1,154 @@
+#include "buffer_pool.hh"
+
+#include "buffer.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+
+using namespace std;
+
+namespace {
+constexpr unsigned TAG_SHIFT = 48;
+constexpr uint64_t POINTER_MASK = (uint64_t{1} << TAG_SHIFT) - 1;
+
+Slab *slab_of(const uint64_t head) { return reinterpret_cast<Slab *>(static_cast<uintptr_t>(head & POINTER_MASK)); }
+}  // namespace
+
+void SlabRef::release() {
+    if (_slab and _slab->_refs.fetch_sub(1, memory_order_acq_rel) == 1) {
+        if (_slab->_pool) {
+            _slab->_pool->_release(_slab);
+        } else {
+            _slab->~Slab();
+            ::operator delete(_slab);
+        }
+    }
+}
+
+BufferPool::FreeList::~FreeList() {
+    while (Slab *slab = pop()) {
+        slab->~Slab();
+        ::operator delete(slab);
+    }
+}
+
+// push() frees a slab instead only when no pop() is in progress. A pop() that could still read the slab's `_next`
+// must have loaded the head while the slab was on the list, i.e. before the (sequentially consistent) exchange
+// that took it off, and so would have been counted in `_poppers`; one that starts later cannot find the slab.
+Slab *BufferPool::FreeList::pop() {
+    _poppers.fetch_add(1, memory_order_seq_cst);
+    uint64_t head = _head.load(memory_order_seq_cst);
+    Slab *slab = nullptr;
+    while ((slab = slab_of(head))) {
+        // a stale `next` (the slab was popped and pushed again meanwhile) fails the exchange, thanks to the tag
+        const uint64_t tag = (head >> TAG_SHIFT) + 1;
+        const uint64_t next = reinterpret_cast<uintptr_t>(slab->_next.load(memory_order_relaxed)) | (tag << TAG_SHIFT);
+        if (_head.compare_exchange_weak(head, next, memory_order_seq_cst, memory_order_seq_cst)) {
+            _length.fetch_sub(1, memory_order_relaxed);
+            break;
+        }
+    }
+    _poppers.fetch_sub(1, memory_order_seq_cst);
+    return slab;
+}
+
+bool BufferPool::FreeList::push(Slab *slab, const size_t limit) {
+    // a slab whose address does not fit beside the tag is not kept
+    if (reinterpret_cast<uintptr_t>(slab) & ~POINTER_MASK) {
+        return false;
+    }
+    // over the limit, keep the slab anyway if it is not yet safe to free (the list is only briefly overfull)
+    if (_length.load(memory_order_relaxed) >= limit and _poppers.load(memory_order_seq_cst) == 0) {
+        return false;
+    }
+
+    // counted before it is on the list (and, in pop(), uncounted after it is off), so a racing pop() cannot
+    // take `_length` below zero
+    _length.fetch_add(1, memory_order_relaxed);
+    uint64_t head = _head.load(memory_order_relaxed);
+    do {
+        slab->_next.store(slab_of(head), memory_order_relaxed);
+    } while (not _head.compare_exchange_weak(head,
+                                             reinterpret_cast<uintptr_t>(slab) | (head & ~POINTER_MASK),
+                                             memory_order_release,
+                                             memory_order_relaxed));
+    return true;
+}
+
+size_t BufferPool::size_class(const size_t size) {
+    size_t ret = 0;
+    while ((MIN_SLAB_SIZE << ret) < size) {
+        ret++;
+    }
+    return ret;
+}
+
+Slab *BufferPool::_allocate(const size_t capacity, const bool pooled) {
+    _allocations.fetch_add(1, memory_order_relaxed);
+    return new (::operator new(sizeof(Slab) + capacity)) Slab(pooled ? this : nullptr, capacity);
+}
+
+void BufferPool::_release(Slab *slab) {
+    if (not _free_lists[size_class(slab->capacity())].push(slab, _retained_bytes / slab->capacity())) {
+        slab->~Slab();
+        ::operator delete(slab);
+    }
+}
+
+SlabRef BufferPool::get(const size_t size) {
+    if (size > LARGE_SLAB_SIZE) {
+        return SlabRef{_allocate(size, false)};
+    }
+
+    const size_t index = size_class(size);
+    if (Slab *slab = _free_lists[index].pop()) {
+        slab->_refs.store(1, memory_order_relaxed);
+        return SlabRef{slab};
+    }
+    return SlabRef{_allocate(MIN_SLAB_SIZE << index, true)};
+}
+
+BufferPool &BufferPool::global() {
+    static BufferPool *const pool = new BufferPool();
+    return *pool;
+}
+
+BufferPool::PacketSlabs::PacketSlabs(BufferPool &pool)
+    : _pool(pool), _small(pool.get(SMALL_SLAB_SIZE)), _large(pool.get(LARGE_SLAB_SIZE)) {}
+
+pair<array<iovec, 2>, size_t> BufferPool::PacketSlabs::iovecs(const size_t limit) {
+    const size_t small = min(limit, _small.capacity());
+    const size_t large = min(limit - small, _large.capacity() - _small.capacity());
+    array<iovec, 2> ret{};
+    ret[0] = {_small.data(), small};
+    ret[1] = {_large.data() + _small.capacity(), large};
+    return {ret, large ? 2 : 1};
+}
+
+Buffer BufferPool::PacketSlabs::take(const size_t length) {
+    const size_t head = _small.capacity();
+    SlabRef &slab = length <= head ? _small : _large;
+
+    // the slab would be mostly empty: copy the packet into a slab of its own size class (a short copy)
+    if (length > 0 and 4 * length < slab.capacity()) {
+        SlabRef fitted = _pool.get(length);
+        memcpy(fitted.data(), _small.data(), min(length, head));
+        if (length > head) {
+            memcpy(fitted.data() + head, _large.data() + head, length - head);
+        }
+        _small.reset();
+        _large.reset();
+        return {move(fitted), length};
+    }
+
+    if (length > head) {
+        // the rest of the packet is already in place after the large slab's first `head` bytes
+        memcpy(_large.data(), _small.data(), head);
+        _small.reset();
+        return {move(_large), length};
+    }
+    _large.reset();
+    return {move(_small), length};
+}
@@ -0,0 +1,174 @@
+#ifndef SPONGE_LIBSPONGE_BUFFER_POOL_HH
+#define SPONGE_LIBSPONGE_BUFFER_POOL_HH
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <sys/uio.h>
+#include <utility>
+
+class Buffer;
+class BufferPool;
+
+//! \brief A fixed-size block of memory that Buffers can reference, recycled through a BufferPool
+//! \details The reference count lives in the slab itself, so a Buffer that references a slab needs no separate
+//! control block. The data follows this header in the same allocation.
+class Slab {
+    friend class BufferPool;
+    friend class SlabRef;
+
+    std::atomic<uint32_t> _refs{1};
+    BufferPool *const _pool;      //!< where the slab goes back to, or nullptr if it is simply freed
+    const size_t _capacity;       //!< number of bytes of data
+    std::atomic<Slab *> _next{};  //!< link in the pool's free list
+
+    Slab(BufferPool *pool, const size_t capacity) : _pool(pool), _capacity(capacity) {}
+
+  public:
+    Slab(const Slab &other) = delete;
+    Slab &operator=(const Slab &other) = delete;
+
+    //! The slab's bytes
+    char *data() { return reinterpret_cast<char *>(this + 1); }
+
+    //! How many bytes the slab holds
+    size_t capacity() const { return _capacity; }
+};
+
+//! \brief A counted reference to a Slab (like a std::shared_ptr, but the count is intrusive)
+class SlabRef {
+    Slab *_slab{};
+
+    void release();
+
+  public:
+    SlabRef() = default;
+
+    //! \brief Adopt a reference that has already been counted (e.g. a freshly allocated slab)
+    explicit SlabRef(Slab *slab) noexcept : _slab(slab) {}
+
+    SlabRef(const SlabRef &other) noexcept : _slab(other._slab) {
+        if (_slab) {
+            _slab->_refs.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    SlabRef(SlabRef &&other) noexcept : _slab(other._slab) { other._slab = nullptr; }
+    SlabRef &operator=(SlabRef other) noexcept {
+        std::swap(_slab, other._slab);
+        return *this;
+    }
+    ~SlabRef() { release(); }
+
+    //! Drop the reference (the slab goes back to its pool when the last one is dropped)
+    void reset() {
+        release();
+        _slab = nullptr;
+    }
+
+    explicit operator bool() const { return _slab != nullptr; }
+
+    //! The referenced slab's bytes
+    char *data() const { return _slab->data(); }
+
+    //! How many bytes the referenced slab holds
+    size_t capacity() const { return _slab->capacity(); }
+};
+
+//! \brief Recycles the memory behind packet payloads
+//! \details Slabs come in power-of-two size classes from MIN_SLAB_SIZE to LARGE_SLAB_SIZE (the largest IPv4
+//! datagram), so a slab is never more than twice the size asked for. A slab whose last reference is dropped goes
+//! onto its class's free list, and the next get() of that class pops it instead of calling the allocator, so a
+//! steady stream of packets reuses the same few slabs. Each class keeps at most `retained_bytes` worth of free
+//! slabs; beyond that, released slabs are freed. The free lists are lock-free (a Treiber stack whose head carries
+//! a 16-bit tag against ABA), so Buffers may be released on any thread. Requests larger than the largest class
+//! get a slab that is freed rather than pooled.
+class BufferPool {
+  public:
+    static constexpr size_t MIN_SLAB_SIZE = 256;      //!< the smallest size class
+    static constexpr size_t SMALL_SLAB_SIZE = 2048;   //!< holds one MTU-sized frame
+    static constexpr size_t LARGE_SLAB_SIZE = 65536;  //!< holds the largest IPv4 datagram or UDP payload
+    static constexpr size_t SIZE_CLASSES = 9;         //!< MIN_SLAB_SIZE, twice that, ..., LARGE_SLAB_SIZE
+    static_assert(MIN_SLAB_SIZE << (SIZE_CLASSES - 1) == LARGE_SLAB_SIZE);
+
+    //! Copies of fewer bytes than this are better off in an exact-size allocation than in a slab
+    static constexpr size_t MIN_POOLED_SIZE = MIN_SLAB_SIZE / 2;
+
+    //! Free slabs each size class keeps by default, in bytes
+    static constexpr size_t DEFAULT_RETAINED_BYTES = size_t{1} << 20;
+
+    //! \brief Slabs to read one packet of unknown length into with a single scatter read (readv or recvmsg)
+    //! \details The read fills a small slab and then, only if the packet is longer, the rest of a large one (the
+    //! part after its first SMALL_SLAB_SIZE bytes). take() returns the packet as a Buffer: a packet that fit in the
+    //! small slab leaves the large one to go back to the pool, and a longer one gets the small slab's bytes copied
+    //! in front of the rest. A packet that would fill less than a quarter of its slab is copied into a slab of its
+    //! own size class instead, so that a short read does not pin a much larger slab.
+    class PacketSlabs {
+        BufferPool &_pool;
+        SlabRef _small;
+        SlabRef _large;
+
+      public:
+        explicit PacketSlabs(BufferPool &pool);
+
+        //! Where to read up to `limit` bytes, and how many of the iovecs are used (1 or 2)
+        std::pair<std::array<iovec, 2>, size_t> iovecs(const size_t limit = LARGE_SLAB_SIZE);
+
+        //! The first `length` bytes read, as a Buffer
+        Buffer take(const size_t length);
+    };
+
+  private:
+    //! A free list of same-size slabs
+    class FreeList {
+        //! slab pointer in the low 48 bits, tag in the high 16 (bumped on every pop)
+        std::atomic<uint64_t> _head{0};
+        std::atomic<size_t> _length{0};     //!< slabs on the list (an overestimate while pushes are under way)
+        std::atomic<unsigned> _poppers{0};  //!< pop() calls in progress
+
+      public:
+        FreeList() = default;
+        FreeList(const FreeList &other) = delete;
+        FreeList &operator=(const FreeList &other) = delete;
+        ~FreeList();
+
+        Slab *pop();
+
+        //! \returns false, having done nothing, if the slab should be freed instead: the list already holds
+        //! `limit` slabs (and no pop() is in progress that could still read the slab), or the slab's address
+        //! does not fit beside the tag
+        bool push(Slab *slab, const size_t limit);
+    };
+
+    std::array<FreeList, SIZE_CLASSES> _free_lists{};
+    const size_t _retained_bytes;
+    std::atomic<size_t> _allocations{0};  //!< slabs obtained from the allocator
+
+    //! The size class (an index into _free_lists) of a slab that holds `size` bytes
+    static size_t size_class(const size_t size);
+
+    Slab *_allocate(const size_t capacity, const bool pooled);
+
+    friend class SlabRef;
+    void _release(Slab *slab);
+
+  public:
+    //! \param retained_bytes how many bytes of free slabs each size class keeps for reuse
+    explicit BufferPool(const size_t retained_bytes = DEFAULT_RETAINED_BYTES) : _retained_bytes(retained_bytes) {}
+
+    //! \note Slabs must not outlive their pool; use global() for Buffers that are passed around.
+    ~BufferPool() = default;
+    BufferPool(const BufferPool &other) = delete;
+    BufferPool &operator=(const BufferPool &other) = delete;
+
+    //! A slab with room for at least `size` bytes
+    SlabRef get(const size_t size);
+
+    //! The number of slabs this pool has obtained from the allocator (e.g. to check that a workload recycles)
+    size_t allocations() const { return _allocations.load(std::memory_order_relaxed); }
+
+    //! The pool shared by the whole process (never destroyed, so Buffers may be released during exit)
+    static BufferPool &global();
+};
+
+#endif  // SPONGE_LIBSPONGE_BUFFER_POOL_HH
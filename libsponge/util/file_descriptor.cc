@@ -65,6 +65,30 @@ void FileDescriptor::read(std::string &str, const size_t limit) {
 
 //! \param[in] limit is the maximum number of bytes to read; fewer bytes may be returned
 //! \returns a vector of bytes read
+Buffer FileDescriptor::read_pooled(const size_t limit, BufferPool &pool) {
+    return _read_pooled(limit, pool, 0).value();
+}
+
+optional<Buffer> FileDescriptor::try_read_pooled(const size_t limit, BufferPool &pool) {
+    return _read_pooled(limit, pool, EAGAIN);
+}
+
+optional<Buffer> FileDescriptor::_read_pooled(const size_t limit, BufferPool &pool, const int errno_mask) {
+    BufferPool::PacketSlabs slabs{pool};
+    auto [iovecs, count] = slabs.iovecs(limit);
+
+    const ssize_t bytes_read = SystemCall("readv", ::readv(fd_num(), iovecs.data(), count), errno_mask);
+    register_read();  // even if nothing was waiting, the descriptor was serviced (the EventLoop checks)
+    if (bytes_read < 0) {
+        return {};
+    }
+    if (limit > 0 && bytes_read == 0) {
+        _internal_fd->_eof = true;
+    }
+
+    return slabs.take(bytes_read);
+}
+
 string FileDescriptor::read(const size_t limit) {
     string ret;
 
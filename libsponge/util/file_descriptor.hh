@@ -7,6 +7,7 @@
 #include <cstddef>
 #include <limits>
 #include <memory>
+#include <optional>
 
 //! A reference-counted handle to a file descriptor
 class FileDescriptor {
@@ -44,6 +45,9 @@ class FileDescriptor {
     // private constructor used to duplicate the FileDescriptor (increase the reference count)
     explicit FileDescriptor(std::shared_ptr<FDWrapper> other_shared_ptr);
 
+    //! read_pooled() and try_read_pooled(): nothing is returned if the read fails with `errno_mask`
+    std::optional<Buffer> _read_pooled(const size_t limit, BufferPool &pool, const int errno_mask);
+
   protected:
     void register_read() { ++_internal_fd->_read_count; }    //!< increment read count
     void register_write() { ++_internal_fd->_write_count; }  //!< increment write count
@@ -61,6 +65,15 @@ class FileDescriptor {
     //! Read up to `limit` bytes into `str` (caller can allocate storage)
     void read(std::string &str, const size_t limit = std::numeric_limits<size_t>::max());
 
+    //! \brief Read up to `limit` bytes (at most BufferPool::LARGE_SLAB_SIZE) into slabs from `pool`
+    //! \details One read() of a TUN or TAP device returns one packet, which this reads without allocating.
+    Buffer read_pooled(const size_t limit = BufferPool::LARGE_SLAB_SIZE, BufferPool &pool = BufferPool::global());
+
+    //! \brief Like read_pooled(), for a non-blocking descriptor
+    //! \returns nothing if no input was waiting
+    std::optional<Buffer> try_read_pooled(const size_t limit = BufferPool::LARGE_SLAB_SIZE,
+                                          BufferPool &pool = BufferPool::global());
+
     //! Write a string, possibly blocking until all is written
     size_t write(const char *str, const bool write_all = true) { return write(BufferViewList(str), write_all); }
 
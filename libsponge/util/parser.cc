@@ -18,7 +18,7 @@ string as_string(const ParseResult r) {
 }
 
 void NetParser::_check_size(const size_t size) {
-    if (size > _buffer.size()) {
+    if (size > _unparsed.size()) {
         set_error(ParseResult::PacketTooShort);
     }
 }
@@ -31,14 +31,8 @@ T NetParser::_parse_int() {
         return 0;
     }
 
-    T ret = 0;
-    for (size_t i = 0; i < len; i++) {
-        ret <<= 8;
-        ret += uint8_t(_buffer.at(i));
-    }
-
-    _buffer.remove_prefix(len);
-
+    const T ret = load_big_endian<T>(_unparsed.data());
+    _unparsed.remove_prefix(len);
     return ret;
 }
 
@@ -47,7 +41,13 @@ void NetParser::remove_prefix(const size_t n) {
     if (error()) {
         return;
     }
-    _buffer.remove_prefix(n);
+    _unparsed.remove_prefix(n);
+}
+
+Buffer NetParser::buffer() const {
+    Buffer ret = _buffer;
+    ret.remove_prefix(_buffer.size() - _unparsed.size());
+    return ret;
 }
 
 template <typename T>
@@ -5,7 +5,10 @@
 
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
+#include <optional>
 #include <string>
+#include <string_view>
 #include <utility>
 
 //! The result of parsing or unparsing an IP datagram, TCP segment, Ethernet frame, or ARP message
@@ -22,9 +25,80 @@ enum class ParseResult {
 //! Output a string representation of a ParseResult
 std::string as_string(const ParseResult r);
 
+//! Load a `T` stored in network byte order (big-endian) at `data`, which need not be aligned
+template <typename T>
+T load_big_endian(const char *data) {
+    T ret;
+    std::memcpy(&ret, data, sizeof(T));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    if constexpr (sizeof(T) == 2) {
+        ret = __builtin_bswap16(ret);
+    } else if constexpr (sizeof(T) == 4) {
+        ret = __builtin_bswap32(ret);
+    }
+#endif
+    return ret;
+}
+
+//! Store `val` in network byte order (big-endian) at `data`, which need not be aligned
+template <typename T>
+void store_big_endian(char *data, T val) {
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    if constexpr (sizeof(T) == 2) {
+        val = __builtin_bswap16(val);
+    } else if constexpr (sizeof(T) == 4) {
+        val = __builtin_bswap32(val);
+    }
+#endif
+    std::memcpy(data, &val, sizeof(T));
+}
+
+//! \brief A fixed-size header taken from a NetParser with a single length check
+//! \details Fields are read at offsets given at compile time, so reading one needs no further check.
+template <size_t N>
+class HeaderView {
+  private:
+    const char *_data;
+
+  public:
+    explicit HeaderView(const char *data) : _data(data) {}
+
+    //! Read the 8-bit integer at `Offset`
+    template <size_t Offset>
+    uint8_t u8() const {
+        static_assert(Offset + 1 <= N, "field beyond the end of the header");
+        return _data[Offset];
+    }
+
+    //! Read the 16-bit integer in network byte order at `Offset`
+    template <size_t Offset>
+    uint16_t u16() const {
+        static_assert(Offset + 2 <= N, "field beyond the end of the header");
+        return load_big_endian<uint16_t>(_data + Offset);
+    }
+
+    //! Read the 32-bit integer in network byte order at `Offset`
+    template <size_t Offset>
+    uint32_t u32() const {
+        static_assert(Offset + 4 <= N, "field beyond the end of the header");
+        return load_big_endian<uint32_t>(_data + Offset);
+    }
+
+    //! The `Len` bytes at `Offset` (e.g. an Ethernet address)
+    template <size_t Offset, size_t Len>
+    std::string_view bytes() const {
+        static_assert(Offset + Len <= N, "field beyond the end of the header");
+        return {_data + Offset, Len};
+    }
+};
+
+//! \brief A bounds-checked cursor over a Buffer
+//! \details Parsing only moves a std::string_view; the Buffer (and its reference count) is touched again only
+//! when buffer() takes what is left, e.g. a payload.
 class NetParser {
   private:
     Buffer _buffer;
+    std::string_view _unparsed;                 //!< The bytes of `_buffer` that have not been parsed yet
     ParseResult _error = ParseResult::NoError;  //!< Result of parsing so far
 
     //! Check that there is sufficient data to parse the next token
@@ -35,9 +109,13 @@ class NetParser {
     T _parse_int();
 
   public:
-    NetParser(Buffer buffer) : _buffer(buffer) {}
+    NetParser(Buffer buffer) : _buffer(std::move(buffer)), _unparsed(_buffer.str()) {}
+
+    //! The data that has not been parsed yet, as a slice of the original Buffer
+    Buffer buffer() const;
 
-    Buffer buffer() const { return _buffer; }
+    //! The data that has not been parsed yet, without touching the Buffer
+    std::string_view unparsed() const { return _unparsed; }
 
     //! Get the current value stored in BaseParser::_error
     ParseResult get_error() const { return _error; }
@@ -60,6 +138,19 @@ class NetParser {
 
     //! Remove n bytes from the buffer
     void remove_prefix(const size_t n);
+
+    //! \brief Take the next `N` bytes as a fixed-size header
+    //! \returns a view of them, or nothing (and the PacketTooShort error) if there are fewer than `N` bytes left
+    template <size_t N>
+    std::optional<HeaderView<N>> header() {
+        _check_size(N);
+        if (error()) {
+            return {};
+        }
+        HeaderView<N> ret{_unparsed.data()};
+        _unparsed.remove_prefix(N);
+        return ret;
+    }
 };
 
 struct NetUnparser {
@@ -74,6 +165,14 @@ struct NetUnparser {
 
     //! Write an 8-bit integer into the data stream in network byte order
     static void u8(std::string &s, const uint8_t val);
+
+    //! \name Writing into a caller-provided buffer
+    //! \details Each writes at `out` and advances it; the caller has made sure there is room.
+    //!@{
+    static void u32(char *&out, const uint32_t val) { store_big_endian(out, val), out += sizeof(val); }
+    static void u16(char *&out, const uint16_t val) { store_big_endian(out, val), out += sizeof(val); }
+    static void u8(char *&out, const uint8_t val) { *out++ = static_cast<char>(val); }
+    //!@}
 };
 
 #endif  // SPONGE_LIBSPONGE_PARSER_HH
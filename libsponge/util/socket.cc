@@ -112,6 +112,36 @@ UDPSocket::received_datagram UDPSocket::recv(const size_t mtu) {
     return ret;
 }
 
+UDPSocket::received_buffer UDPSocket::recv_pooled(BufferPool &pool) { return _recv_pooled(pool, 0).value(); }
+
+optional<UDPSocket::received_buffer> UDPSocket::try_recv_pooled(BufferPool &pool) {
+    return _recv_pooled(pool, MSG_DONTWAIT);
+}
+
+optional<UDPSocket::received_buffer> UDPSocket::_recv_pooled(BufferPool &pool, const int flags) {
+    BufferPool::PacketSlabs slabs{pool};
+    auto [iovecs, count] = slabs.iovecs();
+    Address::Raw datagram_source_address;
+
+    msghdr message{};
+    message.msg_name = datagram_source_address;
+    message.msg_namelen = sizeof(datagram_source_address);
+    message.msg_iov = iovecs.data();
+    message.msg_iovlen = count;
+
+    const ssize_t recv_len =
+        SystemCall("recvmsg", ::recvmsg(fd_num(), &message, flags), flags & MSG_DONTWAIT ? EAGAIN : 0);
+    register_read();  // even if nothing was waiting, the socket was serviced (the EventLoop checks)
+    if (recv_len < 0) {
+        return {};
+    }
+    if (message.msg_flags & MSG_TRUNC) {
+        throw runtime_error("recvmsg (oversized datagram)");
+    }
+
+    return received_buffer{{datagram_source_address, message.msg_namelen}, slabs.take(recv_len)};
+}
+
 void sendmsg_helper(const int fd_num,
                     const sockaddr *destination_address,
                     const socklen_t destination_address_len,
@@ -6,6 +6,7 @@
 
 #include <cstdint>
 #include <functional>
+#include <optional>
 #include <string>
 #include <sys/socket.h>
 
@@ -70,11 +71,29 @@ class UDPSocket : public Socket {
     //! Receive a datagram and the Address of its sender (caller can allocate storage)
     void recv(received_datagram &datagram, const size_t mtu = 65536);
 
+    //! Returned by UDPSocket::recv_pooled; like received_datagram, with the payload in slabs from a BufferPool
+    struct received_buffer {
+        Address source_address;  //!< Address from which this datagram was received
+        Buffer payload;          //!< UDP datagram payload
+    };
+
+    //! Receive a datagram (of up to BufferPool::LARGE_SLAB_SIZE bytes) and the Address of its sender,
+    //! without allocating
+    received_buffer recv_pooled(BufferPool &pool = BufferPool::global());
+
+    //! Like recv_pooled(), but without blocking: returns nothing if no datagram was waiting
+    std::optional<received_buffer> try_recv_pooled(BufferPool &pool = BufferPool::global());
+
     //! Send a datagram to specified Address
     void sendto(const Address &destination, const BufferViewList &payload);
 
     //! Send datagram to the socket's connected address (must call connect() first)
     void send(const BufferViewList &payload);
+
+  private:
+    //! recv_pooled() and try_recv_pooled(): `flags` are passed to recvmsg(); with MSG_DONTWAIT, returns nothing
+    //! if no datagram was waiting
+    std::optional<received_buffer> _recv_pooled(BufferPool &pool, const int flags);
 };
 
 //! \class UDPSocket
@@ -3,11 +3,17 @@
 #include <array>
 #include <cctype>
 #include <chrono>
+#include <cstring>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
+#include <stdexcept>
 #include <sys/socket.h>
 
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#endif
+
 using namespace std;
 
 //! \returns the number of milliseconds since the program started
@@ -84,27 +90,216 @@ mt19937 get_random_generator() {
 //!
 //! For more information, see the [Wikipedia page](https://en.wikipedia.org/wiki/IPv4_header_checksum)
 //! on the Internet checksum, and consult the [IP](\ref rfc::rfc791) and [TCP](\ref rfc::rfc793) RFCs.
+namespace {
+
+//! A summation kernel: the sum of the data taken as native-endian 32-bit words (and a final 16-bit word),
+//! which folds to the same one's-complement sum as the big-endian 16-bit words, byte-swapped (RFC 1071).
+//! With a non-null `dest` (the Copy instantiations), the data is also copied there in the same pass.
+using SumFunction = uint64_t (*)(const char *data, size_t len, char *dest);
+
+template <bool Copy>
+uint64_t sum_scalar(const char *data, size_t len, char *dest) {
+    uint64_t sum = 0;
+    for (; len >= 8; data += 8, len -= 8) {
+        uint64_t word;
+        memcpy(&word, data, sizeof(word));
+        if constexpr (Copy) {
+            memcpy(dest, &word, sizeof(word));
+            dest += 8;
+        }
+        sum += (word >> 32) + (word & 0xffffffff);
+    }
+    for (; len >= 2; data += 2, len -= 2) {
+        uint16_t word;
+        memcpy(&word, data, sizeof(word));
+        if constexpr (Copy) {
+            memcpy(dest, &word, sizeof(word));
+            dest += 2;
+        }
+        sum += word;
+    }
+    return sum;
+}
+
+#if defined(__x86_64__) && defined(__GNUC__)
+//! SSE2 is part of x86-64, so this kernel is always available there
+template <bool Copy>
+uint64_t sum_sse2(const char *data, size_t len, char *dest) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc = zero;
+    for (; len >= 16; data += 16, len -= 16) {
+        // widen the four 32-bit words to 64-bit lanes so that they cannot overflow
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data));
+        if constexpr (Copy) {
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(dest), v);
+            dest += 16;
+        }
+        acc = _mm_add_epi64(acc, _mm_unpacklo_epi32(v, zero));
+        acc = _mm_add_epi64(acc, _mm_unpackhi_epi32(v, zero));
+    }
+    alignas(16) uint64_t lanes[2];
+    _mm_store_si128(reinterpret_cast<__m128i *>(lanes), acc);
+    return lanes[0] + lanes[1] + sum_scalar<Copy>(data, len, dest);
+}
+
+template <bool Copy>
+__attribute__((target("avx2"))) uint64_t sum_avx2(const char *data, size_t len, char *dest) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i acc0 = zero;
+    __m256i acc1 = zero;
+    for (; len >= 64; data += 64, len -= 64) {
+        const __m256i v0 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data));
+        const __m256i v1 = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + 32));
+        if constexpr (Copy) {
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dest), v0);
+            _mm256_storeu_si256(reinterpret_cast<__m256i *>(dest + 32), v1);
+            dest += 64;
+        }
+        acc0 = _mm256_add_epi64(acc0, _mm256_unpacklo_epi32(v0, zero));
+        acc1 = _mm256_add_epi64(acc1, _mm256_unpackhi_epi32(v0, zero));
+        acc0 = _mm256_add_epi64(acc0, _mm256_unpacklo_epi32(v1, zero));
+        acc1 = _mm256_add_epi64(acc1, _mm256_unpackhi_epi32(v1, zero));
+    }
+    alignas(32) uint64_t lanes[4];
+    _mm256_store_si256(reinterpret_cast<__m256i *>(lanes), _mm256_add_epi64(acc0, acc1));
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + sum_sse2<Copy>(data, len, dest);
+}
+#endif
+
+template <bool Copy>
+SumFunction sum_function(const InternetChecksum::Kernel kernel) {
+    switch (kernel) {
+#if defined(__x86_64__) && defined(__GNUC__)
+        case InternetChecksum::Kernel::AVX2:
+            return sum_avx2<Copy>;
+        case InternetChecksum::Kernel::SSE2:
+            return sum_sse2<Copy>;
+#endif
+        default:
+            return sum_scalar<Copy>;
+    }
+}
+
+InternetChecksum::Kernel best_kernel() {
+    for (const auto kernel : {InternetChecksum::Kernel::AVX2, InternetChecksum::Kernel::SSE2}) {
+        if (InternetChecksum::kernel_supported(kernel)) {
+            return kernel;
+        }
+    }
+    return InternetChecksum::Kernel::Scalar;
+}
+
+//! the kernel add() uses; a function-local static so that it is ready even during static initialization
+InternetChecksum::Kernel &current_kernel() {
+    static InternetChecksum::Kernel kernel = best_kernel();
+    return kernel;
+}
+
+SumFunction &current_sum() {
+    static SumFunction sum = sum_function<false>(current_kernel());
+    return sum;
+}
+
+SumFunction &current_sum_and_copy() {
+    static SumFunction sum = sum_function<true>(current_kernel());
+    return sum;
+}
+
+//! one's-complement sum folded to 16 bits (with end-around carry)
+uint16_t fold(uint64_t sum) {
+    while (sum > 0xffff) {
+        sum = (sum >> 16) + (sum & 0xffff);
+    }
+    return sum;
+}
+
+}  // namespace
+
 InternetChecksum::InternetChecksum(const uint32_t initial_sum) : _sum(initial_sum) {}
 
-void InternetChecksum::add(std::string_view data) {
-    for (size_t i = 0; i < data.size(); i++) {
-        uint16_t val = uint8_t(data[i]);
-        if (not _parity) {
-            val <<= 8;
+void InternetChecksum::add(std::string_view data) { add_and_copy(data, nullptr); }
+
+//! \param[in] data the bytes to add to the checksum
+//! \param[out] dest where to copy `data` (`data.size()` bytes), or nullptr to only sum it
+void InternetChecksum::add_and_copy(std::string_view data, char *dest) {
+    if (data.empty()) {
+        return;
+    }
+
+    // a byte left over from the previous call is the low half of its 16-bit word
+    if (_parity) {
+        _sum += uint8_t(data.front());
+        if (dest != nullptr) {
+            *dest++ = data.front();
         }
-        _sum += val;
-        _parity = !_parity;
+        data.remove_prefix(1);
+        _parity = false;
+    }
+
+    const size_t even = data.size() & ~size_t{1};
+    uint16_t words = fold(dest != nullptr ? current_sum_and_copy()(data.data(), even, dest)
+                                          : current_sum()(data.data(), even, nullptr));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    words = static_cast<uint16_t>((words >> 8) | (words << 8));
+#endif
+    _sum += words;
+
+    if (data.size() > even) {
+        _sum += uint16_t(uint8_t(data.back()) << 8);
+        if (dest != nullptr) {
+            dest[even] = data.back();
+        }
+        _parity = true;
+    }
+}
+
+uint16_t InternetChecksum::value() const { return ~fold(_sum); }
+
+bool InternetChecksum::kernel_supported(const Kernel kernel) {
+    switch (kernel) {
+#if defined(__x86_64__) && defined(__GNUC__)
+        case Kernel::AVX2:
+            return __builtin_cpu_supports("avx2");
+        case Kernel::SSE2:
+            return true;
+#endif
+        case Kernel::Scalar:
+            return true;
+        default:
+            return false;
     }
 }
 
-uint16_t InternetChecksum::value() const {
-    uint32_t ret = _sum;
+void InternetChecksum::use_kernel(const Kernel kernel) {
+    if (not kernel_supported(kernel)) {
+        throw runtime_error(string("InternetChecksum: kernel not supported by this CPU: ") + kernel_name(kernel));
+    }
+    current_kernel() = kernel;
+    current_sum() = sum_function<false>(kernel);
+    current_sum_and_copy() = sum_function<true>(kernel);
+}
+
+InternetChecksum::Kernel InternetChecksum::kernel() { return current_kernel(); }
 
-    while (ret > 0xffff) {
-        ret = (ret >> 16) + (ret & 0xffff);
+const char *InternetChecksum::kernel_name(const Kernel kernel) {
+    switch (kernel) {
+        case Kernel::AVX2:
+            return "avx2";
+        case Kernel::SSE2:
+            return "sse2";
+        default:
+            return "scalar";
     }
+}
+
+//! \details HC' = ~(~HC + ~m + m') (RFC 1624, eqn. 3)
+uint16_t InternetChecksum::update(const uint16_t checksum, const uint16_t old_word, const uint16_t new_word) {
+    return ~fold(uint32_t{uint16_t(~checksum)} + uint16_t(~old_word) + new_word);
+}
 
-    return ~ret;
+uint16_t InternetChecksum::update32(const uint16_t checksum, const uint32_t old_field, const uint32_t new_field) {
+    const uint16_t high = update(checksum, old_field >> 16, new_field >> 16);
+    return update(high, old_field & 0xffff, new_field & 0xffff);
 }
 
 //! \param[in] data is a pointer to the bytes to show
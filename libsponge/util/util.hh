@@ -54,13 +54,35 @@ uint64_t timestamp_ms();
 //! The internet checksum algorithm
 class InternetChecksum {
   private:
-    uint32_t _sum;
+    uint64_t _sum;
     bool _parity{};
 
   public:
     InternetChecksum(const uint32_t initial_sum = 0);
     void add(std::string_view data);
     uint16_t value() const;
+
+    //! \brief Copy `data` to `dest` while adding it to the checksum, in a single pass over the bytes
+    //! (e.g. when a received payload is copied into a stream anyway)
+    void add_and_copy(std::string_view data, char *dest);
+
+    //! \name Summation kernels
+    //! add() sums the data in 64-bit lanes with the widest kernel the CPU supports, chosen at run time;
+    //! the others can be selected for testing and benchmarking
+    //!@{
+    enum class Kernel { Scalar, SSE2, AVX2 };
+    static bool kernel_supported(const Kernel kernel);  //!< Can this CPU run `kernel`?
+    static void use_kernel(const Kernel kernel);        //!< Select the kernel used by add() (must be supported)
+    static Kernel kernel();                             //!< The kernel used by add()
+    static const char *kernel_name(const Kernel kernel);
+    //!@}
+
+    //! \brief Incremental update (RFC 1624): the checksum after one 16-bit word of the checksummed data
+    //! changed from `old_word` to `new_word`, e.g. the TTL and protocol word of an IPv4 header
+    static uint16_t update(const uint16_t checksum, const uint16_t old_word, const uint16_t new_word);
+
+    //! \brief Incremental update (RFC 1624) for a 32-bit field, e.g. a sequence or acknowledgment number
+    static uint16_t update32(const uint16_t checksum, const uint32_t old_field, const uint32_t new_field);
 };
 
 //! Hexdump the contents of a packet (or any other sequence of bytes)
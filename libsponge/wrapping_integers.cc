@@ -10,6 +10,21 @@ void DUMMY_CODE(Targs &&... /* unused */) {}
 
 using namespace std;
 
+namespace {
+/**
+ * 距离checkpoint最近、且wrap后等于n的绝对序列号，一定落在[checkpoint - 2^31, checkpoint + 2^31)之内，
+ * 它与checkpoint的距离恰好就是n与wrap(checkpoint)之间的有符号32位差值，不需要再枚举三个候选值比较距离
+ * 唯一的例外是checkpoint太小、结果会小于0：此时只能取上方的那个值，即再加上2^32
+*/
+inline uint64_t unwrap_offset(const uint32_t n, const uint32_t wrapped_checkpoint, const uint64_t checkpoint) {
+    const int32_t offset = static_cast<int32_t>(n - wrapped_checkpoint);
+    const uint64_t result = checkpoint + static_cast<uint64_t>(static_cast<int64_t>(offset));
+    //offset < 0时结果应当比checkpoint小，如果反而更大，说明发生了下溢
+    const uint64_t underflow = (offset < 0) & (result > checkpoint);
+    return result + (underflow << 32);
+}
+}  // namespace
+
 //! Transform an "absolute" 64-bit sequence number (zero-indexed) into a WrappingInt32
 //! \param n The input absolute 64-bit sequence number
 //! \param isn The initial sequence number
@@ -29,20 +44,14 @@ WrappingInt32 wrap(uint64_t n, WrappingInt32 isn) {
 //! and the other stream runs from the remote TCPSender to the local TCPReceiver and
 //! has a different ISN.
 uint64_t unwrap(WrappingInt32 n, WrappingInt32 isn, uint64_t checkpoint) {
-    //获取初始绝对序列号，它的范围必然位于 0 ~ (2^31 - 1)
-    uint64_t init_absseqno = n.raw_value() >= isn.raw_value() ?
-                             n.raw_value() - isn.raw_value() : n.raw_value() + (1UL << 32) - isn.raw_value();
-    //checkpoint含有多少个完整的2^32 ?
-    uint64_t n_power = checkpoint / (1UL << 32);
-    //将其左偏移、右偏移、不偏移，考察哪个距离最短即可
-    uint64_t absseqno0 = init_absseqno + (n_power <= 1 ? n_power : n_power - 1) * (1UL << 32);
-    uint64_t absseqno1 = init_absseqno + n_power * (1UL << 32);
-    uint64_t absseqno2 = init_absseqno + (n_power + 1) * (1UL << 32);
-    uint64_t distance0 = absseqno0 >= checkpoint ? absseqno0 - checkpoint : checkpoint - absseqno0;
-    uint64_t distance1 = absseqno1 >= checkpoint ? absseqno1 - checkpoint : checkpoint - absseqno1;
-    uint64_t distance2 = absseqno2 >= checkpoint ? absseqno2 - checkpoint : checkpoint - absseqno2;
-    return distance0 <= distance1 ? 
-           (distance0 <= distance2 ? absseqno0 : absseqno2) :
-           (distance1 <= distance2 ? absseqno1 : absseqno2);
+    return unwrap_offset(n.raw_value(), wrap(checkpoint, isn).raw_value(), checkpoint);
+}
 
+//! \details wrap(checkpoint, isn) is computed once for the whole batch; the loop body has no
+//! branches or divisions, so the compiler can vectorize it.
+void unwrap_n(const WrappingInt32 *n, const size_t count, WrappingInt32 isn, uint64_t checkpoint, uint64_t *out) {
+    const uint32_t wrapped_checkpoint = wrap(checkpoint, isn).raw_value();
+    for (size_t i = 0; i < count; i++) {
+        out[i] = unwrap_offset(n[i].raw_value(), wrapped_checkpoint, checkpoint);
+    }
 }
@@ -1,6 +1,7 @@
 #ifndef SPONGE_LIBSPONGE_WRAPPING_INTEGERS_HH
 #define SPONGE_LIBSPONGE_WRAPPING_INTEGERS_HH
 
+#include <cstddef>
 #include <cstdint>
 #include <ostream>
 
@@ -35,6 +36,14 @@ WrappingInt32 wrap(uint64_t n, WrappingInt32 isn);
 //! has a different ISN.
 uint64_t unwrap(WrappingInt32 n, WrappingInt32 isn, uint64_t checkpoint);
 
+//! Unwrap `count` relative sequence numbers against the same ISN and checkpoint
+//! \param n the relative sequence numbers
+//! \param count how many of them
+//! \param isn The initial sequence number
+//! \param checkpoint A recent absolute sequence number
+//! \param out receives `count` absolute sequence numbers; `out[i]` equals `unwrap(n[i], isn, checkpoint)`
+void unwrap_n(const WrappingInt32 *n, const size_t count, WrappingInt32 isn, uint64_t checkpoint, uint64_t *out);
+
 //! \name Helper functions
 //!@{
 
@@ -0,0 +1,213 @@
+#include "buffer.hh"
+#include "buffer_pool.hh"
+#include "byte_stream.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <sys/uio.h>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+//! random bytes
+static string random_string(const size_t len) {
+    auto rd = get_random_generator();
+    string ret(len, 0);
+    for (auto &c : ret) {
+        c = static_cast<char>(rd());
+    }
+    return ret;
+}
+
+//! what a readv() of `data` into the iovecs would have done
+static size_t scatter(const pair<array<iovec, 2>, size_t> &iovecs, const string_view data) {
+    size_t done = 0;
+    for (size_t i = 0; i < iovecs.second and done < data.size(); i++) {
+        const size_t n = min(iovecs.first[i].iov_len, data.size() - done);
+        memcpy(iovecs.first[i].iov_base, data.data() + done, n);
+        done += n;
+    }
+    return done;
+}
+
+int main() {
+    try {
+        // test 1: size classes, and a released slab is handed out again without touching the allocator
+        {
+            BufferPool pool;
+            char *small_data = nullptr;
+            {
+                const SlabRef tiny = pool.get(100);
+                const SlabRef small = pool.get(BufferPool::SMALL_SLAB_SIZE);
+                const SlabRef medium = pool.get(BufferPool::SMALL_SLAB_SIZE + 1);
+                const SlabRef large = pool.get(BufferPool::LARGE_SLAB_SIZE);
+                const SlabRef huge = pool.get(BufferPool::LARGE_SLAB_SIZE + 1);
+                test_err_if(tiny.capacity() != BufferPool::MIN_SLAB_SIZE or
+                                small.capacity() != BufferPool::SMALL_SLAB_SIZE or
+                                medium.capacity() != 2 * BufferPool::SMALL_SLAB_SIZE or
+                                large.capacity() != BufferPool::LARGE_SLAB_SIZE or
+                                huge.capacity() != BufferPool::LARGE_SLAB_SIZE + 1,
+                            "test 1 failed: wrong size classes");
+                test_err_if(pool.allocations() != 5, "test 1 failed: wrong number of allocations");
+                small_data = small.data();
+            }
+            for (unsigned i = 0; i < 100; i++) {
+                const SlabRef small = pool.get(BufferPool::SMALL_SLAB_SIZE - i);
+                const SlabRef large = pool.get(BufferPool::LARGE_SLAB_SIZE);
+                test_err_if(small.data() != small_data, "test 1 failed: slab not reused");
+            }
+            test_err_if(pool.allocations() != 5, "test 1 failed: pooled slabs were not recycled");
+        }
+
+        // test 1b: each size class keeps only `retained_bytes` of free slabs
+        {
+            BufferPool pool{2 * BufferPool::LARGE_SLAB_SIZE};
+            for (unsigned round = 0; round < 3; round++) {
+                vector<SlabRef> slabs;
+                for (unsigned i = 0; i < 5; i++) {
+                    slabs.push_back(pool.get(BufferPool::LARGE_SLAB_SIZE));
+                }
+            }
+            // two of the five slabs survive each round
+            test_err_if(pool.allocations() != 5 + 3 + 3, "test 1b failed: wrong number of slabs retained");
+        }
+
+        // test 2: a Buffer keeps its slab alive through copies and slices, and gives it back with the last one
+        {
+            BufferPool pool;
+            const string data = random_string(1000);
+            char *slab_data = nullptr;
+            {
+                Buffer whole = Buffer::copy_of(data, pool);
+                slab_data = const_cast<char *>(whole.str().data());
+                Buffer tail = whole;
+                tail.remove_prefix(600);
+                whole.remove_suffix(400);
+                test_err_if(whole.str() != string_view(data).substr(0, 600) or tail.str() != string_view(data).substr(600),
+                            "test 2 failed: slices have wrong contents");
+                test_err_if(tail.str().data() != slab_data + 600, "test 2 failed: slice copied");
+
+                whole = Buffer{};
+                test_err_if(pool.get(data.size()).data() == slab_data,
+                            "test 2 failed: slab recycled while still referenced");
+                tail.remove_prefix(tail.size());  // an emptied Buffer lets go of its slab right away
+                test_err_if(pool.get(data.size()).data() != slab_data,
+                            "test 2 failed: slab not released by the last reference");
+            }
+            test_err_if(pool.allocations() != 2, "test 2 failed: wrong number of allocations");
+
+            bool threw = false;
+            try {
+                Buffer too_long{pool.get(1), BufferPool::MIN_SLAB_SIZE + 1};
+            } catch (const out_of_range &) {
+                threw = true;
+            }
+            test_err_if(not threw, "test 2 failed: Buffer longer than its slab");
+        }
+
+        // test 3: copy_of
+        {
+            test_err_if(Buffer::copy_of("").size() != 0, "test 3 failed: empty copy");
+            // a copy never keeps more than twice its size alive (tiny ones are not put in slabs at all)
+            for (size_t len = 1; len <= BufferPool::LARGE_SLAB_SIZE; len += 1 + len / 3) {
+                const Buffer copy = Buffer::copy_of(string(len, 'x'));
+                test_err_if(copy.size() != len or copy.storage_size() > max<size_t>(2 * len, 15),
+                            "test 3 failed: copy of " + to_string(len) + " bytes holds " +
+                                to_string(copy.storage_size()));
+            }
+            const string data = random_string(BufferPool::LARGE_SLAB_SIZE + 100);
+            for (const size_t len : {size_t{1}, size_t{1500}, size_t{BufferPool::LARGE_SLAB_SIZE}, data.size()}) {
+                test_err_if(Buffer::copy_of(string_view(data).substr(0, len)).str() != string_view(data).substr(0, len),
+                            "test 3 failed: copy differs");
+            }
+        }
+
+        // test 4: a packet lands in the small slab, or runs over into the large one and comes back contiguous
+        {
+            BufferPool pool;
+            const string data = random_string(BufferPool::LARGE_SLAB_SIZE);
+            for (const size_t len : {size_t{0},
+                                     size_t{64},
+                                     size_t{BufferPool::SMALL_SLAB_SIZE},
+                                     size_t{BufferPool::SMALL_SLAB_SIZE + 1},
+                                     size_t{3000},
+                                     size_t{BufferPool::LARGE_SLAB_SIZE / 4 + 1},
+                                     size_t{BufferPool::LARGE_SLAB_SIZE}}) {
+                BufferPool::PacketSlabs slabs{pool};
+                const auto iovecs = slabs.iovecs();
+                test_err_if(iovecs.first[0].iov_len + iovecs.first[1].iov_len != BufferPool::LARGE_SLAB_SIZE,
+                            "test 4 failed: wrong read limit");
+                const size_t got = scatter(iovecs, string_view(data).substr(0, len));
+                const Buffer packet = slabs.take(got);
+                test_err_if(packet.str() != string_view(data).substr(0, len), "test 4 failed: wrong packet");
+
+                // an empty read keeps nothing, a long packet stays where it was read (only the small slab's
+                // bytes are copied in front), and no packet keeps more than four times its size
+                test_err_if(packet.storage_size() > 4 * len, "test 4 failed: packet in an oversized slab");
+                if (len > BufferPool::LARGE_SLAB_SIZE / 4) {
+                    test_err_if(packet.str().data() + BufferPool::SMALL_SLAB_SIZE != iovecs.first[1].iov_base,
+                                "test 4 failed: long packet moved");
+                }
+            }
+            BufferPool::PacketSlabs slabs{pool};
+            test_err_if(slabs.iovecs(100).second != 1 or slabs.iovecs(100).first[0].iov_len != 100,
+                        "test 4 failed: limit not respected");
+            // the small and large slabs, and the ones the 64- and 3000-byte packets were copied into
+            test_err_if(pool.allocations() != 4, "test 4 failed: packet slabs were not recycled");
+        }
+
+        // test 5: ByteStream::read_contiguous returns the stream's bytes in order, in both modes
+        for (const auto mode : {ByteStream::Mode::Ring, ByteStream::Mode::Chunked}) {
+            auto rd = get_random_generator();
+            const string data = random_string(200000);
+            ByteStream stream{10000, mode};
+            size_t written = 0, read = 0;
+            while (read < data.size()) {
+                const size_t to_write = min<size_t>(rd() % 3000, data.size() - written);
+                written += stream.write(data.substr(written, to_write));
+                const Buffer out = stream.read_contiguous(rd() % 4000);
+                test_err_if(out.str() != string_view(data).substr(read, out.size()),
+                            "test 5 failed: wrong bytes read");
+                read += out.size();
+                test_err_if(stream.bytes_read() != read, "test 5 failed: bytes not popped");
+            }
+        }
+
+        // test 6: the free lists survive concurrent gets and releases, with slabs both kept and freed (the second
+        // pool retains almost nothing); with room to keep them, each thread reuses what it releases
+        for (const size_t retained_bytes : {BufferPool::DEFAULT_RETAINED_BYTES, size_t{4096}}) {
+            BufferPool pool{retained_bytes};
+            constexpr unsigned threads = 4;
+            vector<thread> workers;
+            for (unsigned t = 0; t < threads; t++) {
+                workers.emplace_back([&pool, t] {
+                    for (unsigned i = 0; i < 20000; i++) {
+                        Buffer b = Buffer::copy_of(string(1 + (i + t) % 3000, static_cast<char>(t)), pool);
+                        if (b.str().find_first_not_of(static_cast<char>(t)) != string_view::npos) {
+                            throw runtime_error("test 6 failed: slab shared between threads");
+                        }
+                    }
+                });
+            }
+            for (auto &w : workers) {
+                w.join();
+            }
+            // the copies fall into five size classes (256 to 4096 bytes)
+            test_err_if(retained_bytes == BufferPool::DEFAULT_RETAINED_BYTES and pool.allocations() > 5 * threads,
+                        "test 6 failed: slabs were not recycled");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,62 @@
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main() {
+    try {
+        {
+            ByteStreamTestHarness test{"chunked-write-read", 15, ByteStream::Mode::Chunked};
+
+            test.execute(Write{"cat"});
+            test.execute(Write{"tac"});
+
+            test.execute(BytesWritten{6});
+            test.execute(RemainingCapacity{9});
+            test.execute(BufferSize{6});
+            test.execute(Peek{"cattac"});
+            test.execute(PeekViews{"cat", "tac"});
+
+            test.execute(ReadBuffers{"catt", 2});
+
+            test.execute(BytesRead{4});
+            test.execute(BufferSize{2});
+            test.execute(Peek{"ac"});
+            test.execute(PeekViews{"ac", ""});
+            test.execute(RemainingCapacity{13});
+        }
+
+        {
+            ByteStreamTestHarness test{"chunked-overwrite", 4, ByteStream::Mode::Chunked};
+
+            test.execute(Write{"cat"}.with_bytes_written(3));
+            test.execute(Write{"dog"}.with_bytes_written(1));
+            test.execute(Write{"x"}.with_bytes_written(0));
+
+            test.execute(RemainingCapacity{0});
+            test.execute(Peek{"catd"});
+
+            test.execute(Pop{2});
+            test.execute(Peek{"td"});
+            test.execute(Write{"og"}.with_bytes_written(2));
+            test.execute(Peek{"tdog"});
+
+            test.execute(ReadBuffers{"t", 1});
+            test.execute(ReadBuffers{"dog", 2});
+            test.execute(EndInput{});
+
+            test.execute(BufferEmpty{true});
+            test.execute(Eof{true});
+            test.execute(BytesRead{6});
+            test.execute(BytesWritten{6});
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
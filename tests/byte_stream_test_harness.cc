@@ -45,11 +45,13 @@ void ByteStreamAction::execute(ByteStream &) const {}
 
 ByteStreamAction::~ByteStreamAction() {}
 
-ByteStreamTestHarness::ByteStreamTestHarness(const std::string &test_name, const size_t capacity)
-    : _test_name(test_name), _byte_stream(capacity) {
+ByteStreamTestHarness::ByteStreamTestHarness(const std::string &test_name,
+                                             const size_t capacity,
+                                             const ByteStream::Mode mode)
+    : _test_name(test_name), _byte_stream(capacity, mode) {
     std::ostringstream ss;
     ss << "Initialized with ("
-       << "capacity=" << capacity << ")";
+       << "capacity=" << capacity << (mode == ByteStream::Mode::Chunked ? ", chunked" : "") << ")";
     _steps_executed.emplace_back(ss.str());
 }
 
@@ -102,6 +104,23 @@ Pop::Pop(const size_t len) : _len(len) {}
 std::string Pop::description() const { return "pop " + to_string(_len); }
 void Pop::execute(ByteStream &bs) const { bs.pop_output(_len); }
 
+// ReadBuffers
+ReadBuffers::ReadBuffers(const std::string &output, const size_t buffer_count)
+    : _output(output), _buffer_count(buffer_count) {}
+std::string ReadBuffers::description() const {
+    return "\"" + _output + "\" read as " + to_string(_buffer_count) + " buffer(s)";
+}
+void ReadBuffers::execute(ByteStream &bs) const {
+    const auto output = bs.read_buffers(_output.size());
+    if (output.concatenate() != _output) {
+        throw ByteStreamExpectationViolation("Expected to read \"" + _output + "\", but read \"" +
+                                             output.concatenate() + "\"");
+    }
+    if (output.buffers().size() != _buffer_count) {
+        throw ByteStreamExpectationViolation::property("buffer count", _buffer_count, output.buffers().size());
+    }
+}
+
 // InputEnded
 InputEnded::InputEnded(const bool input_ended) : _input_ended(input_ended) {}
 std::string InputEnded::description() const { return "input_ended: " + to_string(_input_ended); }
@@ -182,3 +201,17 @@ void Peek::execute(ByteStream &bs) const {
                                              output + "\"");
     }
 }
+
+// PeekViews
+PeekViews::PeekViews(const std::string &first, const std::string &second) : _first(first), _second(second) {}
+std::string PeekViews::description() const {
+    return "\"" + _first + "\" + \"" + _second + "\" as the views at the front of the stream";
+}
+void PeekViews::execute(ByteStream &bs) const {
+    const auto [first, second] = bs.peek_views(_first.size() + _second.size());
+    if (first != _first or second != _second) {
+        throw ByteStreamExpectationViolation("Expected views \"" + _first + "\" + \"" + _second +
+                                             "\" at the front of the stream, but found \"" + std::string(first) +
+                                             "\" + \"" + std::string(second) + "\"");
+    }
+}
@@ -64,6 +64,15 @@ struct Pop : public ByteStreamAction {
     void execute(ByteStream &) const override;
 };
 
+struct ReadBuffers : public ByteStreamExpectation {
+    std::string _output;
+    size_t _buffer_count;
+
+    ReadBuffers(const std::string &output, const size_t buffer_count);
+    std::string description() const override;
+    void execute(ByteStream &) const override;
+};
+
 struct InputEnded : public ByteStreamExpectation {
     bool _input_ended;
 
@@ -128,13 +137,24 @@ struct Peek : public ByteStreamExpectation {
     void execute(ByteStream &) const override;
 };
 
+struct PeekViews : public ByteStreamExpectation {
+    std::string _first;
+    std::string _second;
+
+    PeekViews(const std::string &first, const std::string &second);
+    std::string description() const override;
+    void execute(ByteStream &) const override;
+};
+
 class ByteStreamTestHarness {
     std::string _test_name;
     ByteStream _byte_stream;
     std::vector<std::string> _steps_executed{};
 
   public:
-    ByteStreamTestHarness(const std::string &test_name, const size_t capacity);
+    ByteStreamTestHarness(const std::string &test_name,
+                          const size_t capacity,
+                          const ByteStream::Mode mode = ByteStream::Mode::Ring);
 
     void execute(const ByteStreamTestStep &step);
 };
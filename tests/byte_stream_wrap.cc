@@ -0,0 +1,71 @@
+#include "byte_stream.hh"
+#include "byte_stream_test_harness.hh"
+
+#include <exception>
+#include <iostream>
+
+using namespace std;
+
+int main() {
+    try {
+        {
+            ByteStreamTestHarness test{"wrap-around-peek", 5};
+
+            test.execute(Write{"abcd"}.with_bytes_written(4));
+            test.execute(Pop{3});
+            test.execute(Write{"efgh"}.with_bytes_written(4));
+
+            test.execute(BytesRead{3});
+            test.execute(BytesWritten{8});
+            test.execute(RemainingCapacity{0});
+            test.execute(BufferSize{5});
+            test.execute(Peek{"defgh"});
+            test.execute(PeekViews{"de", "fgh"});
+
+            test.execute(Pop{1});
+            test.execute(PeekViews{"e", "fgh"});
+            test.execute(Pop{1});
+            test.execute(PeekViews{"fgh", ""});
+            test.execute(Peek{"fgh"});
+        }
+
+        {
+            ByteStreamTestHarness test{"wrap-around-many", 3};
+
+            test.execute(Write{"ab"}.with_bytes_written(2));
+            test.execute(Pop{1});
+            test.execute(Write{"cd"}.with_bytes_written(2));
+            test.execute(Peek{"bcd"});
+            test.execute(Pop{2});
+            test.execute(Write{"efg"}.with_bytes_written(2));
+            test.execute(Peek{"def"});
+            test.execute(PeekViews{"def", ""});
+            test.execute(Pop{1});
+            test.execute(Write{"gh"}.with_bytes_written(1));
+            test.execute(PeekViews{"ef", "g"});
+            test.execute(EndInput{});
+            test.execute(Pop{3});
+
+            test.execute(InputEnded{true});
+            test.execute(BufferEmpty{true});
+            test.execute(Eof{true});
+            test.execute(BytesRead{7});
+            test.execute(BytesWritten{7});
+            test.execute(RemainingCapacity{3});
+        }
+
+        {
+            ByteStreamTestHarness test{"empty-resets-position", 4};
+
+            test.execute(Write{"abc"}.with_bytes_written(3));
+            test.execute(Pop{3});
+            test.execute(Write{"defg"}.with_bytes_written(4));
+            test.execute(PeekViews{"defg", ""});
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
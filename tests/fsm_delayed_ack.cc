@@ -0,0 +1,94 @@
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//! move every segment `from` has queued to `to`, and return them
+static vector<TCPSegment> deliver(TCPConnection &from, TCPConnection &to) {
+    vector<TCPSegment> delivered;
+    while (not from.segments_out().empty()) {
+        to.segment_received(from.segments_out().front());
+        delivered.push_back(from.segments_out().front());
+        from.segments_out().pop();
+    }
+    return delivered;
+}
+
+int main() {
+    try {
+        TCPConfig cfg{};
+        cfg.delayed_ack = true;
+
+        TCPConnection client{cfg};
+        TCPConnection server{cfg};
+        client.connect();
+        deliver(client, server);
+        deliver(server, client);
+        deliver(client, server);
+        test_err_if(server.segments_out().size() != 0, "handshake: the ack of the SYN/ACK must not be acked");
+
+        // test 1: one ack for every two full-sized segments
+        client.write(string(4 * TCPConfig::MAX_PAYLOAD_SIZE, 'x'));
+        test_err_if(deliver(client, server).size() != 4, "test 1 failed: expected four segments");
+        const auto acks = deliver(server, client);
+        test_err_if(acks.size() != 2, "test 1 failed: expected one ack per two segments");
+        test_err_if(client.bytes_in_flight() != 0, "test 1 failed: data not acknowledged");
+
+        // test 2: a single segment is acked when the delayed ack timer expires
+        client.write("abc");
+        deliver(client, server);
+        test_err_if(server.segments_out().size() != 0, "test 2 failed: single segment acked at once");
+        server.tick(cfg.delayed_ack_timeout - 1);
+        test_err_if(server.segments_out().size() != 0, "test 2 failed: ack sent before the timer expired");
+        server.tick(1);
+        test_err_if(deliver(server, client).size() != 1 or client.bytes_in_flight() != 0,
+                    "test 2 failed: no ack after the timer expired");
+
+        // test 3: the delayed ack rides on outgoing data
+        client.write("def");
+        deliver(client, server);
+        server.write("reply");
+        const auto reply = deliver(server, client);
+        test_err_if(reply.size() != 1 or reply[0].payload().size() != 5 or client.bytes_in_flight() != 0,
+                    "test 3 failed: data did not carry the delayed ack");
+        server.tick(cfg.delayed_ack_timeout);
+        test_err_if(server.segments_out().size() != 0, "test 3 failed: delayed ack sent twice");
+        deliver(client, server);
+        client.tick(cfg.delayed_ack_timeout);
+        deliver(client, server);
+
+        // test 4: out-of-order data and the segment that fills the hole are acked at once
+        client.write(string(2 * TCPConfig::MAX_PAYLOAD_SIZE, 'y'));
+        test_err_if(client.segments_out().size() != 2, "test 4 failed: expected two segments");
+        const TCPSegment first = client.segments_out().front();
+        client.segments_out().pop();
+        deliver(client, server);
+        test_err_if(server.segments_out().size() != 1, "test 4 failed: out-of-order segment not acked at once");
+        deliver(server, client);
+        server.segment_received(first);
+        test_err_if(server.segments_out().size() != 1 or client.bytes_in_flight() != 2 * TCPConfig::MAX_PAYLOAD_SIZE,
+                    "test 4 failed: segment that fills a hole not acked at once");
+        deliver(server, client);
+        test_err_if(client.bytes_in_flight() != 0, "test 4 failed: data not acknowledged");
+
+        // test 5: a FIN is acked at once
+        client.end_input_stream();
+        deliver(client, server);
+        test_err_if(server.segments_out().size() != 1 or not server.inbound_stream().input_ended(),
+                    "test 5 failed: FIN not acked at once");
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
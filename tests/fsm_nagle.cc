@@ -0,0 +1,124 @@
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//! move every segment `from` has queued to `to`, and return them
+static vector<TCPSegment> deliver(TCPConnection &from, TCPConnection &to) {
+    vector<TCPSegment> delivered;
+    while (not from.segments_out().empty()) {
+        to.segment_received(from.segments_out().front());
+        delivered.push_back(from.segments_out().front());
+        from.segments_out().pop();
+    }
+    return delivered;
+}
+
+//! open a connection between `client` and `server`
+static void handshake(TCPConnection &client, TCPConnection &server) {
+    client.connect();
+    deliver(client, server);
+    deliver(server, client);
+    deliver(client, server);
+}
+
+int main() {
+    try {
+        TCPConfig cfg{};
+        cfg.nagle = true;
+
+        // test 1: Nagle's algorithm coalesces small writes while data is in flight
+        {
+            TCPConnection client{cfg};
+            TCPConnection server{cfg};
+            handshake(client, server);
+
+            client.write("a");
+            test_err_if(client.segments_out().size() != 1, "test 1 failed: first small write must go out at once");
+            const auto first = deliver(client, server);
+            for (unsigned int i = 0; i < 10; i++) {
+                client.write("b");
+            }
+            test_err_if(client.segments_out().size() != 0, "test 1 failed: small writes not held back");
+            client.tick(1);
+            test_err_if(client.segments_out().size() != 0, "test 1 failed: small writes sent on tick");
+            deliver(server, client);
+            const auto coalesced = deliver(client, server);
+            test_err_if(coalesced.size() != 1 or coalesced[0].payload().size() != 10,
+                        "test 1 failed: the ack did not release one coalesced segment");
+            deliver(server, client);
+
+            // full-sized segments are never held back, only the tail after them
+            client.write("c");
+            deliver(client, server);
+            client.write(string(TCPConfig::MAX_PAYLOAD_SIZE + 5, 'd'));
+            const auto full = deliver(client, server);
+            test_err_if(full.size() != 1 or full[0].payload().size() != TCPConfig::MAX_PAYLOAD_SIZE,
+                        "test 1 failed: full-sized segment held back");
+            deliver(server, client);
+            test_err_if(deliver(client, server).size() != 1 or client.bytes_in_flight() != 5,
+                        "test 1 failed: tail not sent after the ack");
+            deliver(server, client);
+
+            // the last segment of the stream is not held back
+            client.write("e");
+            deliver(client, server);
+            client.write("f");
+            client.end_input_stream();
+            const auto last = deliver(client, server);
+            test_err_if(last.size() != 1 or not last[0].header().fin or last[0].payload().size() != 1,
+                        "test 1 failed: last segment held back");
+        }
+
+        // test 2: set_nodelay(true) turns Nagle's algorithm off and sends what it held back
+        {
+            TCPConnection client{cfg};
+            TCPConnection server{cfg};
+            handshake(client, server);
+
+            client.write("a");
+            client.write("b");
+            test_err_if(client.segments_out().size() != 1, "test 2 failed: second write not held back");
+            client.set_nodelay(true);
+            test_err_if(client.segments_out().size() != 2, "test 2 failed: set_nodelay did not send held data");
+            client.write("c");
+            test_err_if(client.segments_out().size() != 3, "test 2 failed: write held back without Nagle");
+        }
+
+        // test 3: cork() batches writes even when nothing is in flight; uncork() sends them
+        {
+            TCPConnection client{TCPConfig{}};
+            TCPConnection server{TCPConfig{}};
+            handshake(client, server);
+
+            client.cork();
+            for (unsigned int i = 0; i < 3; i++) {
+                client.write("req");
+            }
+            test_err_if(client.segments_out().size() != 0, "test 3 failed: corked writes sent");
+            client.write(string(TCPConfig::MAX_PAYLOAD_SIZE, 'x'));
+            const auto full = deliver(client, server);
+            test_err_if(full.size() != 1 or full[0].payload().size() != TCPConfig::MAX_PAYLOAD_SIZE,
+                        "test 3 failed: full-sized segment not sent while corked");
+            client.uncork();
+            const auto tail = deliver(client, server);
+            test_err_if(tail.size() != 1 or tail[0].payload().size() != 9, "test 3 failed: uncork did not flush");
+            test_err_if(server.inbound_stream().buffer_size() != TCPConfig::MAX_PAYLOAD_SIZE + 9,
+                        "test 3 failed: data not received");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
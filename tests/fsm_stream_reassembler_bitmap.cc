@@ -0,0 +1,96 @@
+#include "buffer.hh"
+#include "byte_stream.hh"
+#include "stream_reassembler.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+static constexpr unsigned NREPS = 32;
+static constexpr unsigned NSEGS = 256;
+static constexpr unsigned MAX_SEG_LEN = 300;
+
+// Feed the same overlapping, shuffled substrings to both engines and require identical behavior;
+// a third reassembler gets them as slices of one shared Buffer, like TCPReceiver does with payloads
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        for (unsigned rep_no = 0; rep_no < NREPS; ++rep_no) {
+            const size_t capacity = 1 + rd() % 4000;
+            StreamReassembler map_buf{capacity, StreamReassembler::Engine::IntervalMap};
+            StreamReassembler bitmap_buf{capacity, StreamReassembler::Engine::Bitmap};
+            StreamReassembler shared_buf{capacity};
+
+            const size_t total = 8 * capacity;
+            string d(total, 0);
+            generate(d.begin(), d.end(), [&] { return rd(); });
+            const Buffer shared{string(d)};
+
+            vector<tuple<size_t, size_t>> seq_size;
+            for (unsigned i = 0; i < NSEGS; ++i) {
+                const size_t off = rd() % total;
+                const size_t size = min<size_t>(total - off, rd() % MAX_SEG_LEN);
+                seq_size.emplace_back(off, size);
+            }
+            for (size_t off = 0; off < total; off += MAX_SEG_LEN) {
+                seq_size.emplace_back(off, min<size_t>(total - off, MAX_SEG_LEN));
+            }
+            shuffle(seq_size.begin(), seq_size.end(), rd);
+
+            string map_out, bitmap_out, shared_out;
+            for (auto [off, sz] : seq_size) {
+                const string dd = d.substr(off, sz);
+                const bool eof = off + sz == total;
+                map_buf.push_substring(dd, off, eof);
+                bitmap_buf.push_substring(dd, off, eof);
+                Buffer slice = shared;
+                slice.remove_suffix(total - off - sz);
+                slice.remove_prefix(off);
+                shared_buf.push_substring(slice, off, eof);
+
+                if (map_buf.unassembled_bytes() != bitmap_buf.unassembled_bytes()) {
+                    throw runtime_error("unassembled_bytes differ: " + to_string(map_buf.unassembled_bytes()) +
+                                        " vs " + to_string(bitmap_buf.unassembled_bytes()));
+                }
+                if (map_buf.unassembled_bytes() != shared_buf.unassembled_bytes()) {
+                    throw runtime_error("unassembled_bytes differ for Buffer input");
+                }
+                if (map_buf.empty() != bitmap_buf.empty()) {
+                    throw runtime_error("empty() differs");
+                }
+
+                // the reader drains a random amount so the window slides and wraps
+                const size_t to_read = rd() % (map_buf.stream_out().buffer_size() + 1);
+                map_out.append(map_buf.stream_out().read(to_read));
+                bitmap_out.append(bitmap_buf.stream_out().read(to_read));
+                shared_out.append(shared_buf.stream_out().read(to_read));
+                if (map_out != bitmap_out or map_out != shared_out) {
+                    throw runtime_error("reassembled bytes differ");
+                }
+            }
+
+            if (map_buf.stream_out().input_ended() != bitmap_buf.stream_out().input_ended() or
+                map_buf.stream_out().input_ended() != shared_buf.stream_out().input_ended()) {
+                throw runtime_error("input_ended() differs");
+            }
+            if (not equal(bitmap_out.cbegin(), bitmap_out.cend(), d.cbegin())) {
+                throw runtime_error("content of RX bytes is incorrect");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,144 @@
+#include "buffer.hh"
+#include "buffer_pool.hh"
+#include "byte_stream.hh"
+#include "stream_reassembler.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+static void check(const bool condition, const string &what) {
+    if (not condition) {
+        throw runtime_error(what);
+    }
+}
+
+static void check_counters(const StreamReassembler &buf,
+                           const size_t unassembled,
+                           const size_t evicted_fragments,
+                           const size_t evicted_bytes) {
+    check(buf.unassembled_bytes() == unassembled,
+          "unassembled_bytes: expected " + to_string(unassembled) + ", got " + to_string(buf.unassembled_bytes()));
+    check(buf.evicted_fragments() == evicted_fragments,
+          "evicted_fragments: expected " + to_string(evicted_fragments) + ", got " +
+              to_string(buf.evicted_fragments()));
+    check(buf.evicted_bytes() == evicted_bytes,
+          "evicted_bytes: expected " + to_string(evicted_bytes) + ", got " + to_string(buf.evicted_bytes()));
+}
+
+int main() {
+    try {
+        // room for exactly two 10-byte substrings
+        const size_t budget = 2 * (10 + StreamReassembler::FRAGMENT_OVERHEAD);
+
+        {
+            StreamReassembler buf{1000};
+            buf.set_memory_budget(budget, StreamReassembler::EvictionPolicy::FurthestFirst);
+            buf.push_substring(string(10, 'b'), 100, false);
+            buf.push_substring(string(10, 'c'), 200, false);
+            check_counters(buf, 20, 0, 0);
+            check(buf.buffered_memory() == budget, "buffered_memory should match the budget");
+
+            // the new substring is the furthest one, so it is the one dropped
+            buf.push_substring(string(10, 'd'), 300, false);
+            check_counters(buf, 20, 1, 10);
+
+            // a nearer substring pushes out the furthest stored one
+            buf.push_substring(string(10, 'a'), 50, false);
+            check_counters(buf, 20, 2, 20);
+
+            // filling the hole drains everything up to the next gap
+            buf.push_substring(string(50, 'x'), 0, false);
+            check(buf.stream_out().buffer_size() == 60, "expected 60 assembled bytes");
+            check_counters(buf, 10, 2, 20);
+            buf.push_substring(string(40, 'y'), 60, false);
+            check(buf.stream_out().read(110) == string(50, 'x') + string(10, 'a') + string(40, 'y') + string(10, 'b'),
+                  "wrong reassembled bytes");
+            check(buf.empty(), "reassembler should be empty");
+            check(buf.buffered_memory() == 0, "buffered_memory should return to 0");
+        }
+
+        {
+            StreamReassembler buf{1000};
+            buf.set_memory_budget(budget, StreamReassembler::EvictionPolicy::RejectNew);
+            buf.push_substring(string(10, 'b'), 100, false);
+            buf.push_substring(string(10, 'c'), 200, false);
+            buf.push_substring(string(10, 'd'), 300, false);
+            buf.push_substring(string(10, 'a'), 50, false);
+            check_counters(buf, 20, 2, 20);
+
+            // one substring that covers both stored ones frees their overhead and fits
+            buf.push_substring(string(111, 'z'), 99, false);
+            check_counters(buf, 111, 2, 20);
+        }
+
+        {
+            // many tiny fragments: memory stays bounded and the stream is still reassembled correctly
+            auto rd = get_random_generator();
+            const size_t capacity = 64000;
+            const size_t small_budget = 4096;
+            string d(capacity, 0);
+            for (auto &c : d) {
+                c = static_cast<char>(rd());
+            }
+
+            StreamReassembler buf{capacity};
+            buf.set_memory_budget(small_budget);
+            for (size_t i = 1; i < capacity; i += 2) {
+                buf.push_substring(d.substr(i, 1), i, false);
+                check(buf.buffered_memory() <= small_budget, "buffered_memory exceeded the budget");
+            }
+            check(buf.evicted_fragments() > 0, "expected evictions");
+            check(buf.evicted_bytes() == buf.evicted_fragments(), "each evicted fragment was one byte");
+
+            buf.push_substring(d, 0, true);
+            check(buf.stream_out().input_ended(), "stream should be complete");
+            check(buf.stream_out().read(capacity) == d, "wrong reassembled bytes");
+        }
+
+        {
+            // 1-byte slices cut from large payloads: the stored fragments must not keep the payloads alive,
+            // or memory would grow far past what the budget charges for
+            BufferPool pool;
+            const size_t capacity = 64000;
+            const size_t small_budget = 4096;
+
+            StreamReassembler buf{capacity};
+            buf.set_memory_budget(small_budget);
+            for (size_t i = 1; i < capacity; i += 2) {
+                Buffer payload = Buffer::copy_of(string(3000, static_cast<char>(i)), pool);
+                payload.remove_prefix(1000);
+                payload.remove_suffix(payload.size() - 1);
+                buf.push_substring(payload, i, false);
+                check(buf.buffered_memory() <= small_budget, "buffered_memory exceeded the budget");
+            }
+            check(buf.evicted_fragments() > 0, "expected evictions");
+            check(pool.allocations() == 1, "stored fragments pinned their payloads' slabs");
+
+            // the fragments furthest out were evicted, so the ones kept are the odd bytes at the front; filling
+            // only the holes between them must bring every kept byte out unchanged
+            const size_t kept = buf.unassembled_bytes();
+            check(kept > 0, "expected some fragments to be kept");
+            for (size_t i = 0; i < capacity; i += 2) {
+                buf.push_substring(string(1, '.'), i, false);
+            }
+            const string out = buf.stream_out().read(capacity);
+            check(out.size() == 2 * kept + 1, "expected " + to_string(2 * kept + 1) + " reassembled bytes, got " +
+                                                  to_string(out.size()));
+            for (size_t i = 0; i < out.size(); i++) {
+                check(out[i] == (i % 2 ? static_cast<char>(i) : '.'), "wrong reassembled byte " + to_string(i));
+            }
+        }
+    } catch (const exception &e) {
+        cerr << "Exception: " << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,167 @@
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_header.hh"
+#include "tcp_receiver.hh"
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//! move every segment `from` has queued to `to`, through serialize() and parse(), and return them
+static vector<TCPSegment> deliver(TCPConnection &from, TCPConnection &to) {
+    vector<TCPSegment> delivered;
+    while (not from.segments_out().empty()) {
+        TCPSegment seg;
+        test_err_if(seg.parse(Buffer(from.segments_out().front().serialize().concatenate())) != ParseResult::NoError,
+                    "segment did not survive serialize/parse");
+        from.segments_out().pop();
+        to.segment_received(seg);
+        delivered.push_back(seg);
+    }
+    return delivered;
+}
+
+static TCPSegment make_segment(const WrappingInt32 seqno, const string &data, const uint32_t tsval, const bool syn = false) {
+    TCPSegment seg;
+    seg.header().seqno = seqno;
+    seg.header().syn = syn;
+    seg.header().timestamps = TCPHeader::Timestamps{tsval, 0};
+    seg.payload() = string(data);
+    return seg;
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // test 1: the timestamps option survives serialize() and parse(), next to three SACK blocks
+        {
+            TCPHeader header;
+            header.ack = true;
+            header.timestamps = TCPHeader::Timestamps{static_cast<uint32_t>(rd()), static_cast<uint32_t>(rd())};
+            for (uint32_t i = 0; i < TCPHeader::MAX_SACK_BLOCKS - 1; i++) {
+                header.sack_blocks.emplace_back(WrappingInt32{1000 * i + 10}, WrappingInt32{1000 * i + 20});
+            }
+            NetParser p{header.serialize()};
+            TCPHeader parsed;
+            test_err_if(parsed.parse(p) != ParseResult::NoError, "test 1 failed: could not parse the timestamps");
+            header.doff = parsed.doff;
+            test_err_if(not(parsed == header), "test 1 failed: timestamps changed in a serialize/parse round trip");
+
+            header.sack_blocks.emplace_back(WrappingInt32{5000}, WrappingInt32{6000});
+            bool threw = false;
+            try {
+                header.serialize();
+            } catch (const runtime_error &) {
+                threw = true;
+            }
+            test_err_if(not threw, "test 1 failed: options longer than 40 bytes were serialized");
+        }
+
+        // test 2: PAWS drops segments with an old timestamp; TS.Recent follows the left window edge
+        {
+            const WrappingInt32 isn(rd());
+            TCPReceiver receiver{1000};
+            receiver.segment_received(make_segment(isn, "", 100, true));
+            test_err_if(receiver.ts_recent() != 100u, "test 2 failed: TS.Recent not taken from the SYN");
+            receiver.segment_received(make_segment(isn + 1, "abc", 105));
+            test_err_if(receiver.ts_recent() != 105u, "test 2 failed: TS.Recent not updated");
+            receiver.segment_received(make_segment(isn + 4, "def", 90));
+            test_err_if(receiver.paws_rejected() != 1 or receiver.ackno() != WrappingInt32{isn + 4},
+                        "test 2 failed: segment with an old timestamp was accepted");
+            receiver.segment_received(make_segment(isn + 10, "xyz", 200));
+            test_err_if(receiver.ts_recent() != 105u or receiver.unassembled_bytes() != 3,
+                        "test 2 failed: out-of-order segment must be kept without updating TS.Recent");
+            receiver.segment_received(make_segment(isn + 4, "def", 110));
+            test_err_if(receiver.ts_recent() != 110u or receiver.ackno() != WrappingInt32{isn + 7},
+                        "test 2 failed: in-order segment not accepted");
+        }
+
+        // test 3: the RTT is measured even when the acknowledged segment was retransmitted
+        for (const bool timestamps : {true, false}) {
+            TCPConfig cfg{};
+            cfg.timestamps = timestamps;
+            TCPConnection client{cfg};
+            TCPConnection server{cfg};
+
+            client.connect();
+            deliver(client, server);
+            client.tick(20);
+            deliver(server, client);
+            deliver(client, server);
+            test_err_if(client.timestamps_agreed() != timestamps or server.timestamps_agreed() != timestamps,
+                        "test 3 failed: timestamps not negotiated");
+            test_err_if(client.sender().smoothed_rtt() != 20.0, "test 3 failed: RTT of the handshake not measured");
+
+            client.write("hello");
+            client.segments_out().pop();  // lost
+            client.tick(cfg.rt_timeout);
+            client.tick(20);
+            test_err_if(deliver(client, server).size() != 1, "test 3 failed: segment not retransmitted");
+            deliver(server, client);
+            test_err_if(client.bytes_in_flight() != 0, "test 3 failed: retransmission not acknowledged");
+            // RTTVAR is 10 after the first sample; a second sample equal to SRTT brings it down to 7.5
+            const double expected_rttvar = timestamps ? 7.5 : 10.0;
+            test_err_if(client.sender().smoothed_rtt() != 20.0 or client.sender().rtt_variation() != expected_rttvar,
+                        "test 3 failed: wrong RTT estimate after the retransmission was acknowledged");
+        }
+
+        // test 4: a segment dropped by PAWS is only answered with an ack; its ack, window, SACK blocks and TSecr
+        // never reach the sender
+        {
+            TCPConfig cfg{};
+            cfg.timestamps = true;
+            cfg.sack = true;
+            TCPConnection client{cfg};
+            TCPConnection server{cfg};
+
+            client.connect();
+            deliver(client, server);
+            client.tick(20);
+            deliver(server, client);
+            deliver(client, server);
+
+            client.write(string(3000, 'x'));
+            deliver(client, server);
+            test_err_if(server.segments_out().empty(), "test 4 failed: data not acknowledged");
+            const TCPSegment ack = server.segments_out().back();
+            while (not server.segments_out().empty()) {
+                server.segments_out().pop();
+            }
+
+            // the same ack with a timestamp older than TS.Recent, a closed window, a SACK block and a TSecr
+            // that would give a huge RTT sample
+            TCPSegment stale = ack;
+            stale.header().timestamps.value().val -= 1000;
+            stale.header().timestamps.value().ecr -= 5000;
+            stale.header().win = 0;
+            stale.header().sack_blocks.emplace_back(ack.header().ackno + 1000, ack.header().ackno + 2000);
+            client.tick(20);
+            client.segment_received(stale);
+            test_err_if(client.receiver().paws_rejected() != 1, "test 4 failed: stale segment not dropped by PAWS");
+            test_err_if(client.bytes_in_flight() != 3000, "test 4 failed: ack of a stale segment was used");
+            test_err_if(client.sender().smoothed_rtt() != 20.0, "test 4 failed: TSecr of a stale segment was used");
+            test_err_if(client.segments_out().size() != 1 or
+                            client.segments_out().front().length_in_sequence_space() != 0,
+                        "test 4 failed: stale segment not answered with an ack");
+            client.segments_out().pop();
+
+            client.segment_received(ack);
+            test_err_if(client.bytes_in_flight() != 0, "test 4 failed: ack not accepted after a stale segment");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
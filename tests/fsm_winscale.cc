@@ -0,0 +1,105 @@
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static constexpr size_t BIG_CAPACITY = 1000000;
+
+//! move every segment `from` has queued to `to`, through serialize() and parse(), and return them
+static vector<TCPSegment> deliver(TCPConnection &from, TCPConnection &to) {
+    vector<TCPSegment> delivered;
+    while (not from.segments_out().empty()) {
+        TCPSegment seg;
+        test_err_if(seg.parse(Buffer(from.segments_out().front().serialize().concatenate())) != ParseResult::NoError,
+                    "segment did not survive serialize/parse");
+        from.segments_out().pop();
+        to.segment_received(seg);
+        delivered.push_back(seg);
+    }
+    return delivered;
+}
+
+int main() {
+    try {
+        TCPConfig cfg{};
+        cfg.recv_capacity = BIG_CAPACITY;
+        cfg.send_capacity = BIG_CAPACITY;
+
+        // test 1: both sides offer window scaling, so more than 64 KiB can be in flight
+        {
+            TCPConfig scaled = cfg;
+            scaled.window_scaling = true;
+            TCPConnection client{scaled};
+            TCPConnection server{scaled};
+
+            client.connect();
+            const auto syn = deliver(client, server);
+            test_err_if(syn.size() != 1 or not syn[0].header().window_scale.has_value() or
+                            syn[0].header().window_scale.value() != 4,
+                        "test 1 failed: SYN does not offer a shift of 4 for a 1 MB window");
+            test_err_if(syn[0].header().win != numeric_limits<uint16_t>::max(),
+                        "test 1 failed: window of the SYN must not be scaled");
+            const auto syn_ack = deliver(server, client);
+            test_err_if(syn_ack.size() != 1 or syn_ack[0].header().window_scale != syn[0].header().window_scale,
+                        "test 1 failed: SYN/ACK does not answer the window scale option");
+            deliver(client, server);
+            test_err_if(not client.window_scaling_agreed() or not server.window_scaling_agreed(),
+                        "test 1 failed: window scaling not agreed");
+
+            // the SYN/ACK's window is never scaled, so the first flight is 64 KiB; the acks open the window
+            client.write(string(300000, 'x'));
+            test_err_if(client.bytes_in_flight() != numeric_limits<uint16_t>::max(),
+                        "test 1 failed: first flight not limited by the SYN/ACK's window");
+            deliver(client, server);
+            const auto acks = deliver(server, client);
+            test_err_if(acks.empty() or
+                            acks.back().header().win != (BIG_CAPACITY - numeric_limits<uint16_t>::max()) >> 4,
+                        "test 1 failed: advertised window not scaled down");
+            client.tick(1);
+            test_err_if(client.bytes_in_flight() != 300000 - numeric_limits<uint16_t>::max(),
+                        "test 1 failed: sender did not use the scaled window");
+            deliver(client, server);
+            deliver(server, client);
+            client.tick(1);
+            test_err_if(server.inbound_stream().buffer_size() != 300000, "test 1 failed: data not received");
+            test_err_if(client.bytes_in_flight() != 0, "test 1 failed: data not acknowledged");
+        }
+
+        // test 2: only one side offers it, so windows stay below 64 KiB
+        {
+            TCPConfig scaled = cfg;
+            scaled.window_scaling = true;
+            TCPConnection client{scaled};
+            TCPConnection server{cfg};
+
+            client.connect();
+            deliver(client, server);
+            const auto syn_ack = deliver(server, client);
+            test_err_if(syn_ack.size() != 1 or syn_ack[0].header().window_scale.has_value(),
+                        "test 2 failed: SYN/ACK carries a window scale option that was not offered");
+            deliver(client, server);
+            test_err_if(client.window_scaling_agreed() or server.window_scaling_agreed(),
+                        "test 2 failed: window scaling agreed by only one side");
+
+            client.write(string(300000, 'x'));
+            test_err_if(client.bytes_in_flight() != numeric_limits<uint16_t>::max(),
+                        "test 2 failed: sender exceeded the unscaled window");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
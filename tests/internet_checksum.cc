@@ -0,0 +1,130 @@
+#include "ipv4_header.hh"
+#include "tcp_header.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+//! the checksum computed one big-endian 16-bit word at a time, as RFC 1071 describes it
+static uint16_t reference_checksum(const string_view data, const uint32_t initial_sum = 0) {
+    uint64_t sum = initial_sum;
+    for (size_t i = 0; i < data.size(); i++) {
+        sum += i % 2 ? uint8_t(data[i]) : uint8_t(data[i]) << 8;
+    }
+    while (sum > 0xffff) {
+        sum = (sum >> 16) + (sum & 0xffff);
+    }
+    return ~sum;
+}
+
+//! are `a` and `b` the same one's-complement number? (0x0000 and 0xffff are both zero)
+static bool same_checksum(const uint16_t a, const uint16_t b) {
+    return a == b or (a == 0 and b == 0xffff) or (a == 0xffff and b == 0);
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        string data(70000, 0);
+        for (auto &c : data) {
+            c = static_cast<char>(rd());
+        }
+
+        // test 1: every kernel agrees with the reference, for any length, alignment and split into add() calls
+        for (const auto kernel :
+             {InternetChecksum::Kernel::Scalar, InternetChecksum::Kernel::SSE2, InternetChecksum::Kernel::AVX2}) {
+            if (not InternetChecksum::kernel_supported(kernel)) {
+                continue;
+            }
+            InternetChecksum::use_kernel(kernel);
+            const string name = InternetChecksum::kernel_name(kernel);
+
+            for (unsigned i = 0; i < 2000; i++) {
+                const size_t offset = rd() % 64;
+                const size_t len = i < 200 ? i : rd() % (data.size() - offset);
+                const string_view view{data.data() + offset, len};
+                const uint32_t initial_sum = rd() % 0x20000;
+
+                InternetChecksum whole{initial_sum};
+                whole.add(view);
+                test_err_if(whole.value() != reference_checksum(view, initial_sum),
+                            "test 1 failed: " + name + " kernel, " + to_string(len) + " bytes");
+
+                const size_t split = len ? rd() % len : 0;
+                InternetChecksum pieces{initial_sum};
+                pieces.add(view.substr(0, split));
+                pieces.add(view.substr(split));
+                test_err_if(pieces.value() != whole.value(),
+                            "test 1 failed: " + name + " kernel, split at byte " + to_string(split));
+            }
+        }
+
+        // test 2: an all-zero buffer and a buffer that sums to 0xffff
+        {
+            InternetChecksum zeros;
+            zeros.add(string(100, 0));
+            test_err_if(zeros.value() != 0xffff, "test 2 failed: checksum of zeros");
+            InternetChecksum ones;
+            ones.add(string(100, '\xff'));
+            test_err_if(ones.value() != 0, "test 2 failed: checksum of 0xff bytes");
+        }
+
+        // test 3: incremental updates (RFC 1624) match recomputing the header checksum
+        for (unsigned i = 0; i < 1000; i++) {
+            IPv4Header ip;
+            ip.ttl = 1 + rd() % 255;
+            ip.proto = rd();
+            ip.src = rd();
+            ip.dst = rd();
+            ip.len = 20 + rd() % 1000;
+            ip.cksum = 0;
+            InternetChecksum check;
+            check.add(ip.serialize());
+            ip.cksum = check.value();
+
+            const uint16_t old_word = static_cast<uint16_t>((ip.ttl << 8) | ip.proto);
+            ip.ttl--;
+            const uint16_t updated =
+                InternetChecksum::update(ip.cksum, old_word, static_cast<uint16_t>((ip.ttl << 8) | ip.proto));
+            ip.cksum = 0;
+            InternetChecksum recheck;
+            recheck.add(ip.serialize());
+            test_err_if(not same_checksum(updated, recheck.value()), "test 3 failed: TTL update");
+
+            TCPHeader tcp;
+            tcp.seqno = WrappingInt32(rd());
+            tcp.ackno = WrappingInt32(rd());
+            tcp.ack = true;
+            tcp.win = rd();
+            const string payload = data.substr(rd() % 1000, rd() % 1000);
+            InternetChecksum tcp_check{ip.pseudo_cksum()};
+            tcp_check.add(tcp.serialize());
+            tcp_check.add(payload);
+            const uint16_t before = tcp_check.value();
+
+            const WrappingInt32 new_ackno(rd());
+            const uint16_t new_win = rd();
+            uint16_t incremental = InternetChecksum::update32(before, tcp.ackno.raw_value(), new_ackno.raw_value());
+            incremental = InternetChecksum::update(incremental, tcp.win, new_win);
+            tcp.ackno = new_ackno;
+            tcp.win = new_win;
+            InternetChecksum tcp_recheck{ip.pseudo_cksum()};
+            tcp_recheck.add(tcp.serialize());
+            tcp_recheck.add(payload);
+            test_err_if(not same_checksum(incremental, tcp_recheck.value()), "test 3 failed: ackno/window update");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,145 @@
+#include "arp_message.hh"
+#include "ethernet_frame.hh"
+#include "ipv4_datagram.hh"
+#include "parser.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // test 1: integers are read big-endian from any alignment, and running off the end is an error
+        {
+            const string bytes{"\x01\x02\x03\x04\x05\x06\x07\x08\x09", 9};
+            NetParser p{string(bytes)};
+            test_err_if(p.u8() != 0x01 or p.u32() != 0x02030405 or p.u16() != 0x0607, "test 1 failed: wrong value");
+            test_err_if(p.unparsed() != bytes.substr(7), "test 1 failed: wrong bytes left");
+            test_err_if(p.u32() != 0 or p.get_error() != ParseResult::PacketTooShort,
+                        "test 1 failed: read past the end");
+
+            NetParser q{string(bytes)};
+            const auto h = q.header<8>();
+            test_err_if(not h or h->u16<1>() != 0x0203 or h->u32<3>() != 0x04050607 or h->u8<7>() != 0x08,
+                        "test 1 failed: wrong header field");
+            test_err_if(q.unparsed() != bytes.substr(8), "test 1 failed: header not consumed");
+            test_err_if(q.header<2>() or q.get_error() != ParseResult::PacketTooShort,
+                        "test 1 failed: header longer than what is left");
+        }
+
+        // test 2: what is left after parsing is a slice of the original Buffer, not a copy
+        {
+            const Buffer original{string(100, 'x')};
+            NetParser p{original};
+            p.remove_prefix(40);
+            const Buffer rest = p.buffer();
+            test_err_if(rest.size() != 60 or rest.str().data() != original.str().data() + 40,
+                        "test 2 failed: payload was copied");
+        }
+
+        // test 3: TCP and IPv4 headers survive a round trip, and the errors are reported as before
+        for (unsigned i = 0; i < 100; i++) {
+            TCPHeader tcp;
+            tcp.sport = rd();
+            tcp.dport = rd();
+            tcp.seqno = WrappingInt32(rd());
+            tcp.ackno = WrappingInt32(rd());
+            tcp.ack = true;
+            tcp.psh = rd() % 2;
+            tcp.win = rd();
+            tcp.uptr = rd();
+            tcp.timestamps = TCPHeader::Timestamps{static_cast<uint32_t>(rd()), static_cast<uint32_t>(rd())};
+            tcp.doff = 8;
+            const string wire = tcp.serialize();
+
+            TCPHeader parsed;
+            NetParser p{string(wire)};
+            test_err_if(parsed.parse(p) != ParseResult::NoError or not(parsed == tcp),
+                        "test 3 failed: TCP header changed in a round trip");
+            test_err_if(not p.unparsed().empty(), "test 3 failed: TCP options not consumed");
+
+            NetParser short_p{wire.substr(0, rd() % TCPHeader::LENGTH)};
+            test_err_if(parsed.parse(short_p) != ParseResult::PacketTooShort, "test 3 failed: short TCP header");
+            NetParser truncated_p{wire.substr(0, TCPHeader::LENGTH)};
+            test_err_if(parsed.parse(truncated_p) != ParseResult::PacketTooShort,
+                        "test 3 failed: TCP header shorter than doff");
+            string bad_doff = wire;
+            bad_doff[12] = 0x40;
+            NetParser bad_doff_p{move(bad_doff)};
+            test_err_if(parsed.parse(bad_doff_p) != ParseResult::HeaderTooShort, "test 3 failed: doff of 4");
+
+            InternetDatagram dgram;
+            dgram.header().src = rd();
+            dgram.header().dst = rd();
+            dgram.header().ttl = 1 + rd() % 255;
+            dgram.header().id = rd();
+            dgram.payload() = string(rd() % 100, 'p');
+            dgram.header().len = dgram.header().hlen * 4 + dgram.payload().size();
+            const string ip_wire = dgram.serialize().concatenate();
+
+            InternetDatagram ip_parsed;
+            test_err_if(ip_parsed.parse(string(ip_wire)) != ParseResult::NoError or
+                            ip_parsed.header().src != dgram.header().src or
+                            ip_parsed.header().ttl != dgram.header().ttl or
+                            ip_parsed.payload().concatenate() != dgram.payload().concatenate(),
+                        "test 3 failed: IPv4 datagram changed in a round trip");
+            test_err_if(ip_parsed.parse(ip_wire.substr(0, rd() % IPv4Header::LENGTH)) != ParseResult::PacketTooShort,
+                        "test 3 failed: short IPv4 header");
+            string bad_cksum = ip_wire;
+            bad_cksum[10] ^= 0x01;
+            NetParser bad_cksum_p{move(bad_cksum)};
+            test_err_if(ip_parsed.header().parse(bad_cksum_p) != ParseResult::BadChecksum,
+                        "test 3 failed: bad IPv4 checksum");
+        }
+
+        // test 4: Ethernet and ARP headers are read field by field at fixed offsets
+        {
+            ARPMessage arp;
+            arp.opcode = ARPMessage::OPCODE_REQUEST;
+            arp.sender_ethernet_address = {2, 0, 0, 0, 0, 1};
+            arp.sender_ip_address = 0x0a000001;
+            arp.target_ip_address = 0x0a000002;
+
+            EthernetFrame frame;
+            frame.header().dst = ETHERNET_BROADCAST;
+            frame.header().src = arp.sender_ethernet_address;
+            frame.header().type = EthernetHeader::TYPE_ARP;
+            frame.payload() = arp.serialize();
+            const string wire = frame.serialize().concatenate();
+
+            EthernetFrame parsed_frame;
+            test_err_if(parsed_frame.parse(string(wire)) != ParseResult::NoError or
+                            parsed_frame.header().dst != ETHERNET_BROADCAST or
+                            parsed_frame.header().src != arp.sender_ethernet_address or
+                            parsed_frame.header().type != EthernetHeader::TYPE_ARP,
+                        "test 4 failed: Ethernet header changed in a round trip");
+            ARPMessage parsed_arp;
+            test_err_if(parsed_arp.parse(parsed_frame.payload().concatenate()) != ParseResult::NoError or
+                            parsed_arp.sender_ethernet_address != arp.sender_ethernet_address or
+                            parsed_arp.sender_ip_address != arp.sender_ip_address or
+                            parsed_arp.target_ip_address != arp.target_ip_address,
+                        "test 4 failed: ARP message changed in a round trip");
+
+            test_err_if(parsed_frame.parse(wire.substr(0, EthernetHeader::LENGTH - 1)) != ParseResult::PacketTooShort,
+                        "test 4 failed: short Ethernet header");
+            test_err_if(parsed_arp.parse(arp.serialize().substr(0, ARPMessage::LENGTH - 1)) !=
+                            ParseResult::PacketTooShort,
+                        "test 4 failed: short ARP message");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,121 @@
+#include "ethernet_frame.hh"
+#include "ipv4_datagram.hh"
+#include "packet_builder.hh"
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+//! the packet as one string
+static string flatten(const PacketBuilder &packet) { return string(packet.headers()) + string(packet.payload()); }
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        for (unsigned i = 0; i < 200; i++) {
+            TCPSegment seg;
+            seg.header().sport = rd();
+            seg.header().dport = rd();
+            seg.header().seqno = WrappingInt32(rd());
+            seg.header().ackno = WrappingInt32(rd());
+            seg.header().ack = true;
+            seg.header().win = rd();
+            if (rd() % 2) {
+                seg.header().timestamps =
+                    TCPHeader::Timestamps{static_cast<uint32_t>(rd()), static_cast<uint32_t>(rd())};
+            }
+            for (unsigned j = rd() % 4; j > 0; j--) {
+                seg.header().sack_blocks.emplace_back(WrappingInt32(rd()), WrappingInt32(rd()));
+            }
+            seg.header().doff = seg.header().length() / 4;  // as it will be parsed back
+            string payload(rd() % 1500, 0);
+            for (auto &c : payload) {
+                c = static_cast<char>(rd());
+            }
+            seg.payload() = string(payload);
+
+            // test 1: serialize_into() writes what serialize() returns, and refuses a buffer that is too small
+            {
+                array<char, TCPHeader::MAX_LENGTH> out{};
+                const size_t len = seg.header().serialize_into(out.data(), out.size());
+                test_err_if(string(out.data(), len) != seg.header().serialize(), "test 1 failed: TCP header differs");
+                bool threw = false;
+                try {
+                    seg.header().serialize_into(out.data(), len - 1);
+                } catch (const runtime_error &) {
+                    threw = true;
+                }
+                test_err_if(not threw, "test 1 failed: TCP header written past the end of the buffer");
+            }
+
+            // test 2: a bare segment is laid out exactly as TCPSegment::serialize() does it
+            {
+                PacketBuilder packet;
+                packet.tcp(seg.header(), seg.payload());
+                test_err_if(packet.payload().data() != seg.payload().str().data(), "test 2 failed: payload copied");
+                test_err_if(flatten(packet) != seg.serialize().concatenate(), "test 2 failed: wrong bytes");
+            }
+
+            IPv4Header ip;
+            ip.src = rd();
+            ip.dst = rd();
+            ip.id = rd();
+            ip.ttl = 1 + rd() % 255;
+
+            // test 3: a segment in a datagram matches IPv4Datagram::serialize(), checksums included
+            {
+                InternetDatagram dgram;
+                dgram.header() = ip;
+                dgram.header().len = ip.hlen * 4 + seg.header().length() + payload.size();
+                dgram.payload() = seg.serialize(dgram.header().pseudo_cksum());
+
+                PacketBuilder packet;
+                packet.tcp_in_ipv4(ip, seg.header(), seg.payload());
+                test_err_if(flatten(packet) != dgram.serialize().concatenate(), "test 3 failed: wrong bytes");
+            }
+
+            // test 4: with an Ethernet header in front, the frame parses back layer by layer
+            {
+                EthernetHeader eth;
+                eth.dst = {2, 0, 0, 0, 0, 2};
+                eth.src = {2, 0, 0, 0, 0, 1};
+                eth.type = EthernetHeader::TYPE_IPv4;
+
+                PacketBuilder packet;
+                packet.tcp_in_ipv4_in_ethernet(eth, ip, seg.header(), seg.payload());
+                test_err_if(packet.headers().size() !=
+                                EthernetHeader::LENGTH + IPv4Header::LENGTH + seg.header().length(),
+                            "test 4 failed: headers are not contiguous");
+
+                EthernetFrame frame;
+                test_err_if(frame.parse(flatten(packet)) != ParseResult::NoError or frame.header().dst != eth.dst,
+                            "test 4 failed: frame does not parse");
+                InternetDatagram dgram;
+                test_err_if(dgram.parse(frame.payload().concatenate()) != ParseResult::NoError or
+                                dgram.header().proto != IPv4Header::PROTO_TCP or dgram.header().src != ip.src,
+                            "test 4 failed: datagram does not parse");
+                TCPSegment parsed;
+                test_err_if(parsed.parse(dgram.payload().concatenate(), dgram.header().pseudo_cksum()) !=
+                                ParseResult::NoError,
+                            "test 4 failed: segment does not parse");
+                test_err_if(not(parsed.header() == seg.header()) or parsed.payload().str() != payload,
+                            "test 4 failed: segment changed");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
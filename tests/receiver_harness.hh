@@ -13,6 +13,7 @@
 #include <optional>
 #include <sstream>
 #include <string>
+#include <vector>
 
 struct ReceiverTestStep {
     virtual std::string to_string() const { return "ReceiverTestStep"; }
@@ -68,6 +69,28 @@ struct ExpectAckno : public ReceiverExpectation {
     }
 };
 
+struct ExpectSackBlocks : public ReceiverExpectation {
+    std::vector<TCPHeader::SACKBlock> _blocks;
+
+    ExpectSackBlocks(std::vector<TCPHeader::SACKBlock> blocks) : _blocks(std::move(blocks)) {}
+    static std::string blocks_string(const std::vector<TCPHeader::SACKBlock> &blocks) {
+        std::ostringstream ss;
+        for (const auto &[left, right] : blocks) {
+            ss << "[" << left.raw_value() << ", " << right.raw_value() << ")";
+        }
+        return blocks.empty() ? "none" : ss.str();
+    }
+    std::string description() const { return "SACK blocks " + blocks_string(_blocks); }
+
+    void execute(TCPReceiver &receiver) const {
+        if (receiver.sack_blocks() != _blocks) {
+            throw ReceiverExpectationViolation("The TCPReceiver reported SACK blocks `" +
+                                               blocks_string(receiver.sack_blocks()) + "`, but they were expected to be `" +
+                                               blocks_string(_blocks) + "`");
+        }
+    }
+};
+
 struct ExpectWindow : public ReceiverExpectation {
     size_t _window;
 
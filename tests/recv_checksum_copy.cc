@@ -0,0 +1,155 @@
+#include "byte_stream.hh"
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+//! serialize `seg` and parse it back with a deferred checksum, optionally flipping one payload byte on the way
+static TCPSegment reparse_deferred(const TCPSegment &seg, const bool corrupt = false) {
+    string wire = seg.serialize().concatenate();
+    if (corrupt) {
+        wire.back() ^= 0x20;
+    }
+    TCPSegment ret;
+    test_err_if(ret.parse(move(wire), 0, true) != ParseResult::NoError, "could not parse with a deferred checksum");
+    return ret;
+}
+
+//! move every segment `from` has queued to `to` with deferred checksums, and return how many there were
+static size_t deliver(TCPConnection &from, TCPConnection &to) {
+    size_t delivered = 0;
+    while (not from.segments_out().empty()) {
+        to.segment_received(reparse_deferred(from.segments_out().front()));
+        from.segments_out().pop();
+        delivered++;
+    }
+    return delivered;
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        string data(5000, 0);
+        for (auto &c : data) {
+            c = static_cast<char>(rd());
+        }
+
+        // test 1: add_and_copy() copies the bytes and sums them like add(), with every kernel
+        for (const auto kernel :
+             {InternetChecksum::Kernel::Scalar, InternetChecksum::Kernel::SSE2, InternetChecksum::Kernel::AVX2}) {
+            if (not InternetChecksum::kernel_supported(kernel)) {
+                continue;
+            }
+            InternetChecksum::use_kernel(kernel);
+            for (unsigned i = 0; i < 500; i++) {
+                const size_t offset = rd() % 64;
+                const size_t len = rd() % (data.size() - offset);
+                const size_t split = len ? rd() % len : 0;
+                const string_view view{data.data() + offset, len};
+
+                InternetChecksum summed;
+                summed.add(view);
+                InternetChecksum copied;
+                string dest(len, 0);
+                copied.add_and_copy(view.substr(0, split), dest.data());
+                copied.add_and_copy(view.substr(split), dest.data() + split);
+                const string name = InternetChecksum::kernel_name(kernel);
+                test_err_if(dest != view, "test 1 failed: wrong copy (" + name + ")");
+                test_err_if(copied.value() != summed.value(), "test 1 failed: wrong sum (" + name + ")");
+            }
+        }
+
+        // test 2: a deferred checksum is only checked when the payload is summed
+        {
+            TCPSegment seg;
+            seg.header().seqno = WrappingInt32(rd());
+            seg.header().ack = true;
+            seg.payload() = string(data.substr(0, 1452));
+
+            TCPSegment good = reparse_deferred(seg);
+            test_err_if(not good.checksum_pending() or not good.verify_checksum() or good.checksum_pending(),
+                        "test 2 failed: correct segment rejected");
+            TCPSegment bad = reparse_deferred(seg, true);
+            test_err_if(not bad.checksum_pending() or bad.verify_checksum(), "test 2 failed: corrupt segment accepted");
+
+            string wire = seg.serialize().concatenate();
+            wire.back() ^= 0x20;
+            TCPSegment eager;
+            test_err_if(eager.parse(move(wire)) != ParseResult::BadChecksum or eager.checksum_pending(),
+                        "test 2 failed: the default parse must still check the whole segment");
+        }
+
+        // test 3: staged bytes only become readable when committed
+        {
+            ByteStream stream{16};
+            stream.write("abcd");
+            InternetChecksum check;
+            test_err_if(stream.stage("efghijklmnopqrstuvwxyz", check) != 12, "test 3 failed: wrong number staged");
+            test_err_if(stream.buffer_size() != 4, "test 3 failed: staged bytes readable before commit");
+            InternetChecksum expected;
+            expected.add("efghijklmnopqrstuvwxyz");
+            test_err_if(check.value() != expected.value(), "test 3 failed: stage() must sum all the bytes");
+            stream.commit(5);
+            test_err_if(stream.read(9) != "abcdefghi", "test 3 failed: committed bytes");
+
+            // bytes staged but never committed are overwritten by the next write
+            stream.stage("XYZ", check);
+            stream.write("jk");
+            test_err_if(stream.read(2) != "jk", "test 3 failed: uncommitted bytes became readable");
+        }
+
+        // test 4: a connection drops corrupt segments parsed with a deferred checksum, and nothing else
+        {
+            TCPConfig cfg{};
+            TCPConnection client{cfg};
+            TCPConnection server{cfg};
+            client.connect();
+            deliver(client, server);
+            deliver(server, client);
+            deliver(client, server);
+
+            client.write(data.substr(0, 3000));
+            test_err_if(client.segments_out().size() != 3, "test 4 failed: expected three segments");
+            const TCPSegment first = client.segments_out().front();
+            client.segments_out().pop();
+            const TCPSegment second = client.segments_out().front();
+            client.segments_out().pop();
+            const TCPSegment third = client.segments_out().front();
+            client.segments_out().pop();
+
+            // corrupt in-order segment: nothing changes, not even the acked window
+            server.segment_received(reparse_deferred(first, true));
+            test_err_if(server.inbound_stream().buffer_size() != 0 or not server.segments_out().empty(),
+                        "test 4 failed: corrupt in-order segment was not dropped");
+
+            // out-of-order segments are checked without being copied
+            server.segment_received(reparse_deferred(third, true));
+            test_err_if(server.unassembled_bytes() != 0, "test 4 failed: corrupt out-of-order segment kept");
+            server.segment_received(reparse_deferred(third));
+            test_err_if(server.unassembled_bytes() != 1000, "test 4 failed: out-of-order segment not kept");
+
+            server.segment_received(reparse_deferred(first));
+            server.segment_received(reparse_deferred(second));
+            test_err_if(server.inbound_stream().read(3000) != data.substr(0, 3000),
+                        "test 4 failed: wrong bytes in the inbound stream");
+            deliver(server, client);
+            test_err_if(client.bytes_in_flight() != 0, "test 4 failed: data not acknowledged");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
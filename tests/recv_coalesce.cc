@@ -0,0 +1,160 @@
+#include "tcp_config.hh"
+#include "tcp_connection.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//! move every segment `from` has queued to `to`, and return how many there were
+static size_t deliver(TCPConnection &from, TCPConnection &to) {
+    size_t delivered = 0;
+    while (not from.segments_out().empty()) {
+        to.segment_received(from.segments_out().front());
+        from.segments_out().pop();
+        delivered++;
+    }
+    return delivered;
+}
+
+static TCPSegment data_segment(const WrappingInt32 seqno, const string &data) {
+    TCPSegment seg;
+    seg.header().seqno = seqno;
+    seg.header().ack = true;
+    seg.header().ackno = WrappingInt32{12345};
+    seg.header().win = 1000;
+    seg.header().timestamps = TCPHeader::Timestamps{7, 3};
+    seg.payload() = string(data);
+    return seg;
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // test 1: coalescing the pieces of a split segment gives the segment back
+        {
+            string data(5000, 0);
+            for (auto &c : data) {
+                c = static_cast<char>(rd());
+            }
+            TCPSegment seg = data_segment(WrappingInt32(rd()), data);
+            seg.header().fin = true;
+
+            const auto merged = TCPSegment::coalesce(seg.split(1000), TCPConfig::MAX_OFFLOAD_PAYLOAD_SIZE);
+            test_err_if(merged.size() != 1, "test 1 failed: split segment was not merged into one");
+            test_err_if(not(merged[0].header() == seg.header()), "test 1 failed: merged header differs");
+            test_err_if(merged[0].payload().str() != data, "test 1 failed: merged payload differs");
+
+            const auto limited = TCPSegment::coalesce(seg.split(1000), 2000);
+            test_err_if(limited.size() != 3 or limited[0].payload().size() != 2000 or
+                            limited[2].payload().size() != 1000 or limited[1].header().fin or
+                            not limited[2].header().fin,
+                        "test 1 failed: max_payload not respected");
+        }
+
+        // test 2: runs end at a gap, a header change, a pure ack, a SYN or a FIN
+        {
+            const WrappingInt32 isn(rd());
+            vector<TCPSegment> segments;
+            segments.push_back(data_segment(isn, "aaa"));
+            segments.push_back(data_segment(isn + 3, "bbb"));
+            segments.push_back(data_segment(isn + 7, "ccc"));  // gap of one byte
+            segments.push_back(data_segment(isn + 10, "ddd"));
+            segments.back().header().win = 999;  // window update
+            segments.push_back(data_segment(isn + 13, ""));  // pure ack
+            segments.push_back(data_segment(isn + 13, "eee"));
+            segments.back().header().fin = true;
+            segments.push_back(data_segment(isn + 17, "fff"));  // after the FIN
+            segments.push_back(data_segment(isn + 20, "ggg"));
+            segments.back().header().syn = true;
+
+            const auto merged = TCPSegment::coalesce(segments, TCPConfig::MAX_OFFLOAD_PAYLOAD_SIZE);
+            const vector<string> expected{"aaabbb", "ccc", "ddd", "", "eee", "fff", "ggg"};
+            test_err_if(merged.size() != expected.size(), "test 2 failed: wrong number of merged segments");
+            for (size_t i = 0; i < expected.size(); i++) {
+                test_err_if(merged[i].payload().str() != expected[i],
+                            "test 2 failed: segment " + to_string(i) + " is \"" + merged[i].payload().copy() + "\"");
+            }
+        }
+
+        // test 3: a coalesced burst gets one ack instead of one per segment
+        for (const bool coalesce : {false, true}) {
+            TCPConfig cfg{};
+            TCPConnection client{cfg};
+            TCPConnection server{cfg};
+            client.connect();
+            deliver(client, server);
+            deliver(server, client);
+            deliver(client, server);
+
+            client.write(string(4 * TCPConfig::MAX_PAYLOAD_SIZE, 'x'));
+            vector<TCPSegment> burst;
+            while (not client.segments_out().empty()) {
+                burst.push_back(client.segments_out().front());
+                client.segments_out().pop();
+            }
+            test_err_if(burst.size() != 4, "test 3 failed: expected a burst of four segments");
+            if (coalesce) {
+                burst = TCPSegment::coalesce(move(burst), TCPConfig::MAX_OFFLOAD_PAYLOAD_SIZE);
+            }
+            for (const auto &seg : burst) {
+                server.segment_received(seg);
+            }
+
+            test_err_if(server.segments_out().size() != (coalesce ? 1 : 4), "test 3 failed: wrong number of acks");
+            test_err_if(server.inbound_stream().buffer_size() != 4 * TCPConfig::MAX_PAYLOAD_SIZE,
+                        "test 3 failed: data not received");
+            deliver(server, client);
+            test_err_if(client.bytes_in_flight() != 0, "test 3 failed: burst not acknowledged");
+        }
+
+        // test 4: with Reno, slow start grows the window as fast when each burst is coalesced and acked once
+        vector<uint64_t> separate_windows, coalesced_windows;
+        for (const bool coalesce : {false, true}) {
+            TCPConfig cfg{};
+            cfg.congestion_control = CongestionController::Algorithm::Reno;
+            TCPConnection client{cfg};
+            TCPConnection server{cfg};
+            client.connect();
+            deliver(client, server);
+            deliver(server, client);
+            deliver(client, server);
+
+            for (unsigned round = 0; round < 3; round++) {
+                client.write(string(client.remaining_outbound_capacity(), 'x'));
+                vector<TCPSegment> burst;
+                while (not client.segments_out().empty()) {
+                    burst.push_back(client.segments_out().front());
+                    client.segments_out().pop();
+                }
+                if (coalesce) {
+                    burst = TCPSegment::coalesce(move(burst), TCPConfig::MAX_OFFLOAD_PAYLOAD_SIZE);
+                }
+                for (const auto &seg : burst) {
+                    server.segment_received(seg);
+                }
+                deliver(server, client);
+                server.inbound_stream().pop_output(server.inbound_stream().buffer_size());
+                (coalesce ? coalesced_windows : separate_windows).push_back(client.sender().congestion_window());
+            }
+        }
+        // the window doubles every round trip (4, 8, 16 and 32 segments), with or without coalescing
+        test_err_if(coalesced_windows != separate_windows or
+                        coalesced_windows.back() != 32 * TCPConfig::MAX_PAYLOAD_SIZE,
+                    "test 4 failed: coalescing slowed down slow start");
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,168 @@
+#include "receiver_harness.hh"
+#include "stream_reassembler.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // SACK options survive serialize() and parse()
+        {
+            TCPHeader header;
+            header.seqno = WrappingInt32(rd());
+            header.ack = true;
+            header.sack_permitted = true;
+            header.sack_blocks = {{WrappingInt32{1000}, WrappingInt32{2000}}, {WrappingInt32{5000}, WrappingInt32{6000}}};
+            const string serialized = header.serialize();
+            if (serialized.size() != header.length() or header.length() != TCPHeader::LENGTH + 4 + 4 + 16) {
+                throw runtime_error("SACK options serialized to the wrong length");
+            }
+            NetParser p{string(serialized)};
+            TCPHeader parsed;
+            if (parsed.parse(p) != ParseResult::NoError or parsed.doff != header.length() / 4) {
+                throw runtime_error("could not parse a header with SACK options");
+            }
+            header.doff = parsed.doff;
+            if (not(parsed == header)) {
+                throw runtime_error("SACK options changed in a serialize/parse round trip");
+            }
+        }
+
+        // Unknown options are skipped, a bad option length is an error
+        {
+            TCPHeader header;
+            header.doff = 7;
+            string serialized = header.serialize();
+            serialized[20] = 2;  // MSS option
+            serialized[21] = 4;
+            serialized[24] = TCPHeader::OPT_SACK_PERMITTED;
+            serialized[25] = 2;
+            NetParser p{string(serialized)};
+            TCPHeader parsed;
+            if (parsed.parse(p) != ParseResult::NoError or not parsed.sack_permitted or p.buffer().size() != 0) {
+                throw runtime_error("unknown option not skipped");
+            }
+            serialized[21] = 40;
+            NetParser bad{string(serialized)};
+            if (parsed.parse(bad) != ParseResult::TruncatedPacket) {
+                throw runtime_error("option longer than the header was accepted");
+            }
+        }
+
+        // A segment with a malformed option or a data offset below 5 is rejected, even with a valid checksum,
+        // instead of having the unparsed option bytes taken for payload
+        {
+            const auto with_checksum = [](string segment) {
+                segment[16] = segment[17] = 0;
+                InternetChecksum check;
+                check.add(segment);
+                const uint16_t cksum = check.value();
+                segment[16] = static_cast<char>(cksum >> 8);
+                segment[17] = static_cast<char>(cksum);
+                return segment;
+            };
+            TCPHeader header;
+            header.syn = true;
+            header.doff = 7;
+            string serialized = header.serialize();
+            serialized[20] = 99;  // unknown option whose length is less than 2
+            serialized[21] = 1;
+            TCPSegment seg;
+            if (seg.parse(Buffer(with_checksum(serialized + "DATA"))) == ParseResult::NoError) {
+                throw runtime_error("segment with a malformed option was accepted");
+            }
+            serialized[21] = 9;  // longer than what is left of the options
+            if (seg.parse(Buffer(with_checksum(serialized + "DATA"))) == ParseResult::NoError) {
+                throw runtime_error("segment with an option longer than the header was accepted");
+            }
+            serialized[21] = 8;  // exactly to the end of the options
+            if (seg.parse(Buffer(with_checksum(serialized + "DATA"))) != ParseResult::NoError or
+                seg.payload().copy() != "DATA") {
+                throw runtime_error("segment with a well-formed unknown option was rejected");
+            }
+            serialized[12] = 4 << 4;  // data offset 4
+            if (seg.parse(Buffer(with_checksum(serialized + "DATA"))) != ParseResult::HeaderTooShort) {
+                throw runtime_error("segment with a data offset below 5 was accepted");
+            }
+        }
+
+        // The receiver reports out-of-order data as SACK blocks, most recent first
+        {
+            uint32_t isn = uniform_int_distribution<uint32_t>{0, UINT32_MAX}(rd);
+            TCPReceiverTestHarness test{2358};
+            test.execute(SegmentArrives{}.with_syn().with_seqno(isn).with_result(SegmentArrives::Result::OK));
+            test.execute(ExpectSackBlocks{{}});
+            test.execute(SegmentArrives{}.with_seqno(isn + 5).with_data("efgh"));
+            test.execute(ExpectSackBlocks{{{WrappingInt32{isn + 5}, WrappingInt32{isn + 9}}}});
+            test.execute(SegmentArrives{}.with_seqno(isn + 20).with_data("xyz"));
+            test.execute(ExpectSackBlocks{
+                {{WrappingInt32{isn + 20}, WrappingInt32{isn + 23}}, {WrappingInt32{isn + 5}, WrappingInt32{isn + 9}}}});
+            test.execute(SegmentArrives{}.with_seqno(isn + 9).with_data("ijkl"));
+            test.execute(ExpectSackBlocks{
+                {{WrappingInt32{isn + 5}, WrappingInt32{isn + 13}}, {WrappingInt32{isn + 20}, WrappingInt32{isn + 23}}}});
+            test.execute(SegmentArrives{}.with_seqno(isn + 1).with_data("abcd"));
+            test.execute(ExpectAckno{WrappingInt32{isn + 13}});
+            test.execute(ExpectSackBlocks{{{WrappingInt32{isn + 20}, WrappingInt32{isn + 23}}}});
+            test.execute(SegmentArrives{}.with_seqno(isn + 13).with_data("mnopqrs"));
+            test.execute(ExpectAckno{WrappingInt32{isn + 23}});
+            test.execute(ExpectSackBlocks{{}});
+        }
+
+        // The Bitmap engine finds the same ranges, also across the end of its ring
+        {
+            StreamReassembler reassembler{16, StreamReassembler::Engine::Bitmap};
+            reassembler.push_substring(string("0123456789"), 0, false);
+            reassembler.stream_out().pop_output(10);
+            reassembler.push_substring(string("abcd"), 14, false);
+            reassembler.push_substring(string("z"), 20, false);
+            const vector<pair<uint64_t, uint64_t>> expected{{20, 21}, {14, 18}};
+            if (reassembler.sack_ranges(TCPHeader::MAX_SACK_BLOCKS) != expected) {
+                throw runtime_error("Bitmap engine reported the wrong SACK ranges");
+            }
+            if (reassembler.sack_ranges(1).size() != 1) {
+                throw runtime_error("SACK ranges not limited to max_blocks");
+            }
+        }
+
+        // Substrings that add nothing (duplicates, or dropped by the memory budget) do not take the first block
+        for (const auto engine : {StreamReassembler::Engine::IntervalMap, StreamReassembler::Engine::Bitmap}) {
+            StreamReassembler reassembler{1000, engine};
+            reassembler.set_memory_budget(2 * (10 + StreamReassembler::FRAGMENT_OVERHEAD),
+                                          StreamReassembler::EvictionPolicy::RejectNew);
+            reassembler.push_substring(string(10, 'a'), 10, false);
+            reassembler.push_substring(string(10, 'b'), 30, false);
+            reassembler.push_substring(string(10, 'a'), 10, false);
+            const vector<pair<uint64_t, uint64_t>> expected{{30, 40}, {10, 20}};
+            if (reassembler.sack_ranges(TCPHeader::MAX_SACK_BLOCKS) != expected) {
+                throw runtime_error("a duplicate substring was reported as the most recent one");
+            }
+            if (engine == StreamReassembler::Engine::IntervalMap) {
+                reassembler.push_substring(string(10, 'c'), 50, false);
+                if (reassembler.sack_ranges(TCPHeader::MAX_SACK_BLOCKS) != expected) {
+                    throw runtime_error("a substring dropped by the memory budget was reported as the most recent one");
+                }
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
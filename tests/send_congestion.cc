@@ -0,0 +1,157 @@
+#include "congestion_control.hh"
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = CongestionController::Algorithm::Reno;
+
+            TCPSenderTestHarness test{"Reno slow start, timeout and congestion avoidance", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{4000});
+            test.execute(WriteBytes{string(20000, 'a')});
+            for (unsigned int i = 0; i < 4; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 1000 * i));
+            }
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{4000});
+
+            // slow start: the window grows by the bytes acknowledged, however many segments one ack covers
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 2000}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{6000});
+            for (unsigned int i = 4; i < 8; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 1000 * i));
+            }
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{6000});
+
+            // timeout: ssthresh = 3000, cwnd = 1 MSS
+            test.execute(Tick{cfg.rt_timeout});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 2000));
+            test.execute(ExpectCongestionWindow{1000});
+            test.execute(ExpectNoSegment{});
+
+            // slow start after a timeout: at most one MSS of growth per ack (RFC 3465 section 2.3)
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 8000}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{2000});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 8000));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 9000));
+            test.execute(ExpectNoSegment{});
+
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 10000}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{3000});
+            test.execute(ExpectSegment{}.with_payload_size(1000));
+            test.execute(ExpectSegment{}.with_payload_size(1000));
+            test.execute(ExpectSegment{}.with_payload_size(1000));
+            test.execute(ExpectNoSegment{});
+
+            // congestion avoidance: one MSS of growth per window of acknowledged data
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 11000}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{3000});
+            test.execute(ExpectSegment{}.with_payload_size(1000));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 13000}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{4000});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = CongestionController::Algorithm::Reno;
+
+            TCPSenderTestHarness test{"Receiver window still applies below the congestion window", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1500));
+            test.execute(WriteBytes{string(5000, 'a')});
+            test.execute(ExpectSegment{}.with_payload_size(1000));
+            test.execute(ExpectSegment{}.with_payload_size(500));
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = CongestionController::Algorithm::Cubic;
+
+            TCPSenderTestHarness test{"CUBIC cuts the window to 1 MSS on timeout", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(WriteBytes{string(20000, 'a')});
+            for (unsigned int i = 0; i < 4; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(1000));
+            }
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{cfg.rt_timeout});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1));
+            test.execute(ExpectCongestionWindow{1000});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 4000}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{2000});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.congestion_control = CongestionController::Algorithm::BBR;
+
+            TCPSenderTestHarness test{"BBR sizes the window from the measured bandwidth and RTT", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{10});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{4000});
+            test.execute(WriteBytes{string(40000, 'a')});
+            for (unsigned int i = 0; i < 4; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(1000));
+            }
+            test.execute(ExpectNoSegment{});
+            // 4000 bytes delivered in a 10 ms round trip: BDP = 4000, Startup window = 2.885 * BDP
+            test.execute(Tick{10});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 4000}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{11540});
+            test.execute(ExpectBytesInFlight{11540});
+        }
+
+        {
+            // CUBIC's growth per ack is usually a fraction of a byte: it must add up to the same as one ack for all
+            CubicController many_acks{1000}, one_ack{1000};
+            for (CubicController *cubic : {&many_acks, &one_ack}) {
+                cubic->on_ack(1000, 3000, 10, 0);
+                cubic->on_fast_retransmit(4000, 10);
+                cubic->on_recovery_exit();
+            }
+            for (unsigned int i = 0; i < 1000; i++) {
+                many_acks.on_ack(1, 3000, 10, 1000);
+            }
+            one_ack.on_ack(1000, 3000, 10, 1000);
+            if (many_acks.cwnd() + 1 < one_ack.cwnd() or many_acks.cwnd() > one_ack.cwnd() + 1) {
+                throw runtime_error("CUBIC window is " + to_string(many_acks.cwnd()) +
+                                    " after 1000 acks of a byte, but " + to_string(one_ack.cwnd()) +
+                                    " after one ack of 1000 bytes");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
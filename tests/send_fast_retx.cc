@@ -0,0 +1,136 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.fast_retransmit = true;
+
+            TCPSenderTestHarness test{"Third duplicate ack retransmits, partial ack retransmits the next hole", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(WriteBytes{string(5000, 'a')});
+            for (unsigned int i = 0; i < 5; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 1000 * i));
+            }
+            test.execute(AckReceived{WrappingInt32{isn + 1001}}.with_win(10000));
+            test.execute(AckReceived{WrappingInt32{isn + 1001}}.with_win(10000));
+            test.execute(AckReceived{WrappingInt32{isn + 1001}}.with_win(10000));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1001}}.with_win(10000));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1001));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1001}}.with_win(10000));
+            test.execute(ExpectNoSegment{});
+
+            // partial ack: the segment after it is missing as well
+            test.execute(AckReceived{WrappingInt32{isn + 3001}}.with_win(10000));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 3001));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 5001}}.with_win(10000));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{0});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.fast_retransmit = true;
+
+            TCPSenderTestHarness test{"Window updates and data-carrying acks are not duplicate acks", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(3000));
+            test.execute(WriteBytes{string(5000, 'a')});
+            test.execute(ExpectSegment{}.with_payload_size(1000));
+            test.execute(ExpectSegment{}.with_payload_size(1000));
+            test.execute(ExpectSegment{}.with_payload_size(1000));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(3001));
+            test.execute(ExpectSegment{}.with_payload_size(1));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(3002));
+            test.execute(ExpectSegment{}.with_payload_size(1));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(3002).on_data_segment());
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(3002).on_data_segment());
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(3002));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(3002));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(3002));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.fast_retransmit = true;
+            cfg.congestion_control = CongestionController::Algorithm::Reno;
+
+            TCPSenderTestHarness test{"Reno fast recovery inflates and then deflates the window", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(60000));
+            test.execute(WriteBytes{string(6000, 'a')});
+            for (unsigned int i = 0; i < 4; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(1000));
+            }
+            test.execute(AckReceived{WrappingInt32{isn + 1001}}.with_win(60000));
+            test.execute(ExpectSegment{}.with_payload_size(1000));
+            test.execute(ExpectSegment{}.with_payload_size(1000));
+            test.execute(ExpectBytesInFlight{5000});
+            for (unsigned int i = 0; i < 3; i++) {
+                test.execute(AckReceived{WrappingInt32{isn + 1001}}.with_win(60000));
+            }
+            // ssthresh = 5000 / 2, cwnd = ssthresh + 3 * MSS
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1001));
+            test.execute(ExpectCongestionWindow{5500});
+            test.execute(AckReceived{WrappingInt32{isn + 1001}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{6500});
+            test.execute(AckReceived{WrappingInt32{isn + 6001}}.with_win(60000));
+            test.execute(ExpectCongestionWindow{2500});
+            test.execute(ExpectNoSegment{});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.fast_retransmit = true;
+
+            TCPSenderTestHarness test{"No fast retransmit of data sent before a timeout", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(WriteBytes{string(3000, 'a')});
+            for (unsigned int i = 0; i < 3; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(1000));
+            }
+            test.execute(Tick{cfg.rt_timeout});
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1));
+            test.execute(AckReceived{WrappingInt32{isn + 1001}}.with_win(10000));
+            for (unsigned int i = 0; i < 3; i++) {
+                test.execute(AckReceived{WrappingInt32{isn + 1001}}.with_win(10000));
+            }
+            test.execute(ExpectNoSegment{});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,134 @@
+#include "sender_harness.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+        // serialize_segmented() produces the same wire segments as split() + serialize()
+        {
+            TCPSegment seg;
+            seg.header().seqno = WrappingInt32(rd());
+            seg.header().ack = true;
+            seg.header().ackno = WrappingInt32(rd());
+            seg.header().win = 1234;
+            seg.header().fin = true;
+            seg.header().timestamps = TCPHeader::Timestamps{static_cast<uint32_t>(rd()), 7};
+            string payload(5 * MSS + 17, 0);
+            for (auto &ch : payload) {
+                ch = static_cast<char>(rd());
+            }
+            seg.payload() = string(payload);
+
+            const uint32_t pseudo_base = 0x1234f;
+            const auto pseudo = [&](const size_t tcp_length) { return pseudo_base + tcp_length; };
+            const auto pieces = seg.serialize_segmented(MSS, pseudo);
+            const auto split = seg.split(MSS);
+            if (pieces.size() != 6 or split.size() != 6) {
+                throw runtime_error("wrong number of pieces");
+            }
+            string reassembled;
+            for (size_t i = 0; i < pieces.size(); i++) {
+                const string wire = pieces[i].concatenate();
+                if (wire != split[i].serialize(pseudo(wire.size())).concatenate()) {
+                    throw runtime_error("serialize_segmented() and split() disagree on piece " + to_string(i));
+                }
+                TCPSegment parsed;
+                if (parsed.parse(string(wire), pseudo(wire.size())) != ParseResult::NoError) {
+                    throw runtime_error("piece does not parse or has a bad checksum");
+                }
+                if (parsed.header().seqno != seg.header().seqno + reassembled.size() or
+                    parsed.header().fin != (i == pieces.size() - 1) or parsed.header().win != 1234) {
+                    throw runtime_error("wrong header on piece " + to_string(i));
+                }
+                reassembled += parsed.payload().copy();
+            }
+            if (reassembled != payload) {
+                throw runtime_error("payload not split correctly");
+            }
+        }
+
+        // the sender builds one large segment, but retransmits wire-sized ones
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.segmentation_offload = true;
+
+            TCPSenderTestHarness test{"Segmentation offload retransmits wire-sized segments", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(20 * MSS));
+            test.execute(WriteBytes{string(10 * MSS, 'a')});
+            test.execute(ExpectSegment{}
+                             .with_payload_size(10 * MSS)
+                             .with_max_payload_size(TCPConfig::MAX_OFFLOAD_PAYLOAD_SIZE)
+                             .with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{cfg.rt_timeout});
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + MSS}}.with_win(20 * MSS));
+            test.execute(ExpectBytesInFlight{9 * MSS});
+            // acking part of the large segment restarts the timer with the initial RTO
+            test.execute(Tick{cfg.rt_timeout - 1u});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + MSS));
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 10 * MSS}}.with_win(20 * MSS));
+            test.execute(ExpectBytesInFlight{0});
+        }
+
+        // SACK blocks inside a large segment split it, so that only the holes are resent
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.segmentation_offload = true;
+            cfg.fast_retransmit = true;
+
+            TCPSenderTestHarness test{"SACK recovery inside a large segment", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(20 * MSS));
+            test.execute(WriteBytes{string(5 * MSS, 'a')});
+            test.execute(ExpectSegment{}
+                             .with_payload_size(5 * MSS)
+                             .with_max_payload_size(TCPConfig::MAX_OFFLOAD_PAYLOAD_SIZE)
+                             .with_seqno(isn + 1));
+            // the first and the third wire segment are lost
+            for (unsigned int i = 0; i < 3; i++) {
+                test.execute(AckReceived{WrappingInt32{isn + 1}}
+                                 .with_win(20 * MSS)
+                                 .with_sack(isn + 1 + 3 * MSS, isn + 1 + 5 * MSS)
+                                 .with_sack(isn + 1 + MSS, isn + 1 + 2 * MSS));
+            }
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}
+                             .with_win(20 * MSS)
+                             .with_sack(isn + 1 + 3 * MSS, isn + 1 + 5 * MSS)
+                             .with_sack(isn + 1 + MSS, isn + 1 + 2 * MSS));
+            test.execute(ExpectSegment{}.with_payload_size(MSS).with_seqno(isn + 1 + 2 * MSS));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1 + 5 * MSS}}.with_win(20 * MSS));
+            test.execute(ExpectBytesInFlight{0});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
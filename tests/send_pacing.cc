@@ -0,0 +1,124 @@
+#include "tcp_config.hh"
+#include "tcp_sender.hh"
+#include "util.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+//! pop everything the sender queued and return how many payload bytes it carried
+static size_t drain(TCPSender &sender) {
+    size_t bytes = 0;
+    while (not sender.segments_out().empty()) {
+        bytes += sender.segments_out().front().payload().size();
+        sender.segments_out().pop();
+    }
+    return bytes;
+}
+
+//! let `ms` pass and give the sender a chance to send, as TCPConnection::tick() does
+static size_t tick(TCPSender &sender, const size_t ms) {
+    sender.tick(ms);
+    sender.fill_window();
+    return drain(sender);
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        constexpr size_t MSS = TCPConfig::MAX_PAYLOAD_SIZE;
+
+        // a fixed rate of one segment per millisecond, with bursts of at most two segments
+        {
+            TCPConfig cfg;
+            const WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.pacing = true;
+            cfg.pacing_rate = 1000 * MSS;
+            TCPSender sender{cfg};
+            sender.fill_window();
+            drain(sender);
+            sender.ack_received(isn + 1, 20 * MSS);
+
+            sender.stream_in().write(string(10 * MSS, 'x'));
+            sender.fill_window();
+            if (drain(sender) != 2 * MSS or sender.pacing_rate() != 1000 * MSS) {
+                throw runtime_error("the first burst must be limited to two segments");
+            }
+            if (sender.time_until_next_send() != optional<uint64_t>{1}) {
+                throw runtime_error("next send time not reported");
+            }
+            if (tick(sender, 1) != MSS) {
+                throw runtime_error("one segment per millisecond expected");
+            }
+            if (tick(sender, 10) != 2 * MSS) {
+                throw runtime_error("an idle pacer must not save up more than two segments");
+            }
+            size_t sent = 5 * MSS;
+            for (unsigned int i = 0; i < 6; i++) {
+                sent += tick(sender, 1);
+            }
+            if (sent != 10 * MSS or sender.bytes_in_flight() != 10 * MSS or sender.time_until_next_send().has_value()) {
+                throw runtime_error("all data should have been sent");
+            }
+        }
+
+        // the rate is derived from the window and SRTT once an RTT has been measured
+        {
+            TCPConfig cfg;
+            const WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.pacing = true;
+            TCPSender sender{cfg};
+            sender.fill_window();
+            drain(sender);
+            sender.tick(100);
+            sender.ack_received(isn + 1, 10 * MSS);
+
+            // no congestion control: 1.2 * 10000 bytes / 100 ms = 120 bytes per millisecond
+            sender.stream_in().write(string(5 * MSS, 'x'));
+            sender.fill_window();
+            if (drain(sender) != 2 * MSS or sender.pacing_rate() != 120000) {
+                throw runtime_error("rate not derived from the window and SRTT");
+            }
+            if (tick(sender, 1) != MSS) {
+                throw runtime_error("tokens of the first millisecond should allow one segment");
+            }
+            // 880 bytes in debt at 120 bytes/ms: 8 ms until the next segment
+            if (sender.time_until_next_send() != optional<uint64_t>{8}) {
+                throw runtime_error("wrong next send time");
+            }
+            if (tick(sender, 7) != 0 or tick(sender, 1) != MSS) {
+                throw runtime_error("segment not sent at the next send time");
+            }
+        }
+
+        // without pacing the whole window goes out at once
+        {
+            TCPConfig cfg;
+            const WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            TCPSender sender{cfg};
+            sender.fill_window();
+            drain(sender);
+            sender.ack_received(isn + 1, 10 * MSS);
+            sender.stream_in().write(string(10 * MSS, 'x'));
+            sender.fill_window();
+            if (drain(sender) != 10 * MSS or sender.time_until_next_send().has_value()) {
+                throw runtime_error("unpaced sender held data back");
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,103 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            Timer timer;
+            if (timer.rtt_measured() or timer.estimated_rto() != 0) {
+                throw runtime_error("Timer reported an RTT estimate before any sample");
+            }
+            timer.rtt_sample(100);
+            if (timer.srtt() != 100 or timer.rttvar() != 50 or timer.estimated_rto() != 300) {
+                throw runtime_error("first RTT sample should set SRTT = R, RTTVAR = R/2, RTO = 3R");
+            }
+            timer.rtt_sample(200);
+            if (timer.srtt() != 112.5 or timer.rttvar() != 62.5 or timer.estimated_rto() != 363) {
+                throw runtime_error("second RTT sample not folded in as RFC 6298 specifies");
+            }
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.adaptive_rt_timeout = true;
+            cfg.min_rt_timeout = 1;
+
+            TCPSenderTestHarness test{"RTO follows the measured RTT", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{100});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            // SRTT = 100, RTTVAR = 50: RTO = 300
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_data("abc"));
+            test.execute(Tick{299});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_data("abc"));
+
+            // Karn's rule: the ack of a retransmitted segment does not produce an RTT sample
+            test.execute(Tick{500});
+            test.execute(AckReceived{WrappingInt32{isn + 4}}.with_win(1000));
+            test.execute(WriteBytes{"def"});
+            test.execute(ExpectSegment{}.with_data("def"));
+            test.execute(Tick{299});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_data("def"));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.adaptive_rt_timeout = true;
+
+            TCPSenderTestHarness test{"Adaptive RTO is bounded below", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{2});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_data("abc"));
+            test.execute(Tick{TCPConfig::MIN_TIMEOUT_DFLT - 1u});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_data("abc"));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+
+            TCPSenderTestHarness test{"Without adaptive RTO the initial timeout is kept", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{100});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(WriteBytes{"abc"});
+            test.execute(ExpectSegment{}.with_data("abc"));
+            test.execute(Tick{cfg.rt_timeout - 1u});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_data("abc"));
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
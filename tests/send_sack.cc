@@ -0,0 +1,94 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.fast_retransmit = true;
+
+            TCPSenderTestHarness test{"SACK recovery resends only the holes", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(WriteBytes{string(5000, 'a')});
+            for (unsigned int i = 0; i < 5; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1 + 1000 * i));
+            }
+            // the first and the third segment are lost
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000).with_sack(isn + 1001, isn + 2001));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}
+                             .with_win(10000)
+                             .with_sack(isn + 3001, isn + 4001)
+                             .with_sack(isn + 1001, isn + 2001));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}
+                             .with_win(10000)
+                             .with_sack(isn + 3001, isn + 5001)
+                             .with_sack(isn + 1001, isn + 2001));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1));
+            test.execute(ExpectNoSegment{});
+            // the next duplicate ack resends the other hole, and nothing that was SACKed
+            test.execute(AckReceived{WrappingInt32{isn + 1}}
+                             .with_win(10000)
+                             .with_sack(isn + 3001, isn + 5001)
+                             .with_sack(isn + 1001, isn + 2001));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 2001));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}
+                             .with_win(10000)
+                             .with_sack(isn + 3001, isn + 5001)
+                             .with_sack(isn + 1001, isn + 2001));
+            test.execute(ExpectNoSegment{});
+            // partial ack: the hole after it has been resent already
+            test.execute(AckReceived{WrappingInt32{isn + 2001}}.with_win(10000).with_sack(isn + 3001, isn + 5001));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 5001}}.with_win(10000));
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{0});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.fast_retransmit = true;
+
+            TCPSenderTestHarness test{"Impossible SACK blocks are ignored", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000));
+            test.execute(WriteBytes{string(3000, 'a')});
+            for (unsigned int i = 0; i < 3; i++) {
+                test.execute(ExpectSegment{}.with_payload_size(1000));
+            }
+            for (unsigned int i = 0; i < 3; i++) {
+                test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000).with_sack(isn + 2001, isn + 9001));
+            }
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1));
+            // no SACK information: NewReno resends one segment per partial ack
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(10000).with_sack(isn + 2001, isn + 9001));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1001}}.with_win(10000));
+            test.execute(ExpectSegment{}.with_payload_size(1000).with_seqno(isn + 1001));
+            test.execute(ExpectNoSegment{});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
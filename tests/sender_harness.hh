@@ -15,6 +15,7 @@
 #include <optional>
 #include <sstream>
 #include <string>
+#include <vector>
 
 const unsigned int DEFAULT_TEST_WINDOW = 137;
 
@@ -99,6 +100,22 @@ struct ExpectBytesInFlight : public SenderExpectation {
     }
 };
 
+struct ExpectCongestionWindow : public SenderExpectation {
+    uint64_t _cwnd;
+
+    ExpectCongestionWindow(uint64_t cwnd) : _cwnd(cwnd) {}
+    std::string description() const { return "congestion window of " + std::to_string(_cwnd) + " bytes"; }
+
+    void execute(TCPSender &sender, std::queue<TCPSegment> &) const {
+        if (sender.congestion_window() != _cwnd) {
+            std::ostringstream ss;
+            ss << "The TCPSender reported a congestion window of " << sender.congestion_window()
+               << " bytes, but it was expected to be " << _cwnd << " bytes";
+            throw SenderExpectationViolation(ss.str());
+        }
+    }
+};
+
 struct ExpectNoSegment : public SenderExpectation {
     ExpectNoSegment() {}
     std::string description() const { return "no (more) segments"; }
@@ -190,22 +207,43 @@ struct Tick : public SenderAction {
 
 struct AckReceived : public SenderAction {
     WrappingInt32 _ackno;
-    std::optional<uint16_t> _window_advertisement{};
+    std::optional<uint64_t> _window_advertisement{};
+    bool _on_data_segment{false};
+    std::vector<TCPHeader::SACKBlock> _sack_blocks{};
 
     AckReceived(WrappingInt32 ackno) : _ackno(ackno) {}
     std::string description() const {
         std::ostringstream ss;
         ss << "ack " << _ackno.raw_value() << " winsize " << _window_advertisement.value_or(DEFAULT_TEST_WINDOW);
+        for (const auto &[left, right] : _sack_blocks) {
+            ss << " sack " << left.raw_value() << "-" << right.raw_value();
+        }
+        if (_on_data_segment) {
+            ss << " (on a segment carrying data)";
+        }
         return ss.str();
     }
 
-    AckReceived &with_win(uint16_t win) {
+    AckReceived &with_sack(WrappingInt32 left, WrappingInt32 right) {
+        _sack_blocks.emplace_back(left, right);
+        return *this;
+    }
+
+    AckReceived &with_win(uint64_t win) {
         _window_advertisement.emplace(win);
         return *this;
     }
 
+    AckReceived &on_data_segment() {
+        _on_data_segment = true;
+        return *this;
+    }
+
     void execute(TCPSender &sender, std::queue<TCPSegment> &) const {
-        sender.ack_received(_ackno, _window_advertisement.value_or(DEFAULT_TEST_WINDOW));
+        if (not _sack_blocks.empty()) {
+            sender.sack_received(_sack_blocks);
+        }
+        sender.ack_received(_ackno, _window_advertisement.value_or(DEFAULT_TEST_WINDOW), not _on_data_segment);
         sender.fill_window();
     }
 };
@@ -230,6 +268,7 @@ struct ExpectSegment : public SenderExpectation {
     std::optional<uint16_t> win{};
     std::optional<size_t> payload_size{};
     std::optional<std::string> data{};
+    size_t max_payload_size{TCPConfig::MAX_PAYLOAD_SIZE};
 
     ExpectSegment &with_ack(bool ack_) {
         ack = ack_;
@@ -283,6 +322,11 @@ struct ExpectSegment : public SenderExpectation {
         return *this;
     }
 
+    ExpectSegment &with_max_payload_size(size_t max_payload_size_) {
+        max_payload_size = max_payload_size_;
+        return *this;
+    }
+
     ExpectSegment &with_data(std::string data_) {
         data = data_;
         return *this;
@@ -367,7 +411,7 @@ struct ExpectSegment : public SenderExpectation {
             throw SegmentExpectationViolation::violated_field(
                 "payload_size", payload_size.value(), seg.payload().size());
         }
-        if (seg.payload().size() > TCPConfig::MAX_PAYLOAD_SIZE) {
+        if (seg.payload().size() > max_payload_size) {
             throw SegmentExpectationViolation("packet has length (" + std::to_string(seg.payload().size()) +
                                               ") greater than the maximum");
         }
@@ -394,7 +438,7 @@ class TCPSenderTestHarness {
   public:
     TCPSenderTestHarness(const std::string &name_, TCPConfig config)
         : outbound_segments()
-        , sender(config.send_capacity, config.rt_timeout, config.fixed_isn)
+        , sender(config)
         , steps_executed()
         , name(name_) {
         sender.fill_window();
@@ -0,0 +1,99 @@
+#include "ethernet_frame.hh"
+#include "ipv4_datagram.hh"
+#include "network_interface.hh"
+#include "parser.hh"
+#include "tcp_segment.hh"
+#include "test_err_if.hh"
+#include "util.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+//! does the last Buffer of `buffers` share storage with `payload`, i.e. was the payload not copied?
+static bool references(const BufferList &buffers, const Buffer &payload) {
+    return not buffers.buffers().empty() and buffers.buffers().back().str().data() == payload.str().data();
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        string data(1000, 0);
+        for (auto &c : data) {
+            c = static_cast<char>(rd());
+        }
+
+        TCPSegment seg;
+        seg.header().seqno = WrappingInt32(rd());
+        seg.header().ack = true;
+        seg.header().ackno = WrappingInt32(rd());
+        seg.header().win = 4321;
+        seg.header().timestamps = TCPHeader::Timestamps{static_cast<uint32_t>(rd()), static_cast<uint32_t>(rd())};
+        seg.payload() = string(data);
+
+        InternetDatagram dgram;
+        dgram.header().src = Address("10.0.0.1", 0).ipv4_numeric();
+        dgram.header().dst = Address("10.0.0.2", 0).ipv4_numeric();
+
+        // test 1: the serialized segment is a header plus the payload in place, with a valid checksum
+        const BufferList wire_seg = seg.serialize(dgram.header().pseudo_cksum());
+        test_err_if(wire_seg.buffers().size() != 2 or not references(wire_seg, seg.payload()),
+                    "test 1 failed: segment payload was copied");
+        TCPSegment parsed_seg;
+        test_err_if(parsed_seg.parse(wire_seg.concatenate(), dgram.header().pseudo_cksum()) != ParseResult::NoError,
+                    "test 1 failed: serialized segment does not parse");
+        test_err_if(not(parsed_seg.header().ackno == seg.header().ackno) or parsed_seg.payload().str() != data,
+                    "test 1 failed: segment changed in a serialize/parse round trip");
+
+        // test 2: the same holds one layer down, with the IPv4 header checksum filled in
+        dgram.payload() = wire_seg;
+        dgram.header().len = dgram.header().hlen * 4 + dgram.payload().size();
+        const BufferList wire_dgram = dgram.serialize();
+        test_err_if(wire_dgram.buffers().size() != 3 or not references(wire_dgram, seg.payload()),
+                    "test 2 failed: datagram payload was copied");
+        InternetChecksum ip_check;
+        ip_check.add(wire_dgram.buffers().front());
+        test_err_if(ip_check.value() != 0, "test 2 failed: wrong IPv4 header checksum");
+
+        // test 3: the NetworkInterface puts the datagram in a frame without flattening it,
+        // and a frame built that way is received like a parsed one
+        {
+            const EthernetAddress eth_a{2, 0, 0, 0, 0, 1};
+            const EthernetAddress eth_b{2, 0, 0, 0, 0, 2};
+            NetworkInterface a{eth_a, Address("10.0.0.1", 0)};
+            NetworkInterface b{eth_b, Address("10.0.0.2", 0)};
+
+            a.send_datagram(dgram, Address("10.0.0.2", 0));
+            test_err_if(a.frames_out().size() != 1, "test 3 failed: no ARP request");
+            b.recv_frame(a.frames_out().front());
+            a.frames_out().pop();
+            test_err_if(b.frames_out().size() != 1, "test 3 failed: no ARP reply");
+            a.recv_frame(b.frames_out().front());
+            b.frames_out().pop();
+            test_err_if(a.frames_out().size() != 1, "test 3 failed: datagram not sent after the ARP reply");
+
+            const EthernetFrame &frame = a.frames_out().front();
+            test_err_if(not references(frame.payload(), seg.payload()), "test 3 failed: frame payload was copied");
+            const auto received = b.recv_frame(frame);
+            test_err_if(not received.has_value(), "test 3 failed: frame not received");
+            test_err_if(received->payload().concatenate() != wire_seg.concatenate(),
+                        "test 3 failed: datagram changed on the way");
+
+            EthernetFrame reparsed;
+            test_err_if(reparsed.parse(frame.serialize().concatenate()) != ParseResult::NoError,
+                        "test 3 failed: serialized frame does not parse");
+            test_err_if(reparsed.payload().concatenate() != frame.payload().concatenate(),
+                        "test 3 failed: frame changed in a serialize/parse round trip");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,50 @@
+#include "util.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        uniform_int_distribution<uint32_t> dist32{0, numeric_limits<uint32_t>::max()};
+        uniform_int_distribution<uint64_t> dist63{0, uint64_t{1} << 63};
+        uniform_int_distribution<size_t> dist_count{0, 100};
+
+        for (unsigned int i = 0; i < 10000; i++) {
+            const WrappingInt32 isn{dist32(rd)};
+            // small checkpoints exercise the values that would unwrap below zero
+            const uint64_t checkpoint = i % 2 ? dist63(rd) : dist32(rd) % 4;
+
+            vector<WrappingInt32> seqnos;
+            const size_t count = dist_count(rd);
+            for (size_t j = 0; j < count; j++) {
+                seqnos.emplace_back(dist32(rd));
+            }
+            // exactly 2^31 away in either direction
+            seqnos.push_back(wrap(checkpoint, isn) + (uint32_t{1} << 31));
+
+            vector<uint64_t> out(seqnos.size());
+            unwrap_n(seqnos.data(), seqnos.size(), isn, checkpoint, out.data());
+            for (size_t j = 0; j < seqnos.size(); j++) {
+                if (out[j] != unwrap(seqnos[j], isn, checkpoint)) {
+                    ostringstream ss;
+                    ss << "unwrap_n disagrees with unwrap for n = " << seqnos[j] << ", isn = " << isn
+                       << ", checkpoint = " << checkpoint << ": " << out[j]
+                       << " != " << unwrap(seqnos[j], isn, checkpoint);
+                    throw runtime_error(ss.str());
+                }
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}